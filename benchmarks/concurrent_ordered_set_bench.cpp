@@ -0,0 +1,125 @@
+/*
+Threads sharing one set of ints, each doing a mix of lookups and changes on
+random keys: a wheel::ordered_set with a std::shared_mutex around it (shared
+for contains, exclusive for insert and erase) against
+wheel::concurrent_ordered_set.  The set starts half full of keys from a
+range of 2^20, and changes are half inserts, half erases, so it stays about
+that size.  Read/write mixes of 90/10 and 50/50 at 1, 2, 4 ... threads.
+
+usage: concurrent_ordered_set_bench [threads] [operations]   (default cores, 4000000)
+*/
+#include "concurrent_ordered_set.hpp"
+#include "ordered_set.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+using namespace wheel;
+
+constexpr std::uint32_t key_range = 1 << 20;
+
+// an ordered_set, readers share the lock, writers take it alone
+class locked_set {
+public:
+	bool contains(int key) const {
+		std::shared_lock<std::shared_mutex> lock(lock_);
+		return keys_.find(key) != keys_.end();
+	}
+
+	void insert(int key) {
+		std::unique_lock<std::shared_mutex> lock(lock_);
+		keys_.insert(key);
+	}
+
+	void erase(int key) {
+		std::unique_lock<std::shared_mutex> lock(lock_);
+		keys_.erase(key);
+	}
+
+private:
+	mutable std::shared_mutex lock_;
+	ordered_set<int> keys_;
+};
+
+static std::uint32_t xorshift(std::uint32_t& state) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+// million operations a second, total operations split between the threads,
+// writes out of every 100 are inserts or erases
+template< typename Set >
+static double mops(Set& set, int threads, size_t total, unsigned writes) {
+	std::vector<std::thread> workers;
+	std::vector<size_t> found(threads);
+	auto start = std::chrono::steady_clock::now();
+	for (int t = 0; t < threads; ++t) {
+		workers.emplace_back([&, t] {
+			std::uint32_t state = 2463534242u + t * 7919u;
+			size_t hits = 0;
+			for (size_t i = total / threads; i > 0; --i) {
+				std::uint32_t r = xorshift(state);
+				int key = static_cast<int>(r % key_range);
+				unsigned roll = (r >> 20) % 100;
+				if (roll >= writes) {
+					hits += set.contains(key);
+				}
+				else if (roll % 2) {
+					set.insert(key);
+				}
+				else {
+					set.erase(key);
+				}
+			}
+			found[t] = hits;
+		});
+	}
+	for (auto& w : workers) {
+		w.join();
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return total / seconds / 1e6;
+}
+
+template< typename Set >
+static void fill(Set& set) {
+	for (std::uint32_t key = 0; key < key_range; key += 2) {
+		set.insert(static_cast<int>(key));
+	}
+}
+
+int main(int argc, char* argv[]) {
+
+	unsigned cores = std::thread::hardware_concurrency();
+	int most = argc > 1 ? std::atoi(argv[1]) : static_cast<int>(cores ? cores : 4);
+	size_t total = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4000000;
+
+	std::printf("%zu operations on a set of ints (million operations/s)\n", total);
+	for (unsigned writes : { 10u, 50u }) {
+		std::printf("\n%u%% reads, %u%% writes\n", 100 - writes, writes);
+		std::printf("%8s %12s %12s\n", "threads", "locked set", "concurrent");
+		for (int threads = 1; threads <= most; threads *= 2) {
+			locked_set locked;
+			fill(locked);
+			double locked_rate = mops(locked, threads, total, writes);
+
+			concurrent_ordered_set<int> concurrent;
+			fill(concurrent);
+			double concurrent_rate = mops(concurrent, threads, total, writes);
+
+			std::printf("%8d %12.2f %12.2f\n", threads, locked_rate, concurrent_rate);
+			if (threads < most && threads * 2 > most) {
+				threads = most / 2;   // finish on most itself
+			}
+		}
+	}
+	return 0;
+}
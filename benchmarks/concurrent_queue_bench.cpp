@@ -0,0 +1,151 @@
+/*
+Handing ints from producer threads to consumer threads: a wheel::list with a
+mutex around push_back and pop_front, against wheel::concurrent_queue one
+value at a time and in batches of 32, at 1, 2 and 4 threads a side.  Every
+thread spins (yielding) when the queue is full or empty.
+
+usage: concurrent_queue_bench [values]   (default 10000000)
+*/
+#include "concurrent_queue.hpp"
+#include "list.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace wheel;
+
+constexpr size_t batch = 32;
+
+// a wheel::list as the queue, one lock for both ends
+class locked_list {
+public:
+	bool try_push(int value) {
+		std::lock_guard<std::mutex> lock(lock_);
+		values_.push_back(value);
+		return true;
+	}
+
+	bool try_pop(int& out) {
+		std::lock_guard<std::mutex> lock(lock_);
+		if (values_.empty()) {
+			return false;
+		}
+		out = values_.front();
+		values_.pop_front();
+		return true;
+	}
+
+private:
+	std::mutex lock_;
+	list<int> values_;
+};
+
+// million values a second through the queue, total values split between the
+// producers
+template< typename Push, typename Pop >
+static double mops(size_t total, int producers, int consumers, Push push, Pop pop) {
+	std::atomic<size_t> received(0);
+	std::atomic<long long> sum(0);
+	std::vector<std::thread> threads;
+	auto start = std::chrono::steady_clock::now();
+
+	for (int p = 0; p < producers; ++p) {
+		size_t first = total * p / producers;
+		size_t last = total * (p + 1) / producers;
+		threads.emplace_back([=] {
+			for (size_t i = first; i < last; ) {
+				size_t pushed = push(i, last);
+				if (pushed == 0) {
+					std::this_thread::yield();
+				}
+				i += pushed;
+			}
+		});
+	}
+	for (int c = 0; c < consumers; ++c) {
+		threads.emplace_back([&] {
+			long long mine = 0;
+			while (received.load(std::memory_order_relaxed) < total) {
+				size_t got = pop(mine);
+				if (got == 0) {
+					std::this_thread::yield();
+				}
+				received += got;
+			}
+			sum += mine;
+		});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	long long n = static_cast<long long>(total);
+	if (sum.load() != n * (n - 1) / 2) {
+		std::printf("lost values!\n");
+	}
+	return total / seconds / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+
+	size_t total = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+
+	std::printf("%zu ints from producers to consumers (million values/s)\n", total);
+	std::printf("%9s %12s %12s %12s\n", "threads", "locked list", "queue", "queue batch");
+
+	for (int threads : { 1, 2, 4 }) {
+		locked_list locked;
+		double list_rate = mops(total, threads, threads,
+			[&](size_t i, size_t) { return locked.try_push(static_cast<int>(i)) ? size_t(1) : 0; },
+			[&](long long& sum) {
+				int value;
+				if (!locked.try_pop(value)) {
+					return size_t(0);
+				}
+				sum += value;
+				return size_t(1);
+			});
+
+		concurrent_queue<int> queue(1 << 16);
+		double queue_rate = mops(total, threads, threads,
+			[&](size_t i, size_t) { return queue.try_push(static_cast<int>(i)) ? size_t(1) : 0; },
+			[&](long long& sum) {
+				int value;
+				if (!queue.try_pop(value)) {
+					return size_t(0);
+				}
+				sum += value;
+				return size_t(1);
+			});
+
+		concurrent_queue<int> batched(1 << 16);
+		double batch_rate = mops(total, threads, threads,
+			[&](size_t i, size_t last) {
+				int values[batch];
+				size_t count = std::min(batch, last - i);
+				for (size_t k = 0; k < count; ++k) {
+					values[k] = static_cast<int>(i + k);
+				}
+				return batched.try_push_batch(values, values + count);
+			},
+			[&](long long& sum) {
+				int values[batch];
+				size_t got = batched.try_pop_batch(values, batch);
+				for (size_t k = 0; k < got; ++k) {
+					sum += values[k];
+				}
+				return got;
+			});
+
+		std::printf("%4d x %-2d %12.1f %12.1f %12.1f\n", threads, threads, list_rate, queue_rate, batch_rate);
+	}
+	return 0;
+}
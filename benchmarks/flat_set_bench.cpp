@@ -0,0 +1,100 @@
+/*
+wheel::flat_set against wheel::ordered_set (red-black tree and btree
+backends) for a read-mostly set of random ints: building it from an unsorted
+batch, random finds, and a full in-order scan, at 1 thousand up to 10
+million elements.
+
+usage: flat_set_bench [largest]   (default 10000000)
+*/
+#include "flat_set.hpp"
+#include "ordered_set.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace wheel;
+
+using rb_set = ordered_set<int>;
+using b_set = ordered_set<int, std::less<int>, std::allocator<int>, btree_backend<>>;
+
+struct result {
+	double build_mops;
+	double find_mops;
+	double scan_mops;
+};
+
+static double mops(size_t operations, std::chrono::steady_clock::time_point start) {
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return operations / seconds / 1e6;
+}
+
+// every measurement does at least about a million operations, so small
+// sets are built, searched and scanned repeatedly
+template< typename Set >
+static result measure(const std::vector<int>& keys, const std::vector<int>& queries) {
+	size_t rounds = std::max<size_t>(1, 1000000 / keys.size());
+	size_t check = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (size_t r = 1; r < rounds; ++r) {
+		Set warmup(keys.begin(), keys.end());
+		check += warmup.size();
+	}
+	Set myset(keys.begin(), keys.end());
+	double build = mops(keys.size() * rounds, start);
+
+	start = std::chrono::steady_clock::now();
+	for (size_t r = 0; r < rounds; ++r) {
+		for (int q : queries) {
+			check += myset.find(q) != myset.end();
+		}
+	}
+	double find = mops(queries.size() * rounds, start);
+
+	start = std::chrono::steady_clock::now();
+	for (size_t r = 0; r < rounds; ++r) {
+		for (int k : myset) {
+			check += k;
+		}
+	}
+	double scan = mops(myset.size() * rounds, start);
+
+	if (check == 0) {
+		std::printf("nothing\n");
+	}
+	return { build, find, scan };
+}
+
+int main(int argc, char* argv[]) {
+
+	size_t largest = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+
+	std::printf("random ints (million operations/s)\n");
+	std::printf("%10s  %-10s %10s %10s %10s\n", "elements", "set", "build", "find", "scan");
+
+	for (size_t count : { 1000, 100000, 1000000, 10000000 }) {
+		if (count > largest) {
+			break;
+		}
+		std::vector<int> keys(count);
+		std::iota(keys.begin(), keys.end(), 0);
+		std::mt19937 rng(42);
+		std::shuffle(keys.begin(), keys.end(), rng);
+		std::vector<int> queries(keys);
+		std::shuffle(queries.begin(), queries.end(), rng);
+
+		result flat = measure<flat_set<int>>(keys, queries);
+		result rb = measure<rb_set>(keys, queries);
+		result b = measure<b_set>(keys, queries);
+
+		std::printf("%10zu  %-10s %10.2f %10.2f %10.2f\n", count, "flat_set", flat.build_mops, flat.find_mops, flat.scan_mops);
+		std::printf("%10zu  %-10s %10.2f %10.2f %10.2f\n", count, "rb_tree", rb.build_mops, rb.find_mops, rb.scan_mops);
+		std::printf("%10zu  %-10s %10.2f %10.2f %10.2f\n", count, "btree", b.build_mops, b.find_mops, b.scan_mops);
+	}
+}
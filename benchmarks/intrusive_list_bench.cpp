@@ -0,0 +1,83 @@
+/*
+Objects that live in a pool (a std::vector), passed round a ring of queues:
+each step takes the object at the front of one queue and puts it on the back
+of the next, as a scheduler moves jobs between run queues.  Three ways to
+hold the queues:
+1. wheel::list<job> - each move copies the 64 byte job into a new node
+2. wheel::list<job*> - a node per move, pointing into the pool
+3. wheel::intrusive_list<job, &job::queued> - the links are in the job
+Every way touches the job on each move, as a scheduler would.
+
+usage: intrusive_list_bench [jobs] [moves]   (default 100000, 10000000)
+*/
+#include "intrusive_list.hpp"
+#include "list.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace wheel;
+
+constexpr size_t queues = 4;
+
+struct job {
+	long long id = 0;
+	long long runs = 0;
+	char payload[32] = {};
+	intrusive_list_hook<job> queued;
+};
+
+static_assert(sizeof(job) == 64, "a job is a cache line");
+
+// million moves a second
+template< typename Queue, typename Take, typename Put >
+static double mops(std::vector<job>& pool, size_t moves, Take take, Put put) {
+	std::vector<Queue> ring(queues);
+	for (size_t i = 0; i < pool.size(); ++i) {
+		put(ring[i % queues], pool[i]);
+	}
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < moves; ++i) {
+		Queue& from = ring[i % queues];
+		job& j = take(from);
+		++j.runs;
+		put(ring[(i + 1) % queues], j);
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return moves / seconds / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+
+	size_t jobs = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+	size_t moves = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000000;
+
+	std::vector<job> pool(jobs);
+	for (size_t i = 0; i < jobs; ++i) {
+		pool[i].id = static_cast<long long>(i);
+	}
+
+	// a copy lives in the list, so take hands back a reference to a spare
+	// job the front is copied into
+	job spare;
+	double copied = mops<list<job>>(pool, moves,
+		[&](list<job>& q) -> job& { spare = q.front(); q.pop_front(); return spare; },
+		[](list<job>& q, job& j) { q.push_back(j); });
+
+	double pointed = mops<list<job*>>(pool, moves,
+		[](list<job*>& q) -> job& { job* j = q.front(); q.pop_front(); return *j; },
+		[](list<job*>& q, job& j) { q.push_back(&j); });
+
+	using run_queue = intrusive_list<job, &job::queued>;
+	double intrusive = mops<run_queue>(pool, moves,
+		[](run_queue& q) -> job& { job& j = q.front(); q.pop_front(); return j; },
+		[](run_queue& q, job& j) { q.push_back(j); });
+
+	std::printf("%zu moves of %zu jobs round %zu queues (million moves/s)\n", moves, jobs, queues);
+	std::printf("  list<job>         %8.2f\n", copied);
+	std::printf("  list<job*>        %8.2f\n", pointed);
+	std::printf("  intrusive_list    %8.2f\n", intrusive);
+	return 0;
+}
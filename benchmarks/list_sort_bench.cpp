@@ -0,0 +1,65 @@
+/*
+Sorting a wheel::list of ints three ways:
+1. copying the values into a std::vector, std::sort, and building a new list
+2. list::sort, which relinks the nodes where they are
+3. std::list::sort, for reference
+for random and already sorted input.  The lists are built by push_back
+before each timing, so the nodes start in address order.
+
+usage: list_sort_bench [elements]   (default 1000000)
+*/
+#include "list.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace wheel;
+
+template< typename F >
+static double milliseconds(F&& f) {
+	auto start = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void run(const char* name, const std::vector<int>& input) {
+	list<int> rebuilt(input.begin(), input.end());
+	double rebuild_ms = milliseconds([&] {
+		std::vector<int> values(rebuilt.begin(), rebuilt.end());
+		std::sort(values.begin(), values.end());
+		rebuilt = list<int>(values.begin(), values.end());
+	});
+
+	list<int> relinked(input.begin(), input.end());
+	double relink_ms = milliseconds([&] { relinked.sort(); });
+
+	std::list<int> standard(input.begin(), input.end());
+	double standard_ms = milliseconds([&] { standard.sort(); });
+
+	if (!(rebuilt == relinked)) {
+		std::printf("sorts disagree!\n");
+	}
+	std::printf("%-8s %14.1f %14.1f %14.1f\n", name, rebuild_ms, relink_ms, standard_ms);
+}
+
+int main(int argc, char* argv[]) {
+
+	size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+	std::vector<int> sorted(count);
+	std::iota(sorted.begin(), sorted.end(), 0);
+	std::vector<int> random = sorted;
+	std::shuffle(random.begin(), random.end(), std::mt19937(42));
+
+	std::printf("sorting %zu ints (ms)\n", count);
+	std::printf("%-8s %14s %14s %14s\n", "", "vector+rebuild", "list::sort", "std::list");
+	run("random", random);
+	run("sorted", sorted);
+	return 0;
+}
@@ -0,0 +1,90 @@
+/*
+Walking a wheel::list of ints whose nodes are scattered through memory, as
+after a long run of inserts and erases:
+1. the list as built by push_back - nodes in address order
+2. after list::sort of shuffled values - each step lands somewhere random
+3. the same, walked with prefetched()
+4. the same, after compact()
+Each walk is timed twice: summing the values (almost no work per node) and
+running 64 rounds of hashing on each (about as long as a miss takes, so
+there is work to hide one behind).
+Times are the best of three walks, in nanoseconds per node.
+
+usage: list_traversal_bench [elements]   (default 4000000)
+*/
+#include "list.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace wheel;
+
+static volatile std::uint64_t sink;
+
+static std::uint64_t mix(std::uint64_t x) {
+	for (int round = 0; round < 64; ++round) {
+		x ^= x >> 33;
+		x *= 0xff51afd7ed558ccdull;
+	}
+	return x;
+}
+
+template< typename Range >
+static double ns_per_node(Range&& range, size_t count, bool hash) {
+	double best = 1e300;
+	for (int round = 0; round < 3; ++round) {
+		auto start = std::chrono::steady_clock::now();
+		std::uint64_t total = 0;
+		if (hash) {
+			for (int v : range) {
+				total += mix(static_cast<std::uint64_t>(v));
+			}
+		}
+		else {
+			for (int v : range) {
+				total += static_cast<std::uint64_t>(v);
+			}
+		}
+		sink = total;
+		best = std::min(best, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best / count;
+}
+
+static void row(const char* name, list<int>& l, bool prefetched) {
+	size_t count = l.size();
+	if (prefetched) {
+		std::printf("%-22s %10.2f %10.2f\n", name,
+			ns_per_node(l.prefetched(), count, false), ns_per_node(l.prefetched(), count, true));
+	}
+	else {
+		std::printf("%-22s %10.2f %10.2f\n", name, ns_per_node(l, count, false), ns_per_node(l, count, true));
+	}
+}
+
+int main(int argc, char* argv[]) {
+
+	size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4000000;
+
+	std::vector<int> values(count);
+	std::iota(values.begin(), values.end(), 0);
+	std::shuffle(values.begin(), values.end(), std::mt19937(42));
+
+	list<int> l(values.begin(), values.end());
+
+	std::printf("walking %zu ints (ns per node)\n", count);
+	std::printf("%-22s %10s %10s\n", "", "sum", "hash");
+	row("in address order", l, false);
+	l.sort();
+	row("scattered", l, false);
+	row("scattered, prefetched", l, true);
+	l.compact();
+	row("compacted", l, false);
+	return 0;
+}
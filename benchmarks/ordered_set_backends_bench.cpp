@@ -0,0 +1,93 @@
+/*
+Random insert and random find throughput of wheel::ordered_set with the
+red-black tree and btree backends, against std::set, at 1 thousand, 1
+million and 10 million elements.
+
+usage: ordered_set_backends_bench [largest]   (default 10000000)
+*/
+#include "ordered_set.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <numeric>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace wheel;
+
+using rb_set = ordered_set<int>;
+using b_set = ordered_set<int, std::less<int>, std::allocator<int>, btree_backend<>>;
+
+struct result {
+	double insert_mops;
+	double find_mops;
+};
+
+// small sets are built and searched repeatedly, so every run does about
+// the same number of operations and the timer has something to measure
+template< typename Set >
+static result measure(const std::vector<int>& keys, const std::vector<int>& queries) {
+	size_t rounds = std::max<size_t>(1, 1000000 / keys.size());
+	size_t found = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	for (size_t r = 1; r < rounds; ++r) {
+		Set warmup;
+		for (int k : keys) {
+			warmup.insert(k);
+		}
+		found += warmup.size();
+	}
+	Set myset;
+	for (int k : keys) {
+		myset.insert(k);
+	}
+	auto built = std::chrono::steady_clock::now();
+
+	for (size_t r = 0; r < rounds; ++r) {
+		for (int q : queries) {
+			found += myset.find(q) != myset.end();
+		}
+	}
+	auto stop = std::chrono::steady_clock::now();
+
+	if (found == 0) {
+		std::printf("nothing found\n");
+	}
+	double operations = double(keys.size()) * rounds;
+	return { operations / std::chrono::duration<double>(built - start).count() / 1e6,
+	         operations / std::chrono::duration<double>(stop - built).count() / 1e6 };
+}
+
+int main(int argc, char* argv[]) {
+
+	size_t largest = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+
+	std::printf("ordered_set backends, random keys (million operations/s)\n");
+	std::printf("%10s  %-10s %10s %10s\n", "elements", "set", "insert", "find");
+
+	for (size_t count : { 1000, 1000000, 10000000 }) {
+		if (count > largest) {
+			break;
+		}
+		std::vector<int> keys(count);
+		std::iota(keys.begin(), keys.end(), 0);
+		std::mt19937 rng(42);
+		std::shuffle(keys.begin(), keys.end(), rng);
+
+		std::vector<int> queries(keys);
+		std::shuffle(queries.begin(), queries.end(), rng);
+
+		result rb = measure<rb_set>(keys, queries);
+		result b = measure<b_set>(keys, queries);
+		result std_set = measure<std::set<int>>(keys, queries);
+
+		std::printf("%10zu  %-10s %10.2f %10.2f\n", count, "rb_tree", rb.insert_mops, rb.find_mops);
+		std::printf("%10zu  %-10s %10.2f %10.2f\n", count, "btree", b.insert_mops, b.find_mops);
+		std::printf("%10zu  %-10s %10.2f %10.2f\n", count, "std::set", std_set.insert_mops, std_set.find_mops);
+	}
+}
@@ -0,0 +1,56 @@
+/*
+Insert throughput of wheel::ordered_set for sorted, reverse sorted and random
+input, one key at a time and as one range (the bulk build).
+
+usage: ordered_set_bench [elements]   (default 1000000)
+*/
+#include "ordered_set.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace wheel;
+
+static double insert_mops(const std::vector<int>& input) {
+	auto start = std::chrono::steady_clock::now();
+	ordered_set<int> myset;
+	for (int v : input) {
+		myset.insert(v);
+	}
+	auto stop = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(stop - start).count();
+	return input.size() / seconds / 1e6;
+}
+
+static double bulk_mops(const std::vector<int>& input) {
+	auto start = std::chrono::steady_clock::now();
+	ordered_set<int> myset(input.begin(), input.end());
+	auto stop = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(stop - start).count();
+	return input.size() / seconds / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+
+	size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+	std::vector<int> sorted(count);
+	std::iota(sorted.begin(), sorted.end(), 0);
+
+	std::vector<int> reversed(sorted.rbegin(), sorted.rend());
+
+	std::vector<int> random = sorted;
+	std::shuffle(random.begin(), random.end(), std::mt19937(42));
+
+	std::printf("ordered_set insert, %zu elements (million inserts/s)\n", count);
+	std::printf("  sorted    %8.2f\n", insert_mops(sorted));
+	std::printf("  reversed  %8.2f\n", insert_mops(reversed));
+	std::printf("  random    %8.2f\n", insert_mops(random));
+	std::printf("  bulk sorted %6.2f\n", bulk_mops(sorted));
+	std::printf("  bulk random %6.2f\n", bulk_mops(random));
+}
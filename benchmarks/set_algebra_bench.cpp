@@ -0,0 +1,96 @@
+/*
+Union, intersection and difference of two wheel::ordered_sets of random keys
+- a big one of n keys and one of m - with the split/join set_union and
+friends, against a find or insert per key of the smaller set, and against
+std::set_union and friends over two std::sets.  The arguments are moved in,
+so no copy is timed.
+
+usage: set_algebra_bench [n]   (default 1000000)
+*/
+#include "ordered_set.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace wheel;
+
+static std::vector<int> random_keys(size_t count, std::mt19937& rng) {
+	std::uniform_int_distribution<int> keys(0, static_cast<int>(count * 4));
+	std::vector<int> result(count);
+	for (int& k : result) {
+		k = keys(rng);
+	}
+	return result;
+}
+
+template< typename Function >
+static double milliseconds(Function f) {
+	auto start = std::chrono::steady_clock::now();
+	f();
+	auto stop = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+int main(int argc, char* argv[]) {
+
+	size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+	std::mt19937 rng(42);
+	std::vector<int> big = random_keys(n, rng);
+
+	std::printf("set algebra, n = %zu (ms)\n", n);
+	std::printf("%10s  %-13s %10s %10s %10s\n", "m", "operation", "join", "per key", "std::set");
+
+	for (size_t m : { n, n / 100, size_t(100) }) {
+		std::vector<int> small = random_keys(m, rng);
+		ordered_set<int> a(big.begin(), big.end());
+		ordered_set<int> b(small.begin(), small.end());
+		std::set<int> std_a(big.begin(), big.end());
+		std::set<int> std_b(small.begin(), small.end());
+		size_t check = 0;
+
+		for (int op = 0; op < 3; ++op) {
+			ordered_set<int> x(a), y(b);
+			ordered_set<int> result;
+			double join = milliseconds([&] {
+				if (op == 0) result = set_union(std::move(x), std::move(y));
+				if (op == 1) result = set_intersection(std::move(x), std::move(y));
+				if (op == 2) result = set_difference(std::move(x), std::move(y));
+			});
+			check += result.size();
+
+			// one key of the small set at a time into, or against, the big one
+			ordered_set<int> z(a);
+			size_t matched = 0;
+			double per_key = milliseconds([&] {
+				for (int k : b) {
+					if (op == 0) z.insert(k);
+					if (op == 1) matched += z.find(k) != z.end();
+					if (op == 2) z.erase(k);
+				}
+			});
+			check += z.size() + matched;
+
+			std::set<int> std_result;
+			double std_ms = milliseconds([&] {
+				auto out = std::inserter(std_result, std_result.end());
+				if (op == 0) std::set_union(std_a.begin(), std_a.end(), std_b.begin(), std_b.end(), out);
+				if (op == 1) std::set_intersection(std_a.begin(), std_a.end(), std_b.begin(), std_b.end(), out);
+				if (op == 2) std::set_difference(std_a.begin(), std_a.end(), std_b.begin(), std_b.end(), out);
+			});
+			check += std_result.size();
+
+			const char* names[] = { "union", "intersection", "difference" };
+			std::printf("%10zu  %-13s %10.2f %10.2f %10.2f\n", m, names[op], join, per_key, std_ms);
+		}
+		if (check == 0) {
+			std::printf("nothing\n");
+		}
+	}
+}
@@ -0,0 +1,93 @@
+/*
+The wheel::simd kernels against the standard algorithms they replace -
+std::find, std::count, std::min_element, std::max_element, std::accumulate
+and std::equal - over a wheel::vector of int and of float, at each level
+the cpu supports.  One size fits in the L1 cache, the other only in memory.
+
+usage: simd_bench [elements]   (default 10000000 for the big size)
+*/
+#include "simd.hpp"
+#include "vector.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <numeric>
+#include <random>
+
+using namespace wheel;
+
+static volatile double sink;
+
+// billions of elements per second, over enough repeats to see about 2 billion
+template< typename Function >
+static double gelements(size_t count, Function f) {
+	size_t repeats = std::max<size_t>(1, 2000000000 / count);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t r = 0; r < repeats; ++r) {
+		f();
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<double>(count) * repeats / seconds / 1e9;
+}
+
+template< typename T >
+static void run(const char* type, size_t count) {
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<int> values(-1000, 1000);
+	vector<T> a(count, T());
+	for (T& x : a) {
+		x = static_cast<T>(values(rng));
+	}
+	vector<T> b(a.begin(), a.end());
+	const T* first = a.begin();
+	const T* last = a.end();
+	const T missing = static_cast<T>(5000);   // so find reads everything
+
+	auto row = [&](const char* name, auto standard, auto kernel) {
+		std::printf("%-6s %-6s %10zu %10.2f", type, name, count, gelements(count, standard));
+		for (simd::level level : { simd::level::sse4, simd::level::avx2 }) {
+			if (simd::use_level(level) == level) {
+				std::printf(" %10.2f", gelements(count, kernel));
+			}
+			else {
+				std::printf(" %10s", "-");
+			}
+		}
+		simd::use_level(simd::detected_level());
+		std::printf("\n");
+	};
+
+	row("find",
+		[&] { sink = static_cast<double>(std::find(first, last, missing) - first); },
+		[&] { sink = static_cast<double>(simd::find(a, missing) - first); });
+	row("count",
+		[&] { sink = static_cast<double>(std::count(first, last, T(7))); },
+		[&] { sink = static_cast<double>(simd::count(a, T(7))); });
+	row("min",
+		[&] { sink = static_cast<double>(*std::min_element(first, last)); },
+		[&] { sink = static_cast<double>(simd::min(a)); });
+	row("max",
+		[&] { sink = static_cast<double>(*std::max_element(first, last)); },
+		[&] { sink = static_cast<double>(simd::max(a)); });
+	row("sum",
+		[&] { sink = static_cast<double>(std::accumulate(first, last, simd::sum_type<T>())); },
+		[&] { sink = static_cast<double>(simd::sum(a)); });
+	row("equal",
+		[&] { sink = std::equal(first, last, b.begin()); },
+		[&] { sink = simd::equal(a, b); });
+}
+
+int main(int argc, char* argv[]) {
+
+	size_t big = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+
+	std::printf("billion elements/s, -O2 with no -m flags, so std is plain x86-64\n");
+	std::printf("%-6s %-6s %10s %10s %10s %10s\n", "type", "kernel", "elements", "std", "sse4.2", "avx2");
+	for (size_t count : { size_t(4096), big }) {
+		run<int>("int", count);
+		run<float>("float", count);
+	}
+}
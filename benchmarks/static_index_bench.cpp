@@ -0,0 +1,88 @@
+/*
+Random lookups in a read-only set of ints: std::lower_bound over a sorted
+wheel::vector, wheel::flat_set's branch free search, and wheel::static_index
+one query at a time (contains) and in groups (find_many), at 1 thousand up
+to 100 million keys.
+
+usage: static_index_bench [largest]   (default 10000000)
+*/
+#include "flat_set.hpp"
+#include "static_index.hpp"
+#include "vector.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <random>
+#include <vector>
+
+using namespace wheel;
+
+template< typename Function >
+static double mops(size_t operations, Function f) {
+	auto start = std::chrono::steady_clock::now();
+	f();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return operations / seconds / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+
+	size_t largest = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+	const size_t lookups = 10000000;
+
+	std::printf("random lookups, half of them hits (million lookups/s)\n");
+	std::printf("%10s %14s %10s %10s %10s\n", "keys", "lower_bound", "flat_set", "contains", "find_many");
+
+	for (size_t count : { size_t(1000), size_t(1000000), size_t(10000000), size_t(100000000) }) {
+		if (count > largest) {
+			break;
+		}
+		// even keys, queried with any key, so about half are found
+		std::mt19937 rng(42);
+		vector<int> sorted(count, 0);
+		for (size_t k = 0; k < count; ++k) {
+			sorted[k] = static_cast<int>(2 * k);
+		}
+		std::uniform_int_distribution<int> keys(0, static_cast<int>(2 * count));
+		std::vector<int> queries(lookups);
+		for (int& q : queries) {
+			q = keys(rng);
+		}
+
+		size_t found = 0;
+		double plain = mops(lookups, [&] {
+			for (int q : queries) {
+				const int* at = std::lower_bound(sorted.begin(), sorted.end(), q);
+				found += at != sorted.end() && *at == q;
+			}
+		});
+
+		flat_set<int> flat(sorted.begin(), sorted.end());
+		double flat_find = mops(lookups, [&] {
+			for (int q : queries) {
+				found += flat.find(q) != flat.end();
+			}
+		});
+
+		static_index<int> index(std::move(sorted));
+		double contains = mops(lookups, [&] {
+			for (int q : queries) {
+				found += index.contains(q);
+			}
+		});
+
+		std::vector<const int*> results(lookups);
+		double many = mops(lookups, [&] {
+			index.find_many(queries.begin(), queries.end(), results.begin());
+		});
+		found += std::count(results.begin(), results.end(), nullptr);
+
+		std::printf("%10zu %14.2f %10.2f %10.2f %10.2f\n", count, plain, flat_find, contains, many);
+		if (found == 0) {
+			std::printf("nothing found\n");
+		}
+	}
+}
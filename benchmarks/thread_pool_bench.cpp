@@ -0,0 +1,125 @@
+/*
+How wheel::thread_pool scales from 1 thread up to the number of cores (or
+the number given), on four jobs:
+1. parallel_for over a compute bound loop - a few hundred rounds of integer
+   hashing per index, so memory bandwidth is no limit
+2. parallel_for filling a wheel::vector - a bulk fill, memory bound
+3. wheel::sort(par) of a wheel::vector of random ints
+4. submit of many tiny tasks, waiting on each future - the overhead per task
+Times are the best of three runs, speedup is against the same job on one
+thread of the pool.
+
+usage: thread_pool_bench [threads] [elements]   (default cores, 10000000)
+*/
+#include "algorithm.hpp"
+#include "thread_pool.hpp"
+#include "vector.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <random>
+#include <vector>
+
+using namespace wheel;
+
+static std::atomic<std::uint64_t> sink;
+
+template< typename Function >
+static double milliseconds(Function f) {
+	double best = 0;
+	for (int run = 0; run < 3; ++run) {
+		auto start = std::chrono::steady_clock::now();
+		f();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		best = run == 0 ? ms : std::min(best, ms);
+	}
+	return best;
+}
+
+static std::uint64_t hash_rounds(std::uint64_t x) {
+	for (int round = 0; round < 200; ++round) {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+	}
+	return x;
+}
+
+int main(int argc, char* argv[]) {
+
+	size_t most = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : thread_pool::default_threads();
+	size_t n = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000000;
+	const size_t compute = n / 10;
+	const size_t tasks = 100000;
+
+	std::mt19937 rng(42);
+	std::vector<int> random(n);
+	for (int& k : random) {
+		k = static_cast<int>(rng());
+	}
+	vector<int> fill(random.begin(), random.end());
+	vector<int> sorted(random.begin(), random.end());
+
+	std::printf("thread_pool scaling, %zu elements (ms, speedup over 1 thread)\n", n);
+	std::printf("%7s %16s %16s %16s %16s\n", "threads", "compute", "fill", "sort", "submit");
+
+	double base[4] = {};
+	std::vector<size_t> counts;
+	for (size_t threads = 1; threads < most; threads *= 2) {
+		counts.push_back(threads);
+	}
+	counts.push_back(most);
+
+	for (size_t threads : counts) {
+		thread_pool pool(threads);
+		double ms[4];
+
+		ms[0] = milliseconds([&] {
+			pool.parallel_for(0, compute, [](size_t begin, size_t end) {
+				std::uint64_t total = 0;
+				for (size_t i = begin; i != end; ++i) {
+					total += hash_rounds(i + 1);
+				}
+				sink += total;
+			});
+		});
+
+		ms[1] = milliseconds([&] {
+			int* data = fill.begin();
+			pool.parallel_for(0, fill.size(), [data](size_t begin, size_t end) {
+				std::fill(data + begin, data + end, static_cast<int>(begin));
+			});
+		});
+
+		ms[2] = milliseconds([&] {
+			std::copy(random.begin(), random.end(), sorted.begin());
+			wheel::sort(execution::par.on(pool), sorted.begin(), sorted.end());
+		});
+
+		ms[3] = milliseconds([&] {
+			std::vector<std::future<size_t>> done;
+			done.reserve(tasks);
+			for (size_t t = 0; t < tasks; ++t) {
+				done.push_back(pool.submit([t] { return t; }));
+			}
+			for (auto& f : done) {
+				sink += f.get();
+			}
+		});
+
+		std::printf("%7zu", threads);
+		for (int job = 0; job < 4; ++job) {
+			if (threads == 1) {
+				base[job] = ms[job];
+			}
+			std::printf(" %9.1f %5.2fx", ms[job], base[job] / ms[job]);
+		}
+		std::printf("\n");
+	}
+	return sink == 42 ? 1 : 0;
+}
@@ -0,0 +1,85 @@
+/*
+wheel::unrolled_list against wheel::list and std::vector for ints:
+1. push_back of every value
+2. summing every value with a range for - the best of five walks
+3. inserting values into the middle, each before the one inserted last
+The lists are built by push_back, so their nodes are in address order - the
+kindest case for wheel::list.
+
+usage: unrolled_list_bench [elements]   (default 10000000)
+*/
+#include "list.hpp"
+#include "unrolled_list.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <vector>
+
+using namespace wheel;
+
+static volatile long long sink;
+
+template< typename F >
+static double seconds(F&& f) {
+	auto start = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template< typename Container >
+static void run(const char* name, size_t count) {
+	Container c;
+	double build = seconds([&] {
+		for (size_t i = 0; i < count; ++i) {
+			c.push_back(static_cast<int>(i));
+		}
+	});
+
+	double walk = 1e9;
+	for (int round = 0; round < 5; ++round) {
+		walk = std::min(walk, seconds([&] {
+			long long sum = 0;
+			for (int v : c) {
+				sum += v;
+			}
+			sink = sum;
+		}));
+	}
+
+	std::printf("%-14s %12.2f %12.2f\n", name, count / build / 1e6, count / walk / 1e6);
+}
+
+template< typename List >
+static double middle_mops(size_t count) {
+	List l;
+	for (size_t i = 0; i < count; ++i) {
+		l.push_back(static_cast<int>(i));
+	}
+	auto it = std::next(l.begin(), count / 2);
+	size_t inserts = count / 10;
+	double time = seconds([&] {
+		for (size_t i = 0; i < inserts; ++i) {
+			it = l.insert(it, static_cast<int>(i));
+		}
+	});
+	return inserts / time / 1e6;
+}
+
+int main(int argc, char* argv[]) {
+
+	size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+
+	std::printf("%zu ints (million values/s)\n", count);
+	std::printf("%-14s %12s %12s\n", "", "push_back", "iterate");
+	run<std::vector<int>>("vector", count);
+	run<list<int>>("list", count);
+	run<unrolled_list<int>>("unrolled_list", count);
+
+	std::printf("\n%zu inserts in the middle (million inserts/s)\n", count / 10);
+	std::printf("%-14s %12.2f\n", "list", middle_mops<list<int>>(count));
+	std::printf("%-14s %12.2f\n", "unrolled_list", middle_mops<unrolled_list<int>>(count));
+	return 0;
+}
@@ -0,0 +1,234 @@
+/*
+Parallel for_each, transform, reduce, copy and sort, over a wheel::vector,
+a wheel::list, or any forward iterator range - called like the standard
+overloads that take an execution policy:
+
+  wheel::sort(wheel::execution::par, v.begin(), v.end());
+  long long total = wheel::reduce(wheel::execution::par, l.begin(), l.end(), 0LL);
+
+The range is cut into a few chunks per thread of the policy's pool, each
+at least min_chunk elements, and each chunk is handed to the standard
+algorithm on a thread of its own.  A vector's chunks are found with
+pointer arithmetic.  A list has to be walked, once, to gather the node each
+chunk starts at - after that the chunks are walked in parallel.  seq runs
+the standard algorithm directly.
+
+Unlike std::reduce, reduce combines the chunks in order, so op need only
+be associative, not commutative.  sort sorts each chunk and merges them in
+pairs, a round of merges at a time.  A list is sorted by moving its values
+into a contiguous buffer and back again - its nodes stay where they are.
+
+Operation       Speed
+for_each        O(n / threads)  // and transform, copy, reduce
+sort            O(n log n / threads + n)
+*/
+
+#ifndef ALGORITHM_HPP_
+#define ALGORITHM_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "execution.hpp"
+#include "thread_pool.hpp"
+
+namespace wheel {  // as in re-inventing the wheel
+
+    namespace detail {
+
+        // chunks smaller than this are not worth another thread
+        constexpr size_t min_chunk = 1024;
+
+        // more chunks than threads, so a thread that finishes early can steal
+        constexpr size_t chunks_per_thread = 4;
+
+        // R, if Policy is one of ours - keeps these overloads away from
+        // calls to the sequential standard algorithms
+        template< typename Policy, typename R = void >
+        using if_policy = std::enable_if_t<is_execution_policy<std::decay_t<Policy>>::value, R>;
+
+        template< typename Policy >
+        constexpr bool is_sequenced = std::is_same<std::decay_t<Policy>, execution::sequenced_policy>::value;
+
+        template< typename Iterator >
+        constexpr bool is_random_access = std::is_base_of<std::random_access_iterator_tag,
+            typename std::iterator_traits<Iterator>::iterator_category>::value;
+
+        inline size_t chunk_count(const thread_pool& pool, size_t n) {
+            return std::max<size_t>(1, std::min(n / min_chunk, pool.size() * chunks_per_thread));
+        }
+
+        // chunks + 1 iterators, chunk c being [bounds[c], bounds[c + 1]), all
+        // within one element of the same length
+        template< typename Iterator >
+        std::vector<Iterator> split(Iterator first, size_t n, size_t chunks) {
+            std::vector<Iterator> bounds;
+            bounds.reserve(chunks + 1);
+            bounds.push_back(first);
+            size_t at = 0;
+            for (size_t c = 1; c <= chunks; ++c) {
+                size_t next = n / chunks * c + std::min(c, n % chunks);
+                using difference = typename std::iterator_traits<Iterator>::difference_type;
+                std::advance(first, static_cast<difference>(next - at));  // O(1) for a vector
+                bounds.push_back(first);
+                at = next;
+            }
+            return bounds;
+        }
+
+        // body(c) for every chunk c, on the pool's threads
+        template< typename Body >
+        void each_chunk(thread_pool& pool, size_t chunks, Body body) {
+            pool.parallel_for(0, chunks, [&body](size_t begin, size_t end) {
+                for (size_t c = begin; c != end; ++c) {
+                    body(c);
+                }
+            }, 1);
+        }
+
+        template< typename RandomIt, typename Compare >
+        void parallel_sort(thread_pool& pool, RandomIt first, RandomIt last, Compare comp) {
+            size_t n = static_cast<size_t>(last - first);
+            std::vector<RandomIt> bounds = split(first, n, chunk_count(pool, n));
+            each_chunk(pool, bounds.size() - 1, [&](size_t c) {
+                std::sort(bounds[c], bounds[c + 1], comp);
+            });
+
+            // merge neighbouring runs, halving their number every round
+            while (bounds.size() > 2) {
+                size_t runs = bounds.size() - 1;
+                each_chunk(pool, runs / 2, [&](size_t pair) {
+                    std::inplace_merge(bounds[2 * pair], bounds[2 * pair + 1], bounds[2 * pair + 2], comp);
+                });
+                std::vector<RandomIt> merged;
+                for (size_t i = 0; i <= runs; i += 2) {
+                    merged.push_back(bounds[i]);
+                }
+                if (runs % 2 == 1) {
+                    merged.push_back(bounds[runs]);
+                }
+                bounds.swap(merged);
+            }
+        }
+
+    }  // namespace detail
+
+    // f(element) for every element
+    template< typename Policy, typename ForwardIt, typename Function >
+    detail::if_policy<Policy> for_each(Policy&& policy, ForwardIt first, ForwardIt last, Function f) {
+        if constexpr (detail::is_sequenced<Policy>) {
+            std::for_each(first, last, f);
+        }
+        else {
+            thread_pool& pool = pool_of(policy);
+            size_t n = static_cast<size_t>(std::distance(first, last));
+            std::vector<ForwardIt> bounds = detail::split(first, n, detail::chunk_count(pool, n));
+            detail::each_chunk(pool, bounds.size() - 1, [&](size_t c) {
+                std::for_each(bounds[c], bounds[c + 1], f);
+            });
+        }
+    }
+
+    // d_first receives op(element) for every element - returns the end of
+    // what was written
+    template< typename Policy, typename ForwardIt1, typename ForwardIt2, typename UnaryOperation >
+    detail::if_policy<Policy, ForwardIt2> transform(Policy&& policy, ForwardIt1 first, ForwardIt1 last,
+                                                    ForwardIt2 d_first, UnaryOperation op) {
+        if constexpr (detail::is_sequenced<Policy>) {
+            return std::transform(first, last, d_first, op);
+        }
+        else {
+            thread_pool& pool = pool_of(policy);
+            size_t n = static_cast<size_t>(std::distance(first, last));
+            size_t chunks = detail::chunk_count(pool, n);
+            std::vector<ForwardIt1> in = detail::split(first, n, chunks);
+            std::vector<ForwardIt2> out = detail::split(d_first, n, chunks);
+            detail::each_chunk(pool, chunks, [&](size_t c) {
+                std::transform(in[c], in[c + 1], out[c], op);
+            });
+            return out.back();
+        }
+    }
+
+    template< typename Policy, typename ForwardIt1, typename ForwardIt2 >
+    detail::if_policy<Policy, ForwardIt2> copy(Policy&& policy, ForwardIt1 first, ForwardIt1 last, ForwardIt2 d_first) {
+        if constexpr (detail::is_sequenced<Policy>) {
+            return std::copy(first, last, d_first);
+        }
+        else {
+            thread_pool& pool = pool_of(policy);
+            size_t n = static_cast<size_t>(std::distance(first, last));
+            size_t chunks = detail::chunk_count(pool, n);
+            std::vector<ForwardIt1> in = detail::split(first, n, chunks);
+            std::vector<ForwardIt2> out = detail::split(d_first, n, chunks);
+            detail::each_chunk(pool, chunks, [&](size_t c) {
+                std::copy(in[c], in[c + 1], out[c]);
+            });
+            return out.back();
+        }
+    }
+
+    // init op e1 op e2 op ... - op must be associative
+    template< typename Policy, typename ForwardIt, typename T, typename BinaryOperation = std::plus<> >
+    detail::if_policy<Policy, T> reduce(Policy&& policy, ForwardIt first, ForwardIt last, T init,
+                                        BinaryOperation op = BinaryOperation()) {
+        if constexpr (detail::is_sequenced<Policy>) {
+            return std::accumulate(first, last, std::move(init), op);
+        }
+        else {
+            thread_pool& pool = pool_of(policy);
+            size_t n = static_cast<size_t>(std::distance(first, last));
+            if (n == 0) {
+                return init;
+            }
+            std::vector<ForwardIt> bounds = detail::split(first, n, detail::chunk_count(pool, n));
+            std::vector<T> partial(bounds.size() - 1, init);
+            detail::each_chunk(pool, partial.size(), [&](size_t c) {
+                T total = *bounds[c];
+                for (ForwardIt it = std::next(bounds[c]); it != bounds[c + 1]; ++it) {
+                    total = op(std::move(total), *it);
+                }
+                partial[c] = std::move(total);
+            });
+            return std::accumulate(std::make_move_iterator(partial.begin()), std::make_move_iterator(partial.end()),
+                                   std::move(init), op);
+        }
+    }
+
+    // the sum of the elements
+    template< typename Policy, typename ForwardIt >
+    detail::if_policy<Policy, typename std::iterator_traits<ForwardIt>::value_type>
+    reduce(Policy&& policy, ForwardIt first, ForwardIt last) {
+        using T = typename std::iterator_traits<ForwardIt>::value_type;
+        return wheel::reduce(std::forward<Policy>(policy), first, last, T());
+    }
+
+    // not stable - bidirectional iterators, for a wheel::list, are sorted
+    // through a contiguous copy of the values
+    template< typename Policy, typename BidirIt, typename Compare = std::less<> >
+    detail::if_policy<Policy> sort(Policy&& policy, BidirIt first, BidirIt last, Compare comp = Compare()) {
+        using T = typename std::iterator_traits<BidirIt>::value_type;
+        if constexpr (detail::is_random_access<BidirIt>) {
+            if constexpr (detail::is_sequenced<Policy>) {
+                std::sort(first, last, comp);
+            }
+            else {
+                detail::parallel_sort(pool_of(policy), first, last, comp);
+            }
+        }
+        else {
+            std::vector<T> values(std::make_move_iterator(first), std::make_move_iterator(last));
+            wheel::sort(policy, values.begin(), values.end(), comp);
+            wheel::copy(policy, std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()), first);
+        }
+    }
+
+}  // namespace wheel
+
+#endif // ALGORITHM_HPP_
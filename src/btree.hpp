@@ -0,0 +1,978 @@
+/* example, at most 3 values per node:
+
+                 [ 8  |  20 ]
+               /      |      \
+      [ 2 | 5 ]   [ 12 | 15 ]   [ 25 | 30 | 40 ]
+
+Values inside a node are sorted, and the values of child i lie between
+value i - 1 and value i of its parent.  Every leaf is at the same depth.
+
+An alternative engine for ordered_set (select it with btree_backend).  A
+binary tree node holds one value and three pointers, so a lookup in a big
+set is a chain of dependent cache misses, one per level, and there are
+about log2(n) levels.  A btree node holds as many values as fit in
+NodeBytes, so for ints there are about 60 per node, the tree is about
+log60(n) levels deep - 4 for 10 million values rather than 24 - and each
+node searched is a few adjacent cache lines the hardware prefetcher can
+stream in.
+
+Within a node, arithmetic keys are searched by counting how many are less
+than the key.  The loop has no early exit and no branch on the data, so the
+compiler can turn it into SIMD compares.  Other keys, where a comparison
+may be expensive, are binary searched.
+
+Node rules, with max_values = 2t - 1:
+1. every node other than the root holds between t - 1 and 2t - 1 values
+2. an internal node with k values has k + 1 children
+Insert splits a full node into two of t - 1 around its middle value, on the
+way down, so there is always room for the new value in the leaf.  Erase
+takes a value from a leaf (an internal value is swapped for its
+predecessor, which is always in a leaf) and tops up a leaf left with too
+few by borrowing from a sibling or merging with it, working back up.
+
+Unlike the red-black tree, values move between nodes - so insert and erase
+invalidate iterators and references to other elements.  Value's move
+constructor must not throw.
+
+Leaves and internal nodes come from their own node_pools.
+
+Operation       Speed
+try_emplace     O(log n)
+assign_sorted   O(n)
+find            O(log n)
+erase           O(log n)
+lower_bound     O(log n)
+upper_bound     O(log n)
+rank, select    O(log n)  // t subtree sizes per level - each node keeps its size
+unite           O(n + m)  // and intersect, subtract - by merging
+begin           O(log n)
+++, --          O(1)  // amortized - O(log n) worst case
+clear           O(chunks), O(n) if values have a destructor
+*/
+
+#ifndef BTREE_HPP_
+#define BTREE_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "node_pool.hpp"
+#include "rb_tree.hpp"   // compare_holder
+#include "vector.hpp"    // is_trivially_relocatable
+
+namespace wheel {  // as in re-inventing the wheel
+
+    template< typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator, size_t NodeBytes = 256 >
+    class btree : private compare_holder<Compare> {
+
+        struct internal_node;
+
+        struct node_base {
+            internal_node* parent;
+            size_t size;               // values in the subtree rooted here, for rank and select
+            unsigned short count;      // values held
+            unsigned short position;   // which of parent's children this is
+            bool leaf;
+        };
+
+        static constexpr size_t header_bytes = sizeof(node_base) + alignof(Value) - 1;
+        static constexpr size_t fit = NodeBytes > header_bytes + 3 * sizeof(Value) ? (NodeBytes - header_bytes) / sizeof(Value) : 3;
+
+    public:
+        // odd, so that a full node splits into two halves and a middle value
+        static constexpr size_t max_values = fit % 2 ? fit : fit - 1;
+        static constexpr size_t min_values = max_values / 2;   // t - 1
+
+        static_assert(max_values < 65535, "btree node counts are unsigned short");
+
+    private:
+        struct leaf_node : node_base {
+            alignas(Value) unsigned char storage[max_values * sizeof(Value)];
+        };
+
+        struct internal_node : leaf_node {
+            node_base* children[max_values + 1];
+        };
+
+        static Value* values(node_base* n) {
+            return reinterpret_cast<Value*>(static_cast<leaf_node*>(n)->storage);
+        }
+
+        static internal_node* internal(node_base* n) {
+            return static_cast<internal_node*>(n);
+        }
+
+    public:
+        using node = node_base;
+        using allocator_type = Allocator;
+
+        // In order - a step is usually just the next slot of a leaf.  The
+        // tree is needed to step back from end(), which is a null node.
+        template< bool Const >
+        class tree_iterator {
+        public:
+            using value_type = Value;
+            using difference_type = std::ptrdiff_t;
+            using pointer = std::conditional_t<Const, const Value*, Value*>;
+            using reference = std::conditional_t<Const, const Value&, Value&>;
+            using iterator_category = std::bidirectional_iterator_tag;
+
+            constexpr tree_iterator() noexcept = default;
+            constexpr tree_iterator(node_base* n, size_t index, const btree* tree) noexcept
+                : node_{ n }, index_{ index }, tree_{ tree } {}
+
+            // iterator converts to const_iterator, not the other way
+            template< bool WasConst, typename = std::enable_if_t<Const && !WasConst> >
+            constexpr tree_iterator(const tree_iterator<WasConst>& other) noexcept
+                : node_{ other.node_ }, index_{ other.index_ }, tree_{ other.tree_ } {}
+
+            // down to the leftmost leaf of the next subtree, or up until we
+            // come from a child that is not the last
+            tree_iterator& operator++() {
+                if (!node_->leaf) {
+                    node_ = leftmost(internal(node_)->children[index_ + 1]);
+                    index_ = 0;
+                    return *this;
+                }
+                ++index_;
+                while (index_ == node_->count) {
+                    if (node_->parent == nullptr) {
+                        node_ = nullptr;
+                        index_ = 0;
+                        break;
+                    }
+                    index_ = node_->position;
+                    node_ = node_->parent;
+                }
+                return *this;
+            }
+
+            tree_iterator operator++(int) {
+                auto old = *this;
+                ++*this;
+                return old;
+            }
+
+            // mirror image of ++
+            tree_iterator& operator--() {
+                if (node_ == nullptr) {
+                    node_ = rightmost(tree_->root_);
+                    index_ = node_->count - 1;
+                    return *this;
+                }
+                if (!node_->leaf) {
+                    node_ = rightmost(internal(node_)->children[index_]);
+                    index_ = node_->count - 1;
+                    return *this;
+                }
+                while (index_ == 0) {
+                    index_ = node_->position;
+                    node_ = node_->parent;
+                }
+                --index_;
+                return *this;
+            }
+
+            tree_iterator operator--(int) {
+                auto old = *this;
+                --*this;
+                return old;
+            }
+
+            reference operator*() const { return values(node_)[index_]; }
+            pointer operator->() const { return values(node_) + index_; }
+
+            friend bool operator==(const tree_iterator& a, const tree_iterator& b) {
+                return a.node_ == b.node_ && a.index_ == b.index_;
+            }
+            friend bool operator!=(const tree_iterator& a, const tree_iterator& b) { return !(a == b); }
+
+            node_base* node_ = nullptr;
+            size_t index_ = 0;
+            const btree* tree_ = nullptr;
+        };
+
+        using iterator = tree_iterator<false>;
+        using const_iterator = tree_iterator<true>;
+
+        btree() = default;
+
+        btree(const Compare& comp, const Allocator& alloc)
+            : compare_holder<Compare>(comp), leaves_(leaf_allocator(alloc)), internals_(internal_allocator(alloc)) {}
+
+        // O(n) - the copy is a bulk build from other's values, in order
+        btree(const btree& other)
+            : btree(other, Allocator(leaf_traits::select_on_container_copy_construction(other.leaves_.allocator()))) {}
+
+        btree(const btree& other, const Allocator& alloc)
+            : compare_holder<Compare>(other.comp()), leaves_(leaf_allocator(alloc)), internals_(internal_allocator(alloc)) {
+            assign_sorted(other.begin(), other.size());
+        }
+
+        // O(1) - the nodes change hands
+        btree(btree&& other) noexcept
+            : compare_holder<Compare>(other.comp()), leaves_(other.leaves_.allocator()), internals_(other.internals_.allocator()) {
+            swap_nodes(other);
+        }
+
+        // O(n) - the copy is made with the allocator *this ends up with, then
+        // swapped in
+        btree& operator=(const btree& other) {
+            if (this != &other) {
+                constexpr bool propagate = leaf_traits::propagate_on_container_copy_assignment::value;
+                btree copy(other, propagate ? Allocator(other.leaves_.allocator()) : Allocator(leaves_.allocator()));
+                swap_nodes(copy);
+                if constexpr (propagate) {
+                    std::swap(leaves_.allocator(), copy.leaves_.allocator());
+                    std::swap(internals_.allocator(), copy.internals_.allocator());
+                }
+                static_cast<compare_holder<Compare>&>(*this) = other;
+            }
+            return *this;
+        }
+
+        // O(1) - unless the allocators differ and cannot be propagated, then
+        // each value is moved into a node of our own, O(n)
+        btree& operator=(btree&& other) noexcept(leaf_traits::propagate_on_container_move_assignment::value ||
+                                                 leaf_traits::is_always_equal::value) {
+            if (this == &other) {
+                return *this;
+            }
+            if constexpr (leaf_traits::propagate_on_container_move_assignment::value) {
+                clear();
+                leaves_.allocator() = std::move(other.leaves_.allocator());
+                internals_.allocator() = std::move(other.internals_.allocator());
+                swap_nodes(other);
+            }
+            else {
+                if (leaf_traits::is_always_equal::value || leaves_.allocator() == other.leaves_.allocator()) {
+                    clear();
+                    swap_nodes(other);
+                }
+                else {
+                    assign_sorted(std::make_move_iterator(other.begin()), other.size());
+                    other.clear();
+                }
+            }
+            static_cast<compare_holder<Compare>&>(*this) = other;
+            return *this;
+        }
+
+        ~btree() {
+            clear();
+        }
+
+        // O(log n) - if no value has an equivalent key, one is built from args
+        // and put in a leaf.  Full nodes met on the way down are split first.
+        template< typename K, typename... Args >
+        std::pair<iterator, bool> try_emplace(const K& key, Args&&... args) {
+            if (root_ == nullptr) {
+                root_ = make_leaf();
+            }
+            if (root_->count == max_values) {
+                internal_node* top = make_internal();
+                top->size = root_->size;
+                top->children[0] = root_;
+                root_->parent = top;
+                root_->position = 0;
+                root_ = top;
+                split_child(top, 0);
+            }
+
+            node_base* n = root_;
+            for (;;) {
+                size_t i = lower_index(n, key);
+                if (i < n->count && !comp()(key, key_of(values(n)[i]))) {
+                    return { iterator(n, i, this), false };
+                }
+                if (n->leaf) {
+                    try {
+                        insert_value(n, i, std::forward<Args>(args)...);
+                    }
+                    catch (...) {
+                        if (size_ == 0) {   // don't leave an empty root behind
+                            free_node(root_);
+                            root_ = nullptr;
+                        }
+                        throw;
+                    }
+                    for (node_base* above = n; above != nullptr; above = above->parent) {
+                        ++above->size;
+                    }
+                    ++size_;
+                    return { iterator(n, i, this), true };
+                }
+                if (internal(n)->children[i]->count == max_values) {
+                    split_child(internal(n), i);
+                    // the middle value came up to i, the key may be on either side of it, or be it
+                    if (comp()(key_of(values(n)[i]), key)) {
+                        ++i;
+                    }
+                    else if (!comp()(key, key_of(values(n)[i]))) {
+                        return { iterator(n, i, this), false };
+                    }
+                }
+                n = internal(n)->children[i];
+            }
+        }
+
+        // O(log n) - K is Key, or anything Compare can compare with Key if it is transparent
+        template< typename K >
+        iterator find(const K& key) {
+            std::pair<node_base*, size_t> found = find_value(key);
+            return iterator(found.first, found.second, this);
+        }
+
+        template< typename K >
+        const_iterator find(const K& key) const {
+            std::pair<node_base*, size_t> found = find_value(key);
+            return const_iterator(found.first, found.second, this);
+        }
+
+        // O(log n) - the first value whose key is not less than key
+        template< typename K >
+        iterator lower_bound(const K& key) {
+            std::pair<node_base*, size_t> found = bound_value<false>(key);
+            return iterator(found.first, found.second, this);
+        }
+
+        template< typename K >
+        const_iterator lower_bound(const K& key) const {
+            std::pair<node_base*, size_t> found = bound_value<false>(key);
+            return const_iterator(found.first, found.second, this);
+        }
+
+        // O(log n) - the first value whose key is greater than key
+        template< typename K >
+        iterator upper_bound(const K& key) {
+            std::pair<node_base*, size_t> found = bound_value<true>(key);
+            return iterator(found.first, found.second, this);
+        }
+
+        template< typename K >
+        const_iterator upper_bound(const K& key) const {
+            std::pair<node_base*, size_t> found = bound_value<true>(key);
+            return const_iterator(found.first, found.second, this);
+        }
+
+        // O(log n) - how many values have keys less than key.  At each level
+        // the values before the key's position and the subtrees to their left
+        // are all less.
+        template< typename K >
+        size_t rank(const K& key) const {
+            size_t less = 0;
+            node_base* n = root_;
+            while (n != nullptr) {
+                size_t i = lower_index(n, key);
+                less += i;
+                if (n->leaf) {
+                    break;
+                }
+                bool equal = i < n->count && !comp()(key, key_of(values(n)[i]));
+                for (size_t child = 0; child < i + equal; ++child) {
+                    less += internal(n)->children[child]->size;
+                }
+                if (equal) {
+                    break;
+                }
+                n = internal(n)->children[i];
+            }
+            return less;
+        }
+
+        // O(log n) - the value with index i in order, or end() if there are
+        // not that many.  Each level skips whole subtrees by their size.
+        const_iterator select(size_t i) const {
+            if (i >= size_) {
+                return end();
+            }
+            node_base* n = root_;
+            while (!n->leaf) {
+                size_t child = 0;
+                while (i >= internal(n)->children[child]->size) {
+                    i -= internal(n)->children[child]->size;
+                    if (i == 0) {
+                        return const_iterator(n, child, this);
+                    }
+                    --i;
+                    ++child;
+                }
+                n = internal(n)->children[child];
+            }
+            return const_iterator(n, i, this);
+        }
+
+        // O(log n) - returns the number of elements removed, 0 or 1
+        template< typename K >
+        size_t erase(const K& key) {
+            std::pair<node_base*, size_t> found = find_value(key);
+            node_base* n = found.first;
+            size_t i = found.second;
+            if (n == nullptr) {
+                return 0;
+            }
+
+            destroy_value(values(n) + i);
+            if (n->leaf) {
+                relocate(values(n) + i + 1, n->count - i - 1, values(n) + i);
+            }
+            else {
+                // the predecessor - the last value of the rightmost leaf of the
+                // left subtree - fills the hole, and that leaf loses a value instead
+                node_base* leaf = rightmost(internal(n)->children[i]);
+                relocate(values(leaf) + leaf->count - 1, 1, values(n) + i);
+                n = leaf;
+            }
+            --n->count;
+            for (node_base* above = n; above != nullptr; above = above->parent) {
+                --above->size;
+            }
+            --size_;
+            rebalance(n);
+            return 1;
+        }
+
+        // O(n) - replaces the contents with count values read in order from
+        // first, whose keys must be strictly increasing.  The tree is built with
+        // no comparisons, as low as it can be, and with values shared evenly
+        // between the children of each node - even shares of a subtree too big
+        // for one child fewer are always at least half full.  Nodes are made in
+        // key order, so they sit in key order within each slab.
+        template< typename InputIterator >
+        void assign_sorted(InputIterator first, size_t count) {
+            clear();
+            if (count == 0) {
+                return;
+            }
+            size_t height = 0;
+            while (capacity(height) < count) {
+                ++height;
+            }
+            try {
+                root_ = build_subtree(first, count, height);
+            }
+            catch (...) {
+                leaves_.release();
+                internals_.release();
+                throw;
+            }
+            size_ = count;
+        }
+
+        // Set algebra on whole trees, O(n + m).  A btree has no cheap split and
+        // join, so the two are merged in order into a buffer and the result bulk
+        // built.  *this becomes the result and other ends up empty.  Where both
+        // have a value with the same key, *this's is kept.
+        void unite(btree& other) {
+            combine(other, [](auto a, auto a_end, auto b, auto b_end, auto out, auto less) {
+                std::set_union(a, a_end, b, b_end, out, less);
+            });
+        }
+
+        void intersect(btree& other) {
+            combine(other, [](auto a, auto a_end, auto b, auto b_end, auto out, auto less) {
+                std::set_intersection(a, a_end, b, b_end, out, less);
+            });
+        }
+
+        // takes away the values whose keys are in other
+        void subtract(btree& other) {
+            combine(other, [](auto a, auto a_end, auto b, auto b_end, auto out, auto less) {
+                std::set_difference(a, a_end, b, b_end, out, less);
+            });
+        }
+
+        // O(chunks) - only values needing a destructor are visited
+        void clear() {
+            if constexpr (!std::is_trivially_destructible<Value>::value) {
+                destroy_values(root_);
+            }
+            leaves_.release();
+            internals_.release();
+            root_ = nullptr;
+            size_ = 0;
+        }
+
+        size_t size() const {
+            return size_;
+        }
+
+        // O(log n) - down the left edge
+        iterator begin() {
+            return iterator(leftmost(root_), 0, this);
+        }
+
+        const_iterator begin() const {
+            return const_iterator(leftmost(root_), 0, this);
+        }
+
+        // O(1)
+        iterator end() {
+            return iterator(nullptr, 0, this);
+        }
+
+        const_iterator end() const {
+            return const_iterator(nullptr, 0, this);
+        }
+
+        const Compare& key_comp() const {
+            return comp();
+        }
+
+        allocator_type get_allocator() const {
+            return Allocator(leaves_.allocator());
+        }
+
+    private:
+        using leaf_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<leaf_node>;
+        using internal_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<internal_node>;
+        using leaf_traits = std::allocator_traits<leaf_allocator>;
+
+        using compare_holder<Compare>::comp;
+
+        static const Key& key_of(const Value& value) {
+            return KeyOfValue()(value);
+        }
+
+        // index of the first value in n whose key is not less than key
+        template< typename K >
+        size_t lower_index(node_base* n, const K& key) const {
+            return bound_index<false>(n, key);
+        }
+
+        // index of the first value in n whose key is greater than key
+        template< typename K >
+        size_t upper_index(node_base* n, const K& key) const {
+            return bound_index<true>(n, key);
+        }
+
+        // counts the values in n that come before the bound - those less than
+        // key, or for Upper those not greater
+        template< bool Upper, typename K >
+        bool before_bound(const Value& value, const K& key) const {
+            if constexpr (Upper) {
+                return !comp()(key, key_of(value));
+            }
+            else {
+                return comp()(key_of(value), key);
+            }
+        }
+
+        template< bool Upper, typename K >
+        size_t bound_index(node_base* n, const K& key) const {
+            const Value* v = values(n);
+            if constexpr (std::is_arithmetic<Key>::value) {
+                // whole blocks of a fixed size first - a loop whose trip count is
+                // known is vectorised at -O2, not just -O3
+                constexpr size_t block = 16;
+                size_t before = 0;
+                size_t i = 0;
+                for (; i + block <= n->count; i += block) {
+                    for (size_t j = 0; j < block; ++j) {
+                        before += before_bound<Upper>(v[i + j], key);
+                    }
+                }
+                for (; i < n->count; ++i) {
+                    before += before_bound<Upper>(v[i], key);
+                }
+                return before;
+            }
+            else {
+                size_t first = 0;
+                size_t count = n->count;
+                while (count > 0) {
+                    size_t half = count / 2;
+                    if (before_bound<Upper>(v[first + half], key)) {
+                        first += half + 1;
+                        count -= half + 1;
+                    }
+                    else {
+                        count = half;
+                    }
+                }
+                return first;
+            }
+        }
+
+        // the node and index of the value with key, or a null node
+        template< typename K >
+        std::pair<node_base*, size_t> find_value(const K& key) const {
+            node_base* n = root_;
+            while (n != nullptr) {
+                size_t i = lower_index(n, key);
+                if (i < n->count && !comp()(key, key_of(values(n)[i]))) {
+                    return { n, i };
+                }
+                n = n->leaf ? nullptr : internal(n)->children[i];
+            }
+            return { nullptr, 0 };
+        }
+
+        // the node and index of the first value at or after the bound, or a null node
+        template< bool Upper, typename K >
+        std::pair<node_base*, size_t> bound_value(const K& key) const {
+            std::pair<node_base*, size_t> candidate{ nullptr, 0 };
+            node_base* n = root_;
+            while (n != nullptr) {
+                size_t i = bound_index<Upper>(n, key);
+                if (i < n->count) {
+                    candidate = { n, i };
+                }
+                n = n->leaf ? nullptr : internal(n)->children[i];
+            }
+            return candidate;
+        }
+
+        static node_base* leftmost(node_base* n) {
+            while (n && !n->leaf) {
+                n = internal(n)->children[0];
+            }
+            return n;
+        }
+
+        static node_base* rightmost(node_base* n) {
+            while (n && !n->leaf) {
+                n = internal(n)->children[n->count];
+            }
+            return n;
+        }
+
+        leaf_node* make_leaf() {
+            leaf_node* n = ::new (static_cast<void*>(leaves_.allocate())) leaf_node;
+            n->parent = nullptr;
+            n->size = 0;
+            n->count = 0;
+            n->position = 0;
+            n->leaf = true;
+            return n;
+        }
+
+        internal_node* make_internal() {
+            internal_node* n = ::new (static_cast<void*>(internals_.allocate())) internal_node;
+            n->parent = nullptr;
+            n->size = 0;
+            n->count = 0;
+            n->position = 0;
+            n->leaf = false;
+            return n;
+        }
+
+        // n's values have already been destroyed or moved out
+        void free_node(node_base* n) {
+            if (n->leaf) {
+                leaves_.deallocate(static_cast<leaf_node*>(n));
+            }
+            else {
+                internals_.deallocate(internal(n));
+            }
+        }
+
+        // The value is built through the allocator, so that a scoped allocator
+        // such as std::pmr::polymorphic_allocator reaches it too.
+        template< typename... Args >
+        void construct_value(Value* where, Args&&... args) {
+            leaf_traits::construct(leaves_.allocator(), where, std::forward<Args>(args)...);
+        }
+
+        void destroy_value(Value* where) {
+            leaf_traits::destroy(leaves_.allocator(), where);
+        }
+
+        // moves count values from src to dst, which may overlap, leaving src raw storage
+        void relocate(Value* src, size_t count, Value* dst) {
+            if (count == 0 || src == dst) {
+                return;
+            }
+            if constexpr (is_trivially_relocatable<Value>::value) {
+                std::memmove(static_cast<void*>(dst), src, count * sizeof(Value));
+            }
+            else if (std::less<Value*>()(dst, src)) {
+                for (size_t i = 0; i < count; ++i) {
+                    construct_value(dst + i, std::move(src[i]));
+                    destroy_value(src + i);
+                }
+            }
+            else {
+                for (size_t i = count; i-- > 0; ) {
+                    construct_value(dst + i, std::move(src[i]));
+                    destroy_value(src + i);
+                }
+            }
+        }
+
+        // moves count children from src to dst of parent n from index first, which
+        // may overlap, and tells them where they now are
+        static void move_children(node_base** src, size_t count, internal_node* n, size_t first) {
+            std::memmove(n->children + first, src, count * sizeof(node_base*));
+            for (size_t i = first; i < first + count; ++i) {
+                n->children[i]->parent = n;
+                n->children[i]->position = static_cast<unsigned short>(i);
+            }
+        }
+
+        // n is a leaf with room - the value goes in at index i
+        template< typename... Args >
+        void insert_value(node_base* n, size_t i, Args&&... args) {
+            Value* v = values(n);
+            relocate(v + i, n->count - i, v + i + 1);
+            try {
+                construct_value(v + i, std::forward<Args>(args)...);
+            }
+            catch (...) {
+                relocate(v + i + 1, n->count - i, v + i);
+                throw;
+            }
+            ++n->count;
+        }
+
+        /*
+        full child i of parent, 2t - 1 values, is split around its middle value:
+
+           [ .. p .. ]                  [ .. p  m .. ]
+                |            ->              |    \
+           [ a  m  b ]                     [ a ]  [ b ]
+        */
+        void split_child(internal_node* parent, size_t i) {
+            node_base* full = parent->children[i];
+            node_base* right = full->leaf ? static_cast<node_base*>(make_leaf()) : make_internal();
+            const size_t t = min_values + 1;
+
+            relocate(values(full) + t, min_values, values(right));
+            if (!full->leaf) {
+                move_children(internal(full)->children + t, t, internal(right), 0);
+            }
+            right->count = static_cast<unsigned short>(min_values);
+            right->size = min_values;
+            if (!full->leaf) {
+                for (size_t child = 0; child <= min_values; ++child) {
+                    right->size += internal(right)->children[child]->size;
+                }
+            }
+            full->size -= right->size + 1;
+
+            relocate(values(parent) + i, parent->count - i, values(parent) + i + 1);
+            move_children(parent->children + i + 1, parent->count - i, parent, i + 2);
+            relocate(values(full) + min_values, 1, values(parent) + i);
+            parent->children[i + 1] = right;
+            right->parent = parent;
+            right->position = static_cast<unsigned short>(i + 1);
+
+            full->count = static_cast<unsigned short>(min_values);
+            ++parent->count;
+        }
+
+        // n may have fallen below min_values.  Borrow a value from a sibling that
+        // can spare one, or merge with a sibling and carry on with the parent,
+        // which has lost a value.  A root left empty gives way to its only child.
+        void rebalance(node_base* n) {
+            while (n != root_ && n->count < min_values) {
+                internal_node* parent = n->parent;
+                size_t pos = n->position;
+                if (pos > 0 && parent->children[pos - 1]->count > min_values) {
+                    borrow_from_left(parent, pos);
+                    return;
+                }
+                if (pos < parent->count && parent->children[pos + 1]->count > min_values) {
+                    borrow_from_right(parent, pos);
+                    return;
+                }
+                merge_children(parent, pos > 0 ? pos - 1 : pos);
+                n = parent;
+            }
+
+            if (root_->count == 0) {
+                node_base* old = root_;
+                root_ = root_->leaf ? nullptr : internal(root_)->children[0];
+                if (root_) {
+                    root_->parent = nullptr;
+                    root_->position = 0;
+                }
+                free_node(old);
+            }
+        }
+
+        // the separator comes down to the front of child pos, and the left
+        // sibling's last value goes up to replace it
+        void borrow_from_left(internal_node* parent, size_t pos) {
+            node_base* n = parent->children[pos];
+            node_base* left = parent->children[pos - 1];
+
+            relocate(values(n), n->count, values(n) + 1);
+            relocate(values(parent) + pos - 1, 1, values(n));
+            relocate(values(left) + left->count - 1, 1, values(parent) + pos - 1);
+            if (!n->leaf) {
+                move_children(internal(n)->children, n->count + 1, internal(n), 1);
+                move_children(internal(left)->children + left->count, 1, internal(n), 0);
+            }
+            size_t moved = 1 + (n->leaf ? 0 : internal(n)->children[0]->size);
+            left->size -= moved;
+            n->size += moved;
+            --left->count;
+            ++n->count;
+        }
+
+        // mirror image of borrow_from_left
+        void borrow_from_right(internal_node* parent, size_t pos) {
+            node_base* n = parent->children[pos];
+            node_base* right = parent->children[pos + 1];
+
+            relocate(values(parent) + pos, 1, values(n) + n->count);
+            relocate(values(right), 1, values(parent) + pos);
+            relocate(values(right) + 1, right->count - 1, values(right));
+            if (!n->leaf) {
+                move_children(internal(right)->children, 1, internal(n), n->count + 1);
+                move_children(internal(right)->children + 1, right->count, internal(right), 0);
+            }
+            size_t moved = 1 + (n->leaf ? 0 : internal(n)->children[n->count + 1]->size);
+            right->size -= moved;
+            n->size += moved;
+            ++n->count;
+            --right->count;
+        }
+
+        // children i and i + 1 and the separator between them become child i
+        void merge_children(internal_node* parent, size_t i) {
+            node_base* left = parent->children[i];
+            node_base* right = parent->children[i + 1];
+
+            relocate(values(parent) + i, 1, values(left) + left->count);
+            relocate(values(right), right->count, values(left) + left->count + 1);
+            if (!left->leaf) {
+                move_children(internal(right)->children, right->count + 1, internal(left), left->count + 1);
+            }
+            left->count = static_cast<unsigned short>(left->count + 1 + right->count);
+            left->size += 1 + right->size;
+
+            relocate(values(parent) + i + 1, parent->count - i - 1, values(parent) + i);
+            move_children(parent->children + i + 2, parent->count - i - 1, parent, i + 1);
+            --parent->count;
+            free_node(right);
+        }
+
+        // the most values a subtree of this height can hold
+        static constexpr size_t capacity(size_t height) {
+            size_t values = max_values;
+            for (; height > 0 && values < std::numeric_limits<size_t>::max() / (max_values + 2); --height) {
+                values = (max_values + 1) * values + max_values;
+            }
+            return height > 0 ? std::numeric_limits<size_t>::max() : values;
+        }
+
+        // count values from first make a subtree of the given height: children
+        // and separators in turn.  If a value throws, the values built so far
+        // are destroyed, and assign_sorted releases their nodes.
+        template< typename InputIterator >
+        node_base* build_subtree(InputIterator& first, size_t count, size_t height) {
+            if (height == 0) {
+                node_base* leaf = make_leaf();
+                try {
+                    for (; leaf->count < count; ++leaf->count) {
+                        construct_value(values(leaf) + leaf->count, *first);
+                        ++first;
+                    }
+                }
+                catch (...) {
+                    destroy_values(leaf);
+                    throw;
+                }
+                leaf->size = count;
+                return leaf;
+            }
+
+            // as few children as will hold them, at least two
+            size_t below = capacity(height - 1);
+            size_t children = std::max<size_t>(2, (count + 1) / (below + 1) + ((count + 1) % (below + 1) != 0));
+            size_t shared = count - (children - 1);
+            internal_node* n = make_internal();
+            size_t linked = 0;
+            try {
+                while (linked < children) {
+                    size_t share = shared / children + (linked < shared % children);
+                    node_base* child = build_subtree(first, share, height - 1);
+                    n->children[linked] = child;
+                    child->parent = n;
+                    child->position = static_cast<unsigned short>(linked);
+                    ++linked;
+                    if (linked < children) {
+                        construct_value(values(n) + n->count, *first);
+                        ++first;
+                        ++n->count;
+                    }
+                }
+            }
+            catch (...) {
+                for (size_t i = 0; i < n->count; ++i) {
+                    destroy_value(values(n) + i);
+                }
+                for (size_t i = 0; i < linked; ++i) {
+                    destroy_values(n->children[i]);
+                }
+                throw;
+            }
+            n->size = count;
+            return n;
+        }
+
+        void swap_nodes(btree& other) noexcept {
+            leaves_.swap_storage(other.leaves_);
+            internals_.swap_storage(other.internals_);
+            std::swap(root_, other.root_);
+            std::swap(size_, other.size_);
+        }
+
+        template< typename Merge >
+        void combine(btree& other, Merge merge) {
+            std::vector<Value, Allocator> merged(get_allocator());
+            merged.reserve(size_ + other.size_);
+            auto less = [this](const Value& a, const Value& b) { return comp()(key_of(a), key_of(b)); };
+            merge(std::make_move_iterator(begin()), std::make_move_iterator(end()),
+                  std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()),
+                  std::back_inserter(merged), less);
+            other.clear();
+            assign_sorted(std::make_move_iterator(merged.begin()), merged.size());
+        }
+
+        // recursion depth is the height of the tree, which is log(n) to a base
+        // of about t, so a handful of levels
+        void destroy_values(node_base* n) {
+            if (n == nullptr) {
+                return;
+            }
+            for (size_t i = 0; i < n->count; ++i) {
+                destroy_value(values(n) + i);
+            }
+            if (!n->leaf) {
+                for (size_t i = 0; i <= n->count; ++i) {
+                    destroy_values(internal(n)->children[i]);
+                }
+            }
+        }
+
+
+        node_base* root_ = nullptr;
+        size_t size_ = 0;
+        node_pool<leaf_node, leaf_allocator> leaves_;
+        node_pool<internal_node, internal_allocator> internals_;
+    };
+
+    // ordered_set backend policy selecting the btree, with nodes of about
+    // NodeBytes, eg
+    //   wheel::ordered_set<int, std::less<int>, std::allocator<int>, wheel::btree_backend<>> s;
+    template< size_t NodeBytes = 256 >
+    struct btree_backend {
+        template< typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator >
+        using tree = btree<Key, Value, KeyOfValue, Compare, Allocator, NodeBytes>;
+    };
+
+}  // namespace wheel
+
+#endif // BTREE_HPP_
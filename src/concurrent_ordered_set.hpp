@@ -0,0 +1,545 @@
+/*
+An ordered set of unique keys that many threads can insert into, erase
+from and look up in at once, with no lock - for sharing one set between
+worker threads where an ordered_set behind a mutex would serialise them.
+
+It is a lock-free skiplist (Herlihy and Shavit, The Art of Multiprocessor
+Programming, chapter 14, after Fraser).  Every key sits in a sorted linked
+list, level 0, and each node also joins the lists of the levels above it
+with probability 1/2 per level, so a search skips along the sparse upper
+levels and drops down, O(log n) steps expected - the same shape of
+search as a balanced tree, but every change is a compare and swap on one
+link rather than a rebalance across many nodes.
+
+A key is inserted by linking it into level 0 with a compare and swap - at
+that moment it is in the set - and then into its upper levels.  It is
+erased by marking the low bit of each of its links, top down; marking the
+level 0 link is the moment it leaves the set.  Searches that pass a marked
+node unlink it.  find and contains never write, never retry, and never
+wait for anyone, so readers scale with the number of cores.
+
+Erased nodes are unlinked but not freed, as another thread may still be
+reading them, so the set's memory grows with the keys ever inserted, not
+the keys in it.  Their memory comes back at collect(), which frees just the
+erased nodes, at clear() or when the set is destroyed.  All three need the
+set to themselves - call collect() at a quiet moment, say between batches
+of work, once the threads using the set have been joined.  The allocator is
+called from every inserting thread, so must be thread safe - std::allocator
+is.
+
+Iterators see the keys in order, skipping erased ones.  They stay valid
+while other threads insert and erase, but a traversal during changes sees
+some mix of the before and after.
+
+Operation       Speed
+insert          O(log n)  // expected
+erase           O(log n)  // expected
+find, contains  O(log n)  // expected, wait free
+lower_bound     O(log n)
+size            O(1)      // a snapshot
+begin, ++       O(1)
+collect         O(nodes held)  // the keys in the set and those erased since
+clear           O(nodes held)  // the last collect
+*/
+
+#ifndef CONCURRENT_ORDERED_SET_HPP_
+#define CONCURRENT_ORDERED_SET_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+#include "rb_tree.hpp"   // compare_holder
+
+namespace wheel {  // as in re-inventing the wheel
+
+    template< typename Key, typename Compare = std::less<Key>, typename Allocator = std::allocator<Key> >
+    class concurrent_ordered_set : private compare_holder<Compare> {
+
+        // the most levels a node can have - enough for 2^32 keys
+        static constexpr unsigned max_height = 32;
+
+        // A link is a node pointer with the low bit set once the node holding
+        // the link is being erased - then it can no longer be changed.
+        using link = std::uintptr_t;
+
+        // a node's links follow it in the same block, as many as its height
+        struct node {
+            node(unsigned levels, node* previous) : height(levels), older(previous) {
+                for (unsigned level = 0; level < height; ++level) {
+                    ::new (static_cast<void*>(next() + level)) std::atomic<link>(0);
+                }
+            }
+
+            std::atomic<link>* next() noexcept {
+                return std::launder(reinterpret_cast<std::atomic<link>*>(this + 1));
+            }
+
+            alignas(Key) unsigned char storage[sizeof(Key)];
+            unsigned height;
+            node* older;       // every node not yet freed, newest first, for collect() and clear()
+
+            const Key& key() noexcept {
+                return *std::launder(reinterpret_cast<Key*>(storage));
+            }
+        };
+
+        static node* pointer(link l) noexcept {
+            return reinterpret_cast<node*>(l & ~link(1));
+        }
+
+        static bool marked(link l) noexcept {
+            return (l & 1) != 0;
+        }
+
+        static link unmarked(node* n) noexcept {
+            return reinterpret_cast<link>(n);
+        }
+
+        struct alignas(node) unit {
+            unsigned char bytes[alignof(node)];
+        };
+
+        using unit_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<unit>;
+        using unit_traits = std::allocator_traits<unit_allocator>;
+        using key_traits = std::allocator_traits<Allocator>;
+
+    public:
+        using key_type = Key;
+        using value_type = Key;
+        using key_compare = Compare;
+        using allocator_type = Allocator;
+
+        // forward, along level 0, over the keys not erased
+        class const_iterator {
+        public:
+            using value_type = Key;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Key*;
+            using reference = const Key&;
+            using iterator_category = std::forward_iterator_tag;
+
+            constexpr const_iterator() noexcept = default;
+            explicit const_iterator(node* n) noexcept : ptr_{ n } {}
+
+            const_iterator& operator++() {
+                ptr_ = live_from(concurrent_ordered_set::pointer(ptr_->next()[0].load(std::memory_order_acquire)));
+                return *this;
+            }
+
+            const_iterator operator++(int) {
+                auto old = *this;
+                ++*this;
+                return old;
+            }
+
+            const Key& operator*() const { return ptr_->key(); }
+            const Key* operator->() const { return &ptr_->key(); }
+
+            bool operator==(const const_iterator& other) const { return ptr_ == other.ptr_; }
+            bool operator!=(const const_iterator& other) const { return ptr_ != other.ptr_; }
+
+        private:
+            node* ptr_ = nullptr;
+        };
+
+        // keys can't be changed in place, that could break the order
+        using iterator = const_iterator;
+
+        concurrent_ordered_set() : concurrent_ordered_set(Compare()) {}
+
+        explicit concurrent_ordered_set(const Compare& comp, const Allocator& alloc = Allocator())
+            : compare_holder<Compare>(comp), alloc_(alloc) {
+            for (unsigned level = 0; level < max_height; ++level) {
+                head_[level].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        explicit concurrent_ordered_set(const Allocator& alloc) : concurrent_ordered_set(Compare(), alloc) {}
+
+        template< typename InputIterator, typename = typename std::iterator_traits<InputIterator>::iterator_category >
+        concurrent_ordered_set(InputIterator first, InputIterator last, const Compare& comp = Compare(),
+                               const Allocator& alloc = Allocator())
+            : concurrent_ordered_set(comp, alloc) {
+            for (; first != last; ++first) {
+                insert(*first);
+            }
+        }
+
+        concurrent_ordered_set(std::initializer_list<Key> init, const Compare& comp = Compare(),
+                               const Allocator& alloc = Allocator())
+            : concurrent_ordered_set(init.begin(), init.end(), comp, alloc) {}
+
+        concurrent_ordered_set(const concurrent_ordered_set&) = delete;
+        concurrent_ordered_set& operator=(const concurrent_ordered_set&) = delete;
+
+        ~concurrent_ordered_set() {
+            clear();
+        }
+
+        // Returns a pair consisting of an iterator to the inserted element (or
+        // to the element that prevented the insertion) and a bool value set to
+        // true if the insertion took place.
+        std::pair<iterator, bool> insert(const Key& key) {
+            return insert_key(key, key);
+        }
+
+        std::pair<iterator, bool> insert(Key&& key) {
+            return insert_key(key, std::move(key));
+        }
+
+        // returns the number of keys removed, 0 or 1 - 0 also if another
+        // thread erased the key first.  The node is unlinked but not freed
+        // until collect(), clear() or the destructor, so memory grows with the
+        // keys ever inserted, not the size of the set.
+        size_t erase(const Key& key) {
+            std::atomic<link>* preds[max_height];
+            node* succs[max_height];
+            if (!search(key, preds, succs)) {
+                return 0;
+            }
+            node* victim = succs[0];
+
+            // the upper levels first, so no search can reach the node from above
+            // once it has left level 0
+            for (unsigned level = victim->height; level-- > 1; ) {
+                link next = victim->next()[level].load(std::memory_order_acquire);
+                while (!marked(next)) {
+                    victim->next()[level].compare_exchange_weak(next, next | 1, std::memory_order_acq_rel);
+                }
+            }
+            link next = victim->next()[0].load(std::memory_order_acquire);
+            for (;;) {
+                if (marked(next)) {
+                    return 0;  // someone else erased it
+                }
+                if (victim->next()[0].compare_exchange_weak(next, next | 1, std::memory_order_acq_rel)) {
+                    size_.fetch_sub(1, std::memory_order_relaxed);
+                    search(key, preds, succs);  // unlinks it
+                    return 1;
+                }
+            }
+        }
+
+        // wait free - never writes, never retries
+        iterator find(const Key& key) const {
+            node* candidate = first_not_less(key);
+            if (candidate != nullptr && !comp()(key, candidate->key())) {
+                return iterator(candidate);
+            }
+            return end();
+        }
+
+        bool contains(const Key& key) const {
+            return find(key) != end();
+        }
+
+        size_t count(const Key& key) const {
+            return contains(key) ? 1 : 0;
+        }
+
+        // the first key not less than key
+        iterator lower_bound(const Key& key) const {
+            return iterator(first_not_less(key));
+        }
+
+        // the number of keys, as it was at some moment during the call
+        size_t size() const {
+            return size_.load(std::memory_order_relaxed);
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        iterator begin() const {
+            return iterator(live_from(pointer(head_[0].load(std::memory_order_acquire))));
+        }
+
+        iterator end() const {
+            return iterator();
+        }
+
+        const_iterator cbegin() const {
+            return begin();
+        }
+
+        const_iterator cend() const {
+            return end();
+        }
+
+        // O(nodes held) - frees the nodes of erased keys, which erase leaves
+        // for us.  No other thread may be using the set, and iterators to
+        // erased keys are invalidated.  Returns the number of nodes freed.
+        size_t collect() {
+            // a search unlinks an erased node only when it passes it, so some
+            // may still be linked - unlink them at every level first
+            for (unsigned level = 0; level < max_height; ++level) {
+                std::atomic<link>* pred_link = head_ + level;
+                node* curr = pointer(pred_link->load(std::memory_order_acquire));
+                while (curr != nullptr) {
+                    link next = curr->next()[level].load(std::memory_order_acquire);
+                    if (marked(next)) {
+                        pred_link->store(next & ~link(1), std::memory_order_relaxed);
+                    }
+                    else {
+                        pred_link = curr->next() + level;
+                    }
+                    curr = pointer(next);
+                }
+            }
+
+            // then free them, keeping the rest for clear()
+            size_t freed = 0;
+            node* kept = nullptr;
+            node** tail = &kept;
+            node* n = all_.load(std::memory_order_acquire);
+            while (n) {
+                node* older = n->older;
+                if (marked(n->next()[0].load(std::memory_order_relaxed))) {
+                    destroy_node(n);
+                    ++freed;
+                }
+                else {
+                    *tail = n;
+                    tail = &n->older;
+                }
+                n = older;
+            }
+            *tail = nullptr;
+            all_.store(kept, std::memory_order_relaxed);
+            return freed;
+        }
+
+        // O(nodes held) - no other thread may be using the set
+        void clear() {
+            node* n = all_.load(std::memory_order_acquire);
+            while (n) {
+                node* older = n->older;
+                destroy_node(n);
+                n = older;
+            }
+            all_.store(nullptr, std::memory_order_relaxed);
+            for (unsigned level = 0; level < max_height; ++level) {
+                head_[level].store(0, std::memory_order_relaxed);
+            }
+            size_.store(0, std::memory_order_relaxed);
+        }
+
+        key_compare key_comp() const {
+            return comp();
+        }
+
+        allocator_type get_allocator() const {
+            return alloc_;
+        }
+
+    private:
+        using compare_holder<Compare>::comp;
+
+        // the first node at or after n whose level 0 link is not marked
+        static node* live_from(node* n) noexcept {
+            while (n != nullptr) {
+                link next = n->next()[0].load(std::memory_order_acquire);
+                if (!marked(next)) {
+                    return n;
+                }
+                n = pointer(next);
+            }
+            return nullptr;
+        }
+
+        // the links at level of whatever precedes - a node, or the head
+        std::atomic<link>* links_of(node* n) const noexcept {
+            return n ? n->next() : head_;
+        }
+
+        // Walks down from the top level, recording at each level the link
+        // that leads to the first node not less than key (preds) and that
+        // node (succs), and unlinking any marked nodes on the way.  If an
+        // unlink fails the links have moved under us, so start again.
+        // True if the level 0 successor holds key.
+        bool search(const Key& key, std::atomic<link>** preds, node** succs) {
+            for (;;) {
+                bool restart = false;
+                node* pred = nullptr;   // the head
+                node* curr = nullptr;
+                for (unsigned level = max_height; level-- > 0 && !restart; ) {
+                    std::atomic<link>* pred_link = links_of(pred) + level;
+                    curr = pointer(pred_link->load(std::memory_order_acquire));
+                    while (curr != nullptr) {
+                        link next = curr->next()[level].load(std::memory_order_acquire);
+                        if (marked(next)) {
+                            link expected = unmarked(curr);
+                            if (!pred_link->compare_exchange_strong(expected, next & ~link(1), std::memory_order_acq_rel)) {
+                                restart = true;
+                                break;
+                            }
+                            curr = pointer(next);
+                        }
+                        else if (comp()(curr->key(), key)) {
+                            pred = curr;
+                            pred_link = curr->next() + level;
+                            curr = pointer(next);
+                        }
+                        else {
+                            break;
+                        }
+                    }
+                    preds[level] = pred_link;
+                    succs[level] = curr;
+                }
+                if (!restart) {
+                    return curr != nullptr && !comp()(key, curr->key());
+                }
+            }
+        }
+
+        // as search, but without unlinking anything - marked nodes are just
+        // stepped over
+        node* first_not_less(const Key& key) const {
+            node* pred = nullptr;
+            node* curr = nullptr;
+            for (unsigned level = max_height; level-- > 0; ) {
+                curr = pointer(links_of(pred)[level].load(std::memory_order_acquire));
+                while (curr != nullptr) {
+                    link next = curr->next()[level].load(std::memory_order_acquire);
+                    if (marked(next)) {
+                        curr = pointer(next);
+                    }
+                    else if (comp()(curr->key(), key)) {
+                        pred = curr;
+                        curr = pointer(next);
+                    }
+                    else {
+                        break;
+                    }
+                }
+            }
+            return curr;
+        }
+
+        template< typename Arg >
+        std::pair<iterator, bool> insert_key(const Key& key, Arg&& value) {
+            std::atomic<link>* preds[max_height];
+            node* succs[max_height];
+            node* fresh = nullptr;
+            const Key* probe = &key;   // value may be moved from, so once built use the node's key
+            for (;;) {
+                if (search(*probe, preds, succs)) {
+                    if (fresh) {
+                        destroy_node(fresh);   // never published, so no one can see it
+                    }
+                    return { iterator(succs[0]), false };
+                }
+                if (fresh == nullptr) {
+                    fresh = make_node(random_height(), std::forward<Arg>(value));
+                    probe = &fresh->key();
+                }
+                for (unsigned level = 0; level < fresh->height; ++level) {
+                    fresh->next()[level].store(unmarked(succs[level]), std::memory_order_relaxed);
+                }
+                link expected = unmarked(succs[0]);
+                if (preds[0]->compare_exchange_strong(expected, unmarked(fresh), std::memory_order_acq_rel)) {
+                    break;
+                }
+            }
+
+            // in the set now - remember it for collect() and clear(), then link
+            // the upper levels
+            node* previous = all_.load(std::memory_order_relaxed);
+            do {
+                fresh->older = previous;
+            } while (!all_.compare_exchange_weak(previous, fresh, std::memory_order_release, std::memory_order_relaxed));
+            size_.fetch_add(1, std::memory_order_relaxed);
+
+            for (unsigned level = 1; level < fresh->height; ++level) {
+                for (;;) {
+                    // if an erase has started on it, it need not go any higher
+                    link next = fresh->next()[level].load(std::memory_order_acquire);
+                    if (marked(next)) {
+                        return { iterator(fresh), true };
+                    }
+                    if (pointer(next) != succs[level]
+                        && !fresh->next()[level].compare_exchange_strong(next, unmarked(succs[level]), std::memory_order_acq_rel)) {
+                        continue;
+                    }
+                    link expected = unmarked(succs[level]);
+                    if (preds[level]->compare_exchange_strong(expected, unmarked(fresh), std::memory_order_acq_rel)) {
+                        break;
+                    }
+                    search(*probe, preds, succs);
+                    if (succs[0] != fresh) {
+                        return { iterator(fresh), true };  // erased meanwhile
+                    }
+                }
+            }
+            return { iterator(fresh), true };
+        }
+
+        // 1 + the number of heads in a row from a per thread xorshift
+        static unsigned random_height() {
+            static thread_local std::uint64_t state =
+                0x9e3779b97f4a7c15ull ^ reinterpret_cast<std::uintptr_t>(&state);
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            std::uint64_t bits = state | (std::uint64_t(1) << (max_height - 1));
+            unsigned height = 1;
+            while ((bits & 1) == 0) {
+                ++height;
+                bits >>= 1;
+            }
+            return height;
+        }
+
+        static size_t units_for(unsigned height) {
+            return (sizeof(node) + height * sizeof(std::atomic<link>) + sizeof(unit) - 1) / sizeof(unit);
+        }
+
+        template< typename Arg >
+        node* make_node(unsigned height, Arg&& value) {
+            unit_allocator units(alloc_);
+            unit* block = unit_traits::allocate(units, units_for(height));
+            node* n = ::new (static_cast<void*>(block)) node(height, nullptr);
+            try {
+                key_traits::construct(alloc_, reinterpret_cast<Key*>(n->storage), std::forward<Arg>(value));
+            }
+            catch (...) {
+                unit_traits::deallocate(units, block, units_for(height));
+                throw;
+            }
+            return n;
+        }
+
+        void destroy_node(node* n) {
+            unsigned height = n->height;
+            key_traits::destroy(alloc_, std::launder(reinterpret_cast<Key*>(n->storage)));
+            unit_allocator units(alloc_);
+            unit_traits::deallocate(units, reinterpret_cast<unit*>(n), units_for(height));
+        }
+
+        mutable std::atomic<link> head_[max_height];
+        std::atomic<node*> all_{ nullptr };
+        std::atomic<size_t> size_{ 0 };
+        Allocator alloc_;
+    };
+
+    namespace pmr {
+        // the memory_resource must be thread safe, eg
+        //   std::pmr::synchronized_pool_resource pool;
+        //   wheel::pmr::concurrent_ordered_set<int> s(&pool);
+        template< typename Key, typename Compare = std::less<Key> >
+        using concurrent_ordered_set = wheel::concurrent_ordered_set<Key, Compare, std::pmr::polymorphic_allocator<Key>>;
+    }
+
+}  // namespace wheel
+
+#endif // CONCURRENT_ORDERED_SET_HPP_
@@ -0,0 +1,328 @@
+#ifndef CONCURRENT_QUEUE_HPP_
+#define CONCURRENT_QUEUE_HPP_
+
+/*
+A bounded first in first out queue that any number of threads can push to
+and pop from at once, without locks - for handing work between threads
+where a wheel::list behind a mutex would be the bottleneck.
+
+The queue is Dmitry Vyukov's bounded MPMC queue: a ring of cells, each
+holding a T and a sequence number that says whose turn the cell is.  A
+producer claims the cell at the enqueue position with one compare and
+swap, builds its T there, then bumps the cell's sequence so that the
+consumer of that position may take it.  Consumers do the same at the
+dequeue position and bump the sequence on by a lap of the ring, so the
+producer one lap later may reuse it.  Producers and consumers only meet at
+the cell they both want, and the two positions sit on cache lines of their
+own.  No node is ever allocated after construction, so there is nothing to
+reclaim.
+
+The try_ functions never wait: they return false (or 0) when the queue is
+full or empty.  The batch versions claim a run of cells with a single
+compare and swap, so a thread moving many values pays for the contention
+once rather than per value.
+
+Operation       Speed
+push, pop       O(1)  // lock free - a thread can only fail if another succeeded
+push_batch      O(k)  // one compare and swap for k values
+size            O(1)  // a snapshot, may be stale by the time it is read
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace wheel {  // as in re-inventing the wheel
+
+	template< typename T, typename Allocator = std::allocator<T> >
+	class concurrent_queue {
+
+		struct cell {
+			std::atomic<size_t> sequence;
+			alignas(T) unsigned char storage[sizeof(T)];
+
+			T* value() noexcept {
+				return std::launder(reinterpret_cast<T*>(storage));
+			}
+		};
+
+		using cell_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<cell>;
+		using cell_traits = std::allocator_traits<cell_allocator>;
+		using value_traits = std::allocator_traits<Allocator>;
+
+	public:
+		using value_type = T;
+		using allocator_type = Allocator;
+
+		// room for capacity values, rounded up to a power of two
+		explicit concurrent_queue(size_t capacity, const Allocator& alloc = Allocator())
+			: alloc_(alloc) {
+			size_t slots = 2;
+			while (slots < capacity) {
+				slots *= 2;
+			}
+			mask_ = slots - 1;
+			cell_allocator cells(alloc_);
+			cells_ = cell_traits::allocate(cells, slots);
+			for (size_t i = 0; i < slots; ++i) {
+				::new (static_cast<void*>(cells_ + i)) cell;
+				cells_[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		concurrent_queue(const concurrent_queue&) = delete;
+		concurrent_queue& operator=(const concurrent_queue&) = delete;
+
+		// O(n) - no other thread may be using the queue
+		~concurrent_queue() {
+			clear();
+			cell_allocator cells(alloc_);
+			cell_traits::deallocate(cells, cells_, mask_ + 1);
+		}
+
+		size_t capacity() const noexcept {
+			return mask_ + 1;
+		}
+
+		// how many values were queued at some moment during the call
+		size_t size() const noexcept {
+			size_t popped = dequeue_pos_.load(std::memory_order_acquire);
+			size_t pushed = enqueue_pos_.load(std::memory_order_acquire);
+			return pushed > popped ? pushed - popped : 0;
+		}
+
+		bool empty() const noexcept {
+			return size() == 0;
+		}
+
+		allocator_type get_allocator() const {
+			return alloc_;
+		}
+
+		bool try_push(const T& value) {
+			return try_emplace(value);
+		}
+
+		bool try_push(T&& value) {
+			return try_emplace(std::move(value));
+		}
+
+		// false, with args untouched, if the queue is full.  If the constructor
+		// throws, the claimed cell is handed on empty, as a hole that try_pop
+		// skips, and the exception propagates.
+		template< typename... Args >
+		bool try_emplace(Args&&... args) {
+			size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+			for (;;) {
+				cell& c = cells_[pos & mask_];
+				size_t sequence = c.sequence.load(std::memory_order_acquire);
+				if (sequence == pos) {
+					if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						fill(c, pos, std::forward<Args>(args)...);
+						return true;
+					}
+				}
+				else if (still_last_lap(sequence, pos)) {
+					return false;  // the consumer a lap behind has not emptied it - full
+				}
+				else {
+					pos = enqueue_pos_.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		// moves the oldest value into out, or returns false if empty - if the
+		// assignment throws, the value is destroyed
+		bool try_pop(T& out) {
+			size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+			for (;;) {
+				cell& c = cells_[pos & mask_];
+				size_t sequence = c.sequence.load(std::memory_order_acquire);
+				if (sequence == pos + 1 || sequence == pos + hole) {
+					if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						if (take(c, pos, out)) {
+							return true;
+						}
+						pos = dequeue_pos_.load(std::memory_order_relaxed);
+					}
+				}
+				else if (sequence < pos + 1) {
+					return false;  // no producer has filled it yet - empty
+				}
+				else {
+					pos = dequeue_pos_.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		// Pushes from [first, last) while there is room, claiming the run of
+		// free cells in one go.  Returns how many were pushed - the first ones.
+		template< typename ForwardIterator >
+		size_t try_push_batch(ForwardIterator first, ForwardIterator last) {
+			size_t wanted = static_cast<size_t>(std::distance(first, last));
+			size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+			for (;;) {
+				size_t free = 0;
+				while (free < wanted && free <= mask_
+				       && cells_[(pos + free) & mask_].sequence.load(std::memory_order_acquire) == pos + free) {
+					++free;
+				}
+				if (free == 0) {
+					size_t sequence = cells_[pos & mask_].sequence.load(std::memory_order_acquire);
+					if (still_last_lap(sequence, pos)) {
+						return 0;
+					}
+					pos = enqueue_pos_.load(std::memory_order_relaxed);
+					continue;
+				}
+				if (enqueue_pos_.compare_exchange_weak(pos, pos + free, std::memory_order_relaxed)) {
+					size_t i = 0;
+					try {
+						for (; i < free; ++i, ++first) {
+							fill(cells_[(pos + i) & mask_], pos + i, *first);
+						}
+					}
+					catch (...) {
+						// the rest of the run is ours too, so hand it on as holes
+						for (++i; i < free; ++i) {
+							cells_[(pos + i) & mask_].sequence.store(pos + i + hole, std::memory_order_release);
+						}
+						throw;
+					}
+					return free;
+				}
+			}
+		}
+
+		// Moves up to most of the oldest values to out, claiming them in one
+		// go.  Returns how many were popped.  If assigning to out throws, the
+		// values this call claimed but had not yet moved are destroyed.
+		template< typename OutputIterator >
+		size_t try_pop_batch(OutputIterator out, size_t most) {
+			size_t popped = 0;
+			while (popped < most) {
+				size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+				size_t ready = 0;
+				for (;;) {
+					ready = 0;
+					while (ready < most - popped && ready <= mask_ && is_full(pos + ready)) {
+						++ready;
+					}
+					if (ready == 0) {
+						size_t sequence = cells_[pos & mask_].sequence.load(std::memory_order_acquire);
+						if (sequence < pos + 1) {
+							return popped;
+						}
+						pos = dequeue_pos_.load(std::memory_order_relaxed);
+						continue;
+					}
+					if (dequeue_pos_.compare_exchange_weak(pos, pos + ready, std::memory_order_relaxed)) {
+						break;
+					}
+				}
+				size_t i = 0;
+				try {
+					for (; i < ready; ++i) {
+						if (take(cells_[(pos + i) & mask_], pos + i, *out)) {
+							++out;
+							++popped;
+						}
+					}
+				}
+				catch (...) {
+					for (++i; i < ready; ++i) {
+						discard(cells_[(pos + i) & mask_], pos + i);
+					}
+					throw;
+				}
+			}
+			return popped;
+		}
+
+		// O(n) - pops and destroys everything queued
+		void clear() {
+			size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+			while (is_full(pos)) {
+				discard(cells_[pos & mask_], pos);
+				++pos;
+			}
+			dequeue_pos_.store(pos, std::memory_order_relaxed);
+		}
+
+	private:
+		// sequence of a cell whose producer's constructor threw - pos + hole
+		// is never a value a live cell can have, as hole > capacity
+		static constexpr size_t hole = static_cast<size_t>(1) << (sizeof(size_t) * 8 - 2);
+
+		// true if a cell the producer at pos wants still holds the previous
+		// lap's value, or its hole - the queue is full.  A hole of this lap,
+		// pos + hole, means another producer got there first.
+		bool still_last_lap(size_t sequence, size_t pos) const noexcept {
+			return sequence < pos || sequence == pos - capacity() + hole;
+		}
+
+		bool is_full(size_t pos) const noexcept {
+			size_t sequence = cells_[pos & mask_].sequence.load(std::memory_order_acquire);
+			return sequence == pos + 1 || sequence == pos + hole;
+		}
+
+		template< typename... Args >
+		void fill(cell& c, size_t pos, Args&&... args) {
+			try {
+				value_traits::construct(alloc_, c.value(), std::forward<Args>(args)...);
+			}
+			catch (...) {
+				c.sequence.store(pos + hole, std::memory_order_release);
+				throw;
+			}
+			c.sequence.store(pos + 1, std::memory_order_release);
+		}
+
+		// false if the cell was a hole - it is released for the producer a
+		// lap on either way, even if the assignment throws
+		template< typename Out >
+		bool take(cell& c, size_t pos, Out&& out) {
+			bool filled = c.sequence.load(std::memory_order_relaxed) == pos + 1;
+			if (filled) {
+				try {
+					out = std::move(*c.value());
+				}
+				catch (...) {
+					discard(c, pos);
+					throw;
+				}
+				value_traits::destroy(alloc_, c.value());
+			}
+			c.sequence.store(pos + mask_ + 1, std::memory_order_release);
+			return filled;
+		}
+
+		void discard(cell& c, size_t pos) noexcept {
+			if (c.sequence.load(std::memory_order_relaxed) == pos + 1) {
+				value_traits::destroy(alloc_, c.value());
+			}
+			c.sequence.store(pos + mask_ + 1, std::memory_order_release);
+		}
+
+		// apart, so producers and consumers do not fight over one cache line
+		alignas(64) std::atomic<size_t> enqueue_pos_{ 0 };
+		alignas(64) std::atomic<size_t> dequeue_pos_{ 0 };
+		alignas(64) cell* cells_ = nullptr;
+		size_t mask_ = 0;
+		Allocator alloc_;
+	};
+
+	namespace pmr {
+		// queue whose ring comes from a std::pmr::memory_resource
+		template< typename T >
+		using concurrent_queue = wheel::concurrent_queue<T, std::pmr::polymorphic_allocator<T>>;
+	}
+
+}  // namespace wheel
+
+#endif // CONCURRENT_QUEUE_HPP_
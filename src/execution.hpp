@@ -0,0 +1,64 @@
+/*
+Execution policies for the wheel parallel algorithms, after
+std::execution::seq, par and par_unseq.
+
+seq runs the plain standard algorithm on the calling thread.  par splits
+the range into chunks and runs them on a thread_pool - the shared one, or
+any other with par.on(pool).  par_unseq is par that also promises the
+element operations may be interleaved on one thread, which is what lets
+the compiler vectorise the loop over each chunk.
+*/
+
+#ifndef EXECUTION_HPP_
+#define EXECUTION_HPP_
+
+#include <type_traits>
+
+#include "thread_pool.hpp"
+
+namespace wheel {  // as in re-inventing the wheel
+namespace execution {
+
+    struct sequenced_policy {};
+
+    struct parallel_policy {
+        thread_pool* pool = nullptr;  // nullptr - thread_pool::shared()
+
+        constexpr parallel_policy on(thread_pool& p) const {
+            return parallel_policy{ &p };
+        }
+    };
+
+    struct parallel_unsequenced_policy {
+        thread_pool* pool = nullptr;
+
+        constexpr parallel_unsequenced_policy on(thread_pool& p) const {
+            return parallel_unsequenced_policy{ &p };
+        }
+    };
+
+    constexpr sequenced_policy seq{};
+    constexpr parallel_policy par{};
+    constexpr parallel_unsequenced_policy par_unseq{};
+
+}  // namespace execution
+
+    template< typename T >
+    struct is_execution_policy : std::false_type {};
+
+    template<> struct is_execution_policy<execution::sequenced_policy> : std::true_type {};
+    template<> struct is_execution_policy<execution::parallel_policy> : std::true_type {};
+    template<> struct is_execution_policy<execution::parallel_unsequenced_policy> : std::true_type {};
+
+    // the pool a policy runs on
+    inline thread_pool& pool_of(const execution::parallel_policy& policy) {
+        return policy.pool ? *policy.pool : thread_pool::shared();
+    }
+
+    inline thread_pool& pool_of(const execution::parallel_unsequenced_policy& policy) {
+        return policy.pool ? *policy.pool : thread_pool::shared();
+    }
+
+}  // namespace wheel
+
+#endif // EXECUTION_HPP_
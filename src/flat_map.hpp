@@ -0,0 +1,261 @@
+/*
+An ordered map of unique keys to values in one sorted array, with the same
+interface as ordered_map.
+
+flat_set's sibling - the same array (flat_tree.hpp), of std::pair<Key, T>
+ordered by the first member.  Unlike ordered_map the key is not const,
+because values are moved about within the array as it changes - so do not
+change a key through an iterator, that would break the order.  Any insert
+or erase invalidates all iterators.
+
+Keys are ordered by Compare.  If Compare is transparent (has an
+is_transparent member type, as std::less<> does) find, at and erase also
+accept anything Compare can compare with a Key, without building a Key
+first.
+
+Operation       Speed
+insert          O(n)
+insert range    O(n + k log k)  // for k values
+operator[]      O(log n) if the key is there, O(n) if not
+find, at        O(log n)
+erase           O(n)
+begin           O(1)
+++, --          O(1)
+clear           O(1), O(n) if keys or values have a destructor
+*/
+
+#ifndef FLAT_MAP_HPP_
+#define FLAT_MAP_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#include "flat_tree.hpp"
+
+namespace wheel {  // as in re-inventing the wheel
+
+    template< typename Key, typename T, typename Compare = std::less<Key>,
+              typename Allocator = std::allocator<std::pair<Key, T>> >
+    class flat_map {
+        using tree_type = flat_tree<Key, std::pair<Key, T>, first_key, Compare, Allocator>;
+
+    public:
+
+        using key_type = Key;
+        using mapped_type = T;
+        using value_type = std::pair<Key, T>;
+        using key_compare = Compare;
+        using allocator_type = Allocator;
+        using iterator = typename tree_type::iterator;
+        using const_iterator = typename tree_type::const_iterator;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        flat_map() = default;
+
+        explicit flat_map(const Allocator& alloc) : tree_(Compare(), alloc) {}
+
+        explicit flat_map(const Compare& comp, const Allocator& alloc = Allocator()) : tree_(comp, alloc) {}
+
+        template< typename InputIterator, typename = typename std::iterator_traits<InputIterator>::iterator_category >
+        flat_map(InputIterator first, InputIterator last, const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+            : tree_(comp, alloc) {
+            insert(first, last);
+        }
+
+        flat_map(std::initializer_list<value_type> init, const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+            : tree_(comp, alloc) {
+            insert(init.begin(), init.end());
+        }
+
+        // O(n) - as for ordered_map, the iterator is to the inserted element or
+        // to the one with the same key that prevented the insertion
+        std::pair<iterator, bool> insert(const value_type& value) {
+            return tree_.try_emplace(value.first, value);
+        }
+
+        std::pair<iterator, bool> insert(value_type&& value) {
+            return tree_.try_emplace(value.first, std::move(value));
+        }
+
+        // O(n + k log k) - sorted on their own and merged in, in one pass.  The
+        // first of equivalent keys is kept, and a key already in the map keeps
+        // its value.
+        template< typename InputIterator, typename = typename std::iterator_traits<InputIterator>::iterator_category >
+        void insert(InputIterator first, InputIterator last) {
+            tree_.insert_range(first, last);
+        }
+
+        void insert(std::initializer_list<value_type> init) {
+            insert(init.begin(), init.end());
+        }
+
+        // O(n) - the mapped value is only constructed, from args, if key is new
+        template< typename... Args >
+        std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+            return tree_.try_emplace(key, std::piecewise_construct,
+                std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+
+        // inserts a value initialised T if key is new
+        T& operator[](const Key& key) {
+            return try_emplace(key).first->second;
+        }
+
+        T& operator[](Key&& key) {
+            auto result = tree_.try_emplace(key, std::piecewise_construct,
+                std::forward_as_tuple(std::move(key)), std::tuple<>());
+            return result.first->second;
+        }
+
+        // O(log n) - throws std::out_of_range if key is not in the map
+        T& at(const Key& key) {
+            return checked(tree_.find(key));
+        }
+
+        const T& at(const Key& key) const {
+            return checked(tree_.find(key));
+        }
+
+        template< typename K, typename C = Compare, typename = typename C::is_transparent >
+        T& at(const K& key) {
+            return checked(tree_.find(key));
+        }
+
+        template< typename K, typename C = Compare, typename = typename C::is_transparent >
+        const T& at(const K& key) const {
+            return checked(tree_.find(key));
+        }
+
+        // O(log n)
+        iterator find(const Key& key) {
+            return tree_.find(key);
+        }
+
+        const_iterator find(const Key& key) const {
+            return tree_.find(key);
+        }
+
+        template< typename K, typename C = Compare, typename = typename C::is_transparent >
+        iterator find(const K& key) {
+            return tree_.find(key);
+        }
+
+        template< typename K, typename C = Compare, typename = typename C::is_transparent >
+        const_iterator find(const K& key) const {
+            return tree_.find(key);
+        }
+
+        // O(n) - returns the number of elements removed, 0 or 1
+        size_t erase(const Key& key) {
+            return tree_.erase(key);
+        }
+
+        template< typename K, typename C = Compare, typename = typename C::is_transparent >
+        size_t erase(const K& key) {
+            return tree_.erase(key);
+        }
+
+        void clear() {
+            tree_.clear();
+        }
+
+        size_t size() const {
+            return tree_.size();
+        }
+
+        bool empty() const {
+            return tree_.size() == 0;
+        }
+
+        key_compare key_comp() const {
+            return tree_.key_comp();
+        }
+
+        allocator_type get_allocator() const {
+            return tree_.get_allocator();
+        }
+
+        // O(1)
+        iterator begin() {
+            return tree_.begin();
+        }
+
+        const_iterator begin() const {
+            return tree_.begin();
+        }
+
+        iterator end() {
+            return tree_.end();
+        }
+
+        const_iterator end() const {
+            return tree_.end();
+        }
+
+        const_iterator cbegin() const {
+            return begin();
+        }
+
+        const_iterator cend() const {
+            return end();
+        }
+
+        reverse_iterator rbegin() {
+            return reverse_iterator(end());
+        }
+
+        const_reverse_iterator rbegin() const {
+            return const_reverse_iterator(end());
+        }
+
+        reverse_iterator rend() {
+            return reverse_iterator(begin());
+        }
+
+        const_reverse_iterator rend() const {
+            return const_reverse_iterator(begin());
+        }
+
+        const_reverse_iterator crbegin() const {
+            return rbegin();
+        }
+
+        const_reverse_iterator crend() const {
+            return rend();
+        }
+
+    private:
+        T& checked(iterator found) {
+            if (found == tree_.end()) {
+                throw std::out_of_range("wheel::flat_map::at - key not found");
+            }
+            return found->second;
+        }
+
+        const T& checked(const_iterator found) const {
+            if (found == tree_.end()) {
+                throw std::out_of_range("wheel::flat_map::at - key not found");
+            }
+            return found->second;
+        }
+
+        tree_type tree_;
+    };
+
+    namespace pmr {
+        // flat_map whose array comes from a std::pmr::memory_resource
+        template< typename Key, typename T, typename Compare = std::less<Key> >
+        using flat_map = wheel::flat_map<Key, T, Compare, std::pmr::polymorphic_allocator<std::pair<Key, T>>>;
+    }
+
+}  // namespace wheel
+
+#endif // FLAT_MAP_HPP_
@@ -0,0 +1,283 @@
+/*
+An ordered set of unique keys in one sorted array, with the same interface
+as ordered_set.
+
+For sets that are built once, or in batches, and then mostly searched and
+scanned.  The keys sit side by side in a wheel::vector (see flat_tree.hpp),
+so there is no memory spent on nodes and a scan streams through memory,
+but an insert or erase moves every key after it.  Insert many keys at once
+with insert(first, last) - they are sorted and merged in, in one pass.
+
+Iterators are plain pointers into the array, and are invalidated by any
+insert or erase.
+
+Keys are ordered by Compare.  If Compare is transparent (has an
+is_transparent member type, as std::less<> does) find, erase and the range
+queries also accept anything Compare can compare with a Key, without building
+a Key first.
+
+Operation       Speed
+insert          O(n)
+insert range    O(n + k log k)  // for k keys
+find            O(log n)
+erase           O(n)
+lower_bound     O(log n)  // and upper_bound, equal_range
+count_range     O(log n)
+rank            O(log n)
+select          O(1)
+set_union       O(n + m)  // and set_intersection, set_difference
+begin           O(1)
+++, --          O(1)
+clear           O(1), O(n) if keys have a destructor
+*/
+
+#ifndef FLAT_SET_HPP_
+#define FLAT_SET_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+#include "flat_tree.hpp"
+
+namespace wheel {  // as in re-inventing the wheel
+
+    template< typename Key, typename Compare = std::less<Key>, typename Allocator = std::allocator<Key> >
+    class flat_set {
+        using tree_type = flat_tree<Key, Key, identity_key, Compare, Allocator>;
+
+    public:
+
+        using key_type = Key;
+        using value_type = Key;
+        using key_compare = Compare;
+        using allocator_type = Allocator;
+        // keys can't be changed in place, that could break the order, so both
+        // iterators are const
+        using iterator = typename tree_type::const_iterator;
+        using const_iterator = typename tree_type::const_iterator;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        flat_set() = default;
+
+        explicit flat_set(const Allocator& alloc) : tree_(Compare(), alloc) {}
+
+        explicit flat_set(const Compare& comp, const Allocator& alloc = Allocator()) : tree_(comp, alloc) {}
+
+        // O(k log k) - see insert(first, last)
+        template< typename InputIterator, typename = typename std::iterator_traits<InputIterator>::iterator_category >
+        flat_set(InputIterator first, InputIterator last, const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+            : tree_(comp, alloc) {
+            insert(first, last);
+        }
+
+        flat_set(std::initializer_list<Key> init, const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+            : tree_(comp, alloc) {
+            insert(init.begin(), init.end());
+        }
+
+        // O(n) - as for ordered_set, the iterator is to the inserted key or to
+        // the one that prevented the insertion
+        std::pair<iterator, bool> insert(const Key& value) {
+            return tree_.try_emplace(value, value);
+        }
+
+        std::pair<iterator, bool> insert(Key&& value) {
+            return tree_.try_emplace(value, std::move(value));
+        }
+
+        // O(n + k log k) - the keys are sorted on their own, those already in
+        // the set dropped, and the rest merged in, in one pass.  As for
+        // repeated single inserts, the first of equivalent keys is kept.
+        template< typename InputIterator, typename = typename std::iterator_traits<InputIterator>::iterator_category >
+        void insert(InputIterator first, InputIterator last) {
+            tree_.insert_range(first, last);
+        }
+
+        void insert(std::initializer_list<Key> init) {
+            insert(init.begin(), init.end());
+        }
+
+        // O(log n)
+        iterator find(const Key& key) const {
+            return tree_.find(key);
+        }
+
+        template< typename K, typename C = Compare, typename = typename C::is_transparent >
+        iterator find(const K& key) const {
+            return tree_.find(key);
+        }
+
+        // O(log n) - the first key not less than key
+        iterator lower_bound(const Key& key) const {
+            return tree_.lower_bound(key);
+        }
+
+        template< typename K, typename C = Compare, typename = typename C::is_transparent >
+        iterator lower_bound(const K& key) const {
+            return tree_.lower_bound(key);
+        }
+
+        // O(log n) - the first key greater than key
+        iterator upper_bound(const Key& key) const {
+            return tree_.upper_bound(key);
+        }
+
+        template< typename K, typename C = Compare, typename = typename C::is_transparent >
+        iterator upper_bound(const K& key) const {
+            return tree_.upper_bound(key);
+        }
+
+        // O(log n) - the keys equivalent to key, which is at most one
+        std::pair<iterator, iterator> equal_range(const Key& key) const {
+            return { lower_bound(key), upper_bound(key) };
+        }
+
+        template< typename K, typename C = Compare, typename = typename C::is_transparent >
+        std::pair<iterator, iterator> equal_range(const K& key) const {
+            return { lower_bound(key), upper_bound(key) };
+        }
+
+        // O(log n) - the number of keys less than key
+        size_t rank(const Key& key) const {
+            return tree_.rank(key);
+        }
+
+        template< typename K, typename C = Compare, typename = typename C::is_transparent >
+        size_t rank(const K& key) const {
+            return tree_.rank(key);
+        }
+
+        // O(log n) - the number of keys in [first, last)
+        size_t count_range(const Key& first, const Key& last) const {
+            if (!key_comp()(first, last)) {
+                return 0;
+            }
+            return rank(last) - rank(first);
+        }
+
+        template< typename K, typename C = Compare, typename = typename C::is_transparent >
+        size_t count_range(const K& first, const K& last) const {
+            if (!key_comp()(first, last)) {
+                return 0;
+            }
+            return rank(last) - rank(first);
+        }
+
+        // O(1) - the key with index i in order, or end() if i >= size()
+        iterator select(size_t i) const {
+            return tree_.select(i);
+        }
+
+        // O(n) - returns the number of elements removed, 0 or 1
+        size_t erase(const Key& key) {
+            return tree_.erase(key);
+        }
+
+        template< typename K, typename C = Compare, typename = typename C::is_transparent >
+        size_t erase(const K& key) {
+            return tree_.erase(key);
+        }
+
+        void clear() {
+            tree_.clear();
+        }
+
+        size_t size() const {
+            return tree_.size();
+        }
+
+        bool empty() const {
+            return tree_.size() == 0;
+        }
+
+        key_compare key_comp() const {
+            return tree_.key_comp();
+        }
+
+        allocator_type get_allocator() const {
+            return tree_.get_allocator();
+        }
+
+        // O(1)
+        iterator begin() const {
+            return tree_.begin();
+        }
+
+        iterator end() const {
+            return tree_.end();
+        }
+
+        const_iterator cbegin() const {
+            return begin();
+        }
+
+        const_iterator cend() const {
+            return end();
+        }
+
+        reverse_iterator rbegin() const {
+            return reverse_iterator(end());
+        }
+
+        reverse_iterator rend() const {
+            return reverse_iterator(begin());
+        }
+
+        const_reverse_iterator crbegin() const {
+            return rbegin();
+        }
+
+        const_reverse_iterator crend() const {
+            return rend();
+        }
+
+    private:
+        template< typename K, typename C, typename A >
+        friend flat_set<K, C, A> set_union(flat_set<K, C, A> a, flat_set<K, C, A> b);
+
+        template< typename K, typename C, typename A >
+        friend flat_set<K, C, A> set_intersection(flat_set<K, C, A> a, flat_set<K, C, A> b);
+
+        template< typename K, typename C, typename A >
+        friend flat_set<K, C, A> set_difference(flat_set<K, C, A> a, flat_set<K, C, A> b);
+
+        tree_type tree_;
+    };
+
+    // Set algebra on whole sets, as for ordered_set - one merge, O(n + m).
+    // Pass the arguments with std::move if they are not needed afterwards.
+    // Where both have an equivalent key, a's is kept.
+    template< typename Key, typename Compare, typename Allocator >
+    flat_set<Key, Compare, Allocator> set_union(flat_set<Key, Compare, Allocator> a, flat_set<Key, Compare, Allocator> b) {
+        a.tree_.unite(b.tree_);
+        return a;
+    }
+
+    template< typename Key, typename Compare, typename Allocator >
+    flat_set<Key, Compare, Allocator> set_intersection(flat_set<Key, Compare, Allocator> a, flat_set<Key, Compare, Allocator> b) {
+        a.tree_.intersect(b.tree_);
+        return a;
+    }
+
+    // the keys of a that are not in b
+    template< typename Key, typename Compare, typename Allocator >
+    flat_set<Key, Compare, Allocator> set_difference(flat_set<Key, Compare, Allocator> a, flat_set<Key, Compare, Allocator> b) {
+        a.tree_.subtract(b.tree_);
+        return a;
+    }
+
+    namespace pmr {
+        // flat_set whose array comes from a std::pmr::memory_resource
+        template< typename Key, typename Compare = std::less<Key> >
+        using flat_set = wheel::flat_set<Key, Compare, std::pmr::polymorphic_allocator<Key>>;
+    }
+
+}  // namespace wheel
+
+#endif // FLAT_SET_HPP_
@@ -0,0 +1,283 @@
+/* example:
+
+    [ 1 | 2 | 5 | 7 | 8 | 10 | 12 ]
+
+The engine behind flat_set and flat_map - the values in one wheel::vector,
+sorted by the Key that KeyOfValue extracts, compared with Compare.  There
+are no nodes and no pointers, so it takes a third of the memory of a
+red-black tree of ints, a scan is a walk along an array, and a lookup
+touches log2(n) values with no pointer to follow first.  The cost is that
+an insert or erase moves every value after it - fine for a set that is
+built once, or in batches, and then mostly read.
+
+Lookups are branch free binary searches: each step picks the half to keep
+with a conditional move rather than a jump, so there are no mispredicted
+branches, and the loop always runs the same log2(n) times.
+
+A batch of values is not inserted one at a time.  It is sorted on its own,
+the values already present are dropped, the rest are appended, and the old
+and new runs are merged in a single pass - O(n + k log k) rather than
+O(n k) for k values.
+
+Values move whenever the array changes, so insert and erase invalidate all
+iterators.  Value's move constructor and assignment should not throw.
+
+Operation       Speed
+try_emplace     O(n)  // O(log n) to find the place, O(n) to make room
+insert_range    O(n + k log k)
+find            O(log n)
+erase           O(n)
+lower_bound     O(log n)
+upper_bound     O(log n)
+rank            O(log n)
+select          O(1)
+unite           O(n + m)  // and intersect, subtract - by merging
+begin           O(1)
+++, --          O(1)
+clear           O(1), O(n) if values have a destructor
+*/
+
+#ifndef FLAT_TREE_HPP_
+#define FLAT_TREE_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "rb_tree.hpp"   // compare_holder
+#include "vector.hpp"
+
+namespace wheel {  // as in re-inventing the wheel
+
+    template< typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator >
+    class flat_tree : private compare_holder<Compare> {
+    public:
+
+        using allocator_type = Allocator;
+        using iterator = Value*;
+        using const_iterator = const Value*;
+
+        flat_tree() = default;
+
+        flat_tree(const Compare& comp, const Allocator& alloc)
+            : compare_holder<Compare>(comp), values_(alloc) {}
+
+        // O(n) - if no value has an equivalent key, one is built from args and
+        // the values after it move up to make room.  Returns the value with
+        // key, and whether it is new.
+        template< typename K, typename... Args >
+        std::pair<iterator, bool> try_emplace(const K& key, Args&&... args) {
+            Value* where = bound<false>(values_.begin(), values_.end(), key);
+            if (where != values_.end() && !comp()(key, key_of(*where))) {
+                return { where, false };
+            }
+            return { values_.emplace(where, std::forward<Args>(args)...), true };
+        }
+
+        // O(n + k log k) for k values.  The batch is copied out, sorted and
+        // deduplicated - the first of equivalent values is kept, as repeated
+        // inserts would - then the values whose keys are new are appended and
+        // merged with the old ones.  std::inplace_merge moves the shorter run
+        // out to a buffer and merges back in one pass.
+        template< typename InputIterator >
+        void insert_range(InputIterator first, InputIterator last) {
+            std::vector<Value, Allocator> batch(first, last, values_.get_allocator());
+            auto less = [this](const Value& a, const Value& b) { return comp()(key_of(a), key_of(b)); };
+            auto equivalent = [this](const Value& a, const Value& b) { return !comp()(key_of(a), key_of(b)); };
+            std::stable_sort(batch.begin(), batch.end(), less);
+            batch.erase(std::unique(batch.begin(), batch.end(), equivalent), batch.end());
+
+            size_t old_size = values_.size();
+            values_.reserve(old_size + batch.size());
+            // nothing below reallocates, so these stay put
+            Value* old_end = values_.end();
+            Value* search = values_.begin();
+            try {
+                for (Value& value : batch) {
+                    search = bound<false>(search, old_end, key_of(value));
+                    if (search == old_end || comp()(key_of(value), key_of(*search))) {
+                        values_.push_back(std::move(value));
+                    }
+                }
+            }
+            catch (...) {
+                while (values_.size() > old_size) {
+                    values_.pop_back();
+                }
+                throw;
+            }
+            std::inplace_merge(values_.begin(), old_end, values_.end(), less);
+        }
+
+        // O(log n) - K is Key, or anything Compare can compare with Key if it
+        // is transparent
+        template< typename K >
+        iterator find(const K& key) {
+            Value* where = bound<false>(values_.begin(), values_.end(), key);
+            return where != values_.end() && !comp()(key, key_of(*where)) ? where : values_.end();
+        }
+
+        template< typename K >
+        const_iterator find(const K& key) const {
+            const Value* where = bound<false>(values_.begin(), values_.end(), key);
+            return where != values_.end() && !comp()(key, key_of(*where)) ? where : values_.end();
+        }
+
+        // O(log n) - the first value whose key is not less than key
+        template< typename K >
+        iterator lower_bound(const K& key) {
+            return bound<false>(values_.begin(), values_.end(), key);
+        }
+
+        template< typename K >
+        const_iterator lower_bound(const K& key) const {
+            return bound<false>(values_.begin(), values_.end(), key);
+        }
+
+        // O(log n) - the first value whose key is greater than key
+        template< typename K >
+        iterator upper_bound(const K& key) {
+            return bound<true>(values_.begin(), values_.end(), key);
+        }
+
+        template< typename K >
+        const_iterator upper_bound(const K& key) const {
+            return bound<true>(values_.begin(), values_.end(), key);
+        }
+
+        // O(log n) - how many values have keys less than key
+        template< typename K >
+        size_t rank(const K& key) const {
+            return static_cast<size_t>(lower_bound(key) - values_.begin());
+        }
+
+        // O(1) - the value with index i in order, or end() if there are not
+        // that many
+        const_iterator select(size_t i) const {
+            return i < values_.size() ? values_.begin() + i : values_.end();
+        }
+
+        // O(n) - returns the number of elements removed, 0 or 1
+        template< typename K >
+        size_t erase(const K& key) {
+            Value* found = find(key);
+            if (found == values_.end()) {
+                return 0;
+            }
+            values_.erase(found);
+            return 1;
+        }
+
+        // Set algebra on whole arrays, O(n + m) - one merge into a new array.
+        // *this becomes the result and other ends up empty.  Where both have a
+        // value with the same key, *this's is kept.
+        void unite(flat_tree& other) {
+            combine(other, [](auto a, auto a_end, auto b, auto b_end, auto out, auto less) {
+                std::set_union(a, a_end, b, b_end, out, less);
+            });
+        }
+
+        void intersect(flat_tree& other) {
+            combine(other, [](auto a, auto a_end, auto b, auto b_end, auto out, auto less) {
+                std::set_intersection(a, a_end, b, b_end, out, less);
+            });
+        }
+
+        // takes away the values whose keys are in other
+        void subtract(flat_tree& other) {
+            combine(other, [](auto a, auto a_end, auto b, auto b_end, auto out, auto less) {
+                std::set_difference(a, a_end, b, b_end, out, less);
+            });
+        }
+
+        void clear() {
+            values_.clear();
+        }
+
+        size_t size() const {
+            return values_.size();
+        }
+
+        iterator begin() {
+            return values_.begin();
+        }
+
+        const_iterator begin() const {
+            return values_.begin();
+        }
+
+        iterator end() {
+            return values_.end();
+        }
+
+        const_iterator end() const {
+            return values_.end();
+        }
+
+        const Compare& key_comp() const {
+            return comp();
+        }
+
+        allocator_type get_allocator() const {
+            return values_.get_allocator();
+        }
+
+    private:
+        using compare_holder<Compare>::comp;
+
+        static const Key& key_of(const Value& value) {
+            return KeyOfValue()(value);
+        }
+
+        // Branch free binary search of [first, last) - the first value whose
+        // key is not less than key, or with Upper, greater than key.  The
+        // answer is always in [first, first + length]; each step keeps one half
+        // with a conditional move.
+        template< bool Upper, typename Pointer, typename K >
+        Pointer bound(Pointer first, Pointer last, const K& key) const {
+            size_t length = static_cast<size_t>(last - first);
+            if (length == 0) {
+                return first;
+            }
+            while (length > 1) {
+                size_t half = length / 2;
+                first = before_bound<Upper>(first[half], key) ? first + half : first;
+                length -= half;
+            }
+            return first + before_bound<Upper>(*first, key);
+        }
+
+        // true if value comes before the bound - its key is less than key, or
+        // with Upper, not greater
+        template< bool Upper, typename K >
+        bool before_bound(const Value& value, const K& key) const {
+            if constexpr (Upper) {
+                return !comp()(key, key_of(value));
+            }
+            else {
+                return comp()(key_of(value), key);
+            }
+        }
+
+        template< typename Merge >
+        void combine(flat_tree& other, Merge merge) {
+            vector<Value, Allocator> merged(values_.get_allocator());
+            merged.reserve(values_.size() + other.values_.size());
+            auto less = [this](const Value& a, const Value& b) { return comp()(key_of(a), key_of(b)); };
+            merge(std::make_move_iterator(values_.begin()), std::make_move_iterator(values_.end()),
+                  std::make_move_iterator(other.values_.begin()), std::make_move_iterator(other.values_.end()),
+                  std::back_inserter(merged), less);
+            values_ = std::move(merged);
+            other.clear();
+        }
+
+
+        vector<Value, Allocator> values_;
+    };
+
+}  // namespace wheel
+
+#endif // FLAT_TREE_HPP_
@@ -0,0 +1,386 @@
+#ifndef INTRUSIVE_LIST_HPP_
+#define INTRUSIVE_LIST_HPP_
+
+/*
+A doubly linked list of objects that carry their own links - for objects
+that already live somewhere else, in a pool or an array, where wheel::list
+would copy each one into a node of its own.  The links are a hook, a member
+of the object, named in the list's type:
+
+    struct job {
+        int id;
+        wheel::intrusive_list_hook<job> queued;    // in a run queue
+        wheel::intrusive_list_hook<job> owned;     // in its owner's list
+    };
+
+    wheel::intrusive_list<job, &job::queued> run_queue;
+    wheel::intrusive_list<job, &job::owned> mine;
+
+An object can be in as many lists at once as it has hooks, but in only one
+list per hook.  The list never allocates, copies or destroys an object:
+insert and push link it in, erase and pop unlink it, and the object must
+outlive its time in the list.  clear() and the destructor unlink every
+object, so their hooks can be used again.
+
+The iterators are as list's, with the links followed through the hook.
+
+Operation       Speed
+push_back       O(1)
+push_front      O(1)
+pop_back        O(1)
+pop_front       O(1)
+insert, erase   O(1)
+iterator_to     O(1)  // an iterator from a reference to an object in the list
+splice          O(1)
+reverse         O(n)
+clear           O(n)  // to reset each hook
+*/
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+namespace wheel {  // as in re-inventing the wheel
+
+	// the links an object needs to be in an intrusive_list - one per list it
+	// can be in at once
+	template< typename T >
+	struct intrusive_list_hook {
+		T* next = nullptr;
+		T* prior = nullptr;
+	};
+
+	template< typename T, intrusive_list_hook<T> T::* Hook >
+	class intrusive_list {
+	public:
+
+		using value_type = T;
+		using hook_type = intrusive_list_hook<T>;
+
+		struct iterator {
+
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+			using pointer = T*;
+			using reference = T&;
+			using iterator_category = std::bidirectional_iterator_tag;
+
+			constexpr iterator(T* p) noexcept : ptr_{ p } {}
+
+			iterator& operator++() {
+				if (ptr_) {
+					ptr_ = links(ptr_).next;
+				}
+				return *this;
+			}
+
+			iterator operator++(int) {
+				auto old = *this;
+				++*this;
+				return old;
+			}
+
+			// iterator_category bidirectional, so have to implement --
+			iterator& operator--() {
+				if (ptr_) {
+					ptr_ = links(ptr_).prior;
+				}
+				return *this;
+			}
+
+			iterator operator--(int) {
+				auto old = *this;
+				--*this;
+				return old;
+			}
+
+			T& operator*() const { return *ptr_; }
+			T* operator->() const { return ptr_; }
+
+			bool operator==(const iterator& other) const { return ptr_ == other.ptr_; }
+			bool operator!=(const iterator& other) const { return ptr_ != other.ptr_; }
+
+			T* ptr_ = nullptr;
+		};
+
+		struct const_iterator {
+
+			using value_type = const T;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const T*;
+			using reference = const T&;
+			using iterator_category = std::bidirectional_iterator_tag;
+
+			constexpr const_iterator() noexcept = default;
+
+			constexpr const_iterator(const T* p) noexcept : ptr_{ p } {}
+
+			// Implicit conversion from iterator:
+			constexpr const_iterator(iterator const& it) noexcept : ptr_{ it.ptr_ } {}
+
+			const_iterator& operator++() {
+				if (ptr_) {
+					ptr_ = links(ptr_).next;
+				}
+				return *this;
+			}
+
+			const_iterator operator++(int) {
+				auto old = *this;
+				++*this;
+				return old;
+			}
+
+			// iterator_category bidirectional, so have to implement --
+			const_iterator& operator--() {
+				if (ptr_) {
+					ptr_ = links(ptr_).prior;
+				}
+				return *this;
+			}
+
+			const_iterator operator--(int) {
+				auto old = *this;
+				--*this;
+				return old;
+			}
+
+			const T& operator*() const { return *ptr_; }
+			const T* operator->() const { return ptr_; }
+
+			bool operator==(const const_iterator& other) const { return ptr_ == other.ptr_; }
+			bool operator!=(const const_iterator& other) const { return ptr_ != other.ptr_; }
+
+			T const* ptr_ = nullptr;
+		};
+
+		// O(1)
+		intrusive_list() = default;
+
+		// O(n) - links in every object of [first, last), which must be lvalues
+		template <typename InputIterator>
+		intrusive_list(InputIterator first, InputIterator last) {
+			for (; first != last; ++first) {
+				push_back(*first);
+			}
+		}
+
+		// the objects can only be in one list per hook, so there is no copy
+		intrusive_list(const intrusive_list&) = delete;
+		intrusive_list& operator=(const intrusive_list&) = delete;
+
+		// O(1)
+		intrusive_list(intrusive_list&& other) noexcept {
+			swap(*this, other);
+		}
+
+		// O(n) - our objects are unlinked first
+		intrusive_list& operator=(intrusive_list&& other) noexcept {
+			if (this != &other) {
+				clear();
+				swap(*this, other);
+			}
+			return *this;
+		}
+
+		// O(n)
+		~intrusive_list() {
+			clear();
+		}
+
+		// O(1)
+		friend void swap(intrusive_list& first, intrusive_list& second) noexcept {
+			std::swap(first.head_, second.head_);
+			std::swap(first.tail_, second.tail_);
+			std::swap(first.size_, second.size_);
+		}
+
+		// O(n) - unlinks every object, resetting its hook
+		void clear() noexcept {
+			T* current = head_;
+			while (current) {
+				T* next = links(current).next;
+				links(current) = hook_type();
+				current = next;
+			}
+			head_ = nullptr;
+			tail_ = nullptr;
+			size_ = 0;
+		}
+
+		// O(1)
+		bool empty() const {
+			return head_ == nullptr;
+		}
+
+		// O(1)
+		size_t size() const {
+			return size_;
+		}
+
+		// O(1)
+		iterator begin() {
+			return iterator(head_);
+		}
+		const_iterator begin() const {
+			return const_iterator(head_);
+		}
+
+		// O(1)
+		iterator end() {
+			return nullptr;
+		}
+		const_iterator end() const {
+			return nullptr;
+		}
+
+		// O(1)
+		T& front() { return *head_; }
+		const T& front() const { return *head_; }
+
+		// O(1)
+		T& back() { return *tail_; }
+		const T& back() const { return *tail_; }
+
+		// O(1) - value must be in this list
+		iterator iterator_to(T& value) noexcept {
+			return iterator(&value);
+		}
+		const_iterator iterator_to(const T& value) const noexcept {
+			return const_iterator(&value);
+		}
+
+		// O(1)
+		// pos - iterator before which value will be linked in. pos may be the end() iterator
+		// value must not be in a list on this hook already
+		// returns iterator pointing to value
+		iterator insert(iterator pos, T& value) noexcept {
+			link_before(pos.ptr_, &value, &value);
+			++size_;
+			return iterator(&value);
+		}
+
+		// O(1)
+		void push_back(T& value) noexcept {
+			insert(end(), value);
+		}
+
+		// O(1)
+		void push_front(T& value) noexcept {
+			insert(begin(), value);
+		}
+
+		// O(1) - unlinks the last object
+		void pop_back() noexcept {
+			if (tail_) {
+				erase(iterator(tail_));
+			}
+		}
+
+		// O(1) - unlinks the first object
+		void pop_front() noexcept {
+			if (head_) {
+				erase(iterator(head_));
+			}
+		}
+
+		// O(1)
+		// pos must be dereferenceable - ie cannot pass in end
+		// the object is unlinked, not destroyed.  Returns iterator following it
+		iterator erase(iterator pos) noexcept {
+			hook_type& hook = links(pos.ptr_);
+			T* before = hook.prior;
+			T* after = hook.next;
+
+			if (before) {
+				links(before).next = after;
+			}
+			else {
+				head_ = after;
+			}
+			if (after) {
+				links(after).prior = before;
+			}
+			else {
+				tail_ = before;
+			}
+
+			hook = hook_type();
+			--size_;
+			return iterator(after);
+		}
+
+		// O(n) - unlinks every object equal to value
+		size_t remove(const T& value) {
+			size_t count{ 0 };
+			T* current = head_;
+			while (current) {
+				T* next = links(current).next;
+				if (*current == value) {
+					erase(iterator(current));
+					++count;
+				}
+				current = next;
+			}
+			return count;
+		}
+
+		// O(1)
+		// pos - element before which other's objects will be linked in. pos may be the end() iterator
+		void splice(iterator pos, intrusive_list& other) noexcept {
+			if (other.empty() || this == &other) {
+				return;
+			}
+			link_before(pos.ptr_, other.head_, other.tail_);
+			size_ += other.size_;
+			other.size_ = 0;
+			other.head_ = other.tail_ = nullptr;
+		}
+
+		// O(n)
+		void reverse() noexcept {
+			T* current = head_;
+			while (current) {
+				hook_type& hook = links(current);
+				std::swap(hook.next, hook.prior);
+				current = hook.prior;
+			}
+			std::swap(head_, tail_);
+		}
+
+	private:
+		static hook_type& links(T* value) noexcept {
+			return value->*Hook;
+		}
+
+		static const hook_type& links(const T* value) noexcept {
+			return value->*Hook;
+		}
+
+		// links the chain first .. last in before pos (nullptr for the end)
+		void link_before(T* pos, T* first, T* last) noexcept {
+			T* before = pos ? links(pos).prior : tail_;
+			links(first).prior = before;
+			links(last).next = pos;
+			if (before) {
+				links(before).next = first;
+			}
+			else {
+				head_ = first;
+			}
+			if (pos) {
+				links(pos).prior = last;
+			}
+			else {
+				tail_ = last;
+			}
+		}
+
+		T* head_ = nullptr;
+		T* tail_ = nullptr;
+		size_t size_ = 0;
+	};
+
+}  // namespace wheel
+
+#endif // INTRUSIVE_LIST_HPP_
@@ -3,15 +3,24 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <functional>
 #include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
 #include <utility>
 
+#include "node_pool.hpp"
+#include "prefetch.hpp"
+
 namespace wheel {  // as in re-inventing the wheel
 
-	template< typename T >
+	template< typename T, typename Allocator = std::allocator<T> >
 	class list {
 	public:
 
+		using allocator_type = Allocator;
+
 		struct node {
 			T value;
 			node* next = nullptr;
@@ -125,40 +134,136 @@ namespace wheel {  // as in re-inventing the wheel
 			node const* ptr_ = nullptr;
 		};
 
+		// A forward iterator that keeps a second pointer distance nodes ahead
+		// and prefetches each node as that pointer reaches it, so the node's
+		// cache line has been on its way for distance steps by the time the
+		// walk gets there.  The pointer ahead still has to chase the links one
+		// by one, but that chase no longer holds up the work done on each
+		// value - the processor can overlap the two.
+		struct prefetch_iterator {
+
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+			using pointer = T*;
+			using reference = T&;
+			using iterator_category = std::forward_iterator_tag;
+
+			constexpr prefetch_iterator() noexcept = default;
+
+			prefetch_iterator(node* p, size_t distance) noexcept : ptr_{ p }, ahead_{ p } {
+				for (; ahead_ && distance > 0; --distance) {
+					ahead_ = ahead_->next;
+					prefetch(ahead_);
+				}
+			}
+
+			prefetch_iterator& operator++() {
+				ptr_ = ptr_->next;
+				if (ahead_) {
+					ahead_ = ahead_->next;
+					prefetch(ahead_);
+				}
+				return *this;
+			}
+
+			prefetch_iterator operator++(int) {
+				auto old = *this;
+				++*this;
+				return old;
+			}
+
+			T& operator*() const { return ptr_->value; }
+			T* operator->() const { return &ptr_->value; }
+
+			bool operator==(const prefetch_iterator& other) const { return ptr_ == other.ptr_; }
+			bool operator!=(const prefetch_iterator& other) const { return ptr_ != other.ptr_; }
+
+			node* ptr_ = nullptr;
+			node* ahead_ = nullptr;
+		};
+
+		// begin and end of a walk with a prefetch_iterator, for a range for
+		struct prefetch_range {
+			prefetch_iterator begin() const { return first; }
+			prefetch_iterator end() const { return prefetch_iterator(); }
+
+			prefetch_iterator first;
+		};
+
 		// O(1)
 		list() = default;
 
+		// O(1)
+		explicit list(const Allocator& alloc) : pool_(node_allocator(alloc)) {}
+
 		// O(n)
 		template <typename InputIterator>
-		constexpr list(InputIterator first, InputIterator last)
-			: list{}    // delegate to default constuctor
+		constexpr list(InputIterator first, InputIterator last, const Allocator& alloc = Allocator())
+			: list(alloc)    // delegate to allocator constuctor
 		{
-			// By the time you get here, the default constructor has completed,
+			// By the time you get here, the delegated constructor has completed,
 			// so if an exception is thrown below, the destructor will be called.
 			std::for_each(first, last, [this](auto&& item) { push_back(item); });
 		}
 
 		// O(n)
-		list(std::initializer_list<T> init) : list<T>(init.begin(), init.end()) {}
+		list(std::initializer_list<T> init, const Allocator& alloc = Allocator())
+			: list(init.begin(), init.end(), alloc) {}
 
 		// O(n) - copy constructor
 		constexpr list(list const& other)
-			: list{ other.begin(), other.end() }
+			: list(other, Allocator(node_traits::select_on_container_copy_construction(other.pool_.allocator())))
+		{}
+
+		// O(n) - copy constructor using a different allocator
+		list(list const& other, const Allocator& alloc)
+			: list(other.begin(), other.end(), alloc)
 		{}
 
-		// O(n) copy assignment 
-		// - because although we just swap pointers, note list is copied - first arg is copied
-		// note also that we don't need to define a copy assignment move operator - this one does it!
-		// If called with an rvalue reference will use move constructor to create other and then swap with the current state.
-		list& operator=(list other)
+		// O(n) copy assignment
+		// - copy and swap, but the copy is made with the allocator *this ends up
+		// with, so the swap never pairs our nodes with the wrong allocator.
+		list& operator=(list const& other)
 		{
-			swap(*this, other);
+			if (this != &other) {
+				constexpr bool propagate = node_traits::propagate_on_container_copy_assignment::value;
+				list copy(other, propagate ? Allocator(other.pool_.allocator()) : Allocator(pool_.allocator()));
+				swap_nodes(copy);
+				if constexpr (propagate) {
+					std::swap(pool_.allocator(), copy.pool_.allocator());
+				}
+			}
+			return *this;
+		}
+
+		// O(1) move assignment - unless the allocators differ and cannot be
+		// propagated, then the nodes belong to other's allocator and each value
+		// has to be moved into a node of our own, O(n)
+		list& operator=(list&& other) noexcept(node_traits::propagate_on_container_move_assignment::value ||
+		                                       node_traits::is_always_equal::value)
+		{
+			if constexpr (node_traits::propagate_on_container_move_assignment::value) {
+				clear();
+				pool_.allocator() = std::move(other.pool_.allocator());
+				swap_nodes(other);
+			}
+			else {
+				if (node_traits::is_always_equal::value || pool_.allocator() == other.pool_.allocator()) {
+					clear();
+					swap_nodes(other);
+				}
+				else {
+					list moved(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()), Allocator(pool_.allocator()));
+					swap_nodes(moved);
+					other.clear();
+				}
+			}
 			return *this;
 		}
 
 		// O(1) move constructor
-		list(list&& other) noexcept : list() {
-			swap(*this, other);
+		list(list&& other) noexcept : list(Allocator(other.pool_.allocator())) {
+			swap_nodes(other);
 		}
 
 		// O(n)
@@ -167,23 +272,33 @@ namespace wheel {  // as in re-inventing the wheel
 		}
 
 		// O(1) - just 3 swaps
+		// allocators are only exchanged if they say so - otherwise, as for the
+		// standard containers, they must compare equal
 		friend void swap(list& first, list& second) // nothrow
 		{
-			// by swapping the members of list,
-			// first and second are effectively swapped
-			std::swap(first.size_, second.size_);
-			std::swap(first.head_, second.head_);
-			std::swap(first.tail_, second.tail_);
+			if constexpr (node_traits::propagate_on_container_swap::value) {
+				std::swap(first.pool_.allocator(), second.pool_.allocator());
+			}
+			first.swap_nodes(second);
 		}
 
-		// O(n)
+		// O(1)
+		allocator_type get_allocator() const {
+			return Allocator(pool_.allocator());
+		}
+
+		// O(n), O(slabs) if T has a trivial destructor
+		// the values are destroyed, then the pool hands back whole slabs at once
+		// rather than freeing node by node
 		void clear() {
-			node* current = head_;
-			while (current) {
-				node* next = current->next;
-				delete current;
-				current = next;
+			if constexpr (!std::is_trivially_destructible<T>::value) {
+				node* current = head_;
+				while (current) {
+					node_traits::destroy(pool_.allocator(), std::addressof(current->value));
+					current = current->next;
+				}
 			}
+			pool_.release();
 			head_ = nullptr;
 			tail_ = nullptr;
 			size_ = 0;
@@ -195,7 +310,7 @@ namespace wheel {  // as in re-inventing the wheel
 		}
 
 		// O(n)
-		bool operator==(const list<T>& other) const {
+		bool operator==(const list& other) const {
 
 			if (size_ != other.size()) {
 				return false;
@@ -214,8 +329,7 @@ namespace wheel {  // as in re-inventing the wheel
 		// pos - iterator before which the content will be inserted. pos may be the end() iterator
 		// returns iterator pointing to the inserted value
 		iterator insert(iterator pos, const T& value) {
-			node* inserted = new node;
-			inserted->value = value;
+			node* inserted = make_node(value);
 			inserted->next = pos.ptr_;
 
 			// if pos.ptr_ is null means inserting at end of list
@@ -235,6 +349,7 @@ namespace wheel {  // as in re-inventing the wheel
 				if (pos.ptr_->prior) {
 					pos.ptr_->prior->next = inserted;
 				}
+				pos.ptr_->prior = inserted;
 			}
 
 			// if inserted is now at head_, update head_
@@ -242,13 +357,14 @@ namespace wheel {  // as in re-inventing the wheel
 				head_ = inserted;
 			}
 
+			++size_;
 			return inserted;
 		}
 
 		// O(1)
 		void push_back(const T& value) {
 
-			node* newnode = new node{value};
+			node* newnode = make_node(value);
 
 			if (tail_) {
 				node* oldtail = tail_;
@@ -265,7 +381,7 @@ namespace wheel {  // as in re-inventing the wheel
 		// O(1)
 		void push_front(const T& value) {
 
-			node* newnode = new node{ value };
+			node* newnode = make_node(value);
 
 			if (head_) {
 
@@ -301,6 +417,15 @@ namespace wheel {  // as in re-inventing the wheel
 			return nullptr;
 		}
 
+		// O(distance)
+		// the list, walked with nodes prefetched distance ahead, eg
+		//   for (auto& v : mylist.prefetched()) ...
+		// Worth it where the nodes are scattered and there is work to do on
+		// each value - if there is little, compact() does far more.
+		prefetch_range prefetched(size_t distance = 8) {
+			return { prefetch_iterator(head_, distance) };
+		}
+
 		// O(1)
 		T& front() { return *iterator(head_); }
 		const T& front() const { return *iterator(head_); }
@@ -317,7 +442,7 @@ namespace wheel {  // as in re-inventing the wheel
 					newtail->next = nullptr;
 				}
 
-				delete tail_;
+				destroy_node(tail_);
 				tail_ = newtail;
 				--size_;
 				// TODO INVESTIGATE better way to handle this
@@ -335,7 +460,7 @@ namespace wheel {  // as in re-inventing the wheel
 					newhead->prior = nullptr;
 				}
 
-				delete head_;
+				destroy_node(head_);
 				head_ = newhead;
 				--size_;
 			}
@@ -384,43 +509,64 @@ namespace wheel {  // as in re-inventing the wheel
 
 			--size_;
 
-			delete pos.ptr_;
+			destroy_node(pos.ptr_);
 			pos.ptr_ = nullptr;
 
 			return iterator(after);
 		}
 
 		// O(1)
-		// pos - element before which the content will be inserted
+		// pos - element before which the content will be inserted. pos may be the end() iterator
+		// the allocators must compare equal, as for std::list::splice
 		void splice(iterator pos, list& other) {
-			// this size becomes += other.size()
-			this->size_ += other.size();
+			if (other.empty()) {
+				return;
+			}
 
-			// other size becomes zero
-			other.size_ = 0;
+			// other's nodes are now ours, so are the slabs they live in
+			pool_.adopt(other.pool_);
 
-			// pos->prior->next point to other.begin()
-			node* priornode = pos.ptr_->prior;
-			if (priornode) {
-				iterator beg(other.begin());
-				priornode->next = beg.ptr_;
+			node* after = pos.ptr_;
+			node* before = after ? after->prior : tail_;
+
+			other.head_->prior = before;
+			other.tail_->next = after;
+			if (before) {
+				before->next = other.head_;
 			}
 			else {
-				// reset head to be start of other list
 				head_ = other.head_;
 			}
+			if (after) {
+				after->prior = other.tail_;
+			}
+			else {
+				tail_ = other.tail_;
+			}
 
-			// pos->prior point to last node in other
-			pos.ptr_->prior = other.tail_;
-
-			// last in other point to pos
-			other.tail_->next = pos.ptr_;
-
-			// other head_ point to node prior to pos
-			other.head_->prior = priornode;
+			size_ += other.size_;
+			other.size_ = 0;
 			other.head_ = other.tail_ = nullptr;
 		}
 
+		// O(n)
+		// Moves every value into a new node, the nodes laid out in one slab in
+		// the order of the list, and frees the old ones.  After a long run of
+		// inserts and erases, or a sort, the nodes are scattered about the
+		// slabs and each step of a walk can be a cache miss - after compact()
+		// a walk reads memory in order, as fast as the hardware prefetcher
+		// can stream it.  Values are only copied if their move could throw,
+		// so if anything throws the list is unchanged.  All iterators are
+		// invalidated.
+		void compact() {
+			list compacted(Allocator(pool_.allocator()));
+			compacted.pool_.reserve(size_);
+			for (node* current = head_; current; current = current->next) {
+				compacted.emplace_back(std::move_if_noexcept(current->value));
+			}
+			swap_nodes(compacted);
+		}
+
 		// O(n)
 		void reverse() {
 			node* current = head_;
@@ -441,11 +587,100 @@ namespace wheel {  // as in re-inventing the wheel
 			tail_ = oldhead;
 		}
 
+		// O(n log n), stable - a bottom up merge sort that relinks the nodes,
+		// so nothing is allocated, copied or moved, and iterators stay valid.
+		// Nodes are taken off the front one at a time and carried up through
+		// bins of sorted runs, bin k holding 2^k nodes or none, merging with
+		// each full bin on the way like a binary counter's carry.  Runs stay
+		// small while they are hot in cache, and the only extra memory is a
+		// fixed array of 64 bins, enough for any list.  The prior links are
+		// ignored until the end, then set in one walk.
+		void sort() {
+			sort(std::less<>());
+		}
+
+		template<typename Compare>
+		void sort(Compare comp) {
+			if (size_ < 2) {
+				return;
+			}
+			node* bins[64] = {};
+			size_t used = 0;
+			node* rest = head_;
+			while (rest) {
+				node* carry = rest;
+				rest = rest->next;
+				carry->next = nullptr;
+				size_t k = 0;
+				for (; bins[k]; ++k) {
+					carry = merge_runs(bins[k], carry, comp);   // the bin's nodes came first
+					bins[k] = nullptr;
+				}
+				bins[k] = carry;
+				used = std::max(used, k + 1);
+			}
+			node* sorted = nullptr;
+			for (size_t k = 0; k < used; ++k) {
+				if (bins[k]) {
+					sorted = merge_runs(bins[k], sorted, comp);
+				}
+			}
+			head_ = sorted;
+			relink_priors();
+		}
+
+		// O(n + m)
+		// Both lists must be sorted by comp.  other's nodes are relinked into
+		// this list, in order, and other is left empty - where values are
+		// equal, ours come first.  The allocators must compare equal, as for
+		// std::list::merge.
+		void merge(list& other) {
+			merge(other, std::less<>());
+		}
+
+		template<typename Compare>
+		void merge(list& other, Compare comp) {
+			if (this == &other || other.empty()) {
+				return;
+			}
+
+			// other's nodes are now ours, so are the slabs they live in
+			pool_.adopt(other.pool_);
+
+			head_ = merge_runs(head_, other.head_, comp);
+			size_ += other.size_;
+			other.size_ = 0;
+			other.head_ = other.tail_ = nullptr;
+			relink_priors();
+		}
+
+		// O(n) - erases all but the first of each run of equal values, returns
+		// how many were erased
+		size_t unique() {
+			return unique(std::equal_to<>());
+		}
+
+		template<typename BinaryPredicate>
+		size_t unique(BinaryPredicate equal) {
+			size_t count{ 0 };
+			node* kept = head_;
+			while (kept && kept->next) {
+				if (equal(kept->value, kept->next->value)) {
+					erase(kept->next);
+					++count;
+				}
+				else {
+					kept = kept->next;
+				}
+			}
+			return count;
+		}
+
 		// O(1)
 		template<typename... Args>
 		void emplace_back(Args&&... v)
 		{
-			node* newnode = new node{ T(std::forward<Args>(v)...) };
+			node* newnode = make_node(std::forward<Args>(v)...);
 			if (tail_) {
 				node* oldtail = tail_;
 				oldtail->next = newnode;
@@ -459,11 +694,79 @@ namespace wheel {  // as in re-inventing the wheel
 		}
 
 	private:
+		using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<node>;
+		using node_traits = std::allocator_traits<node_allocator>;
+
+		// the value is constructed through the allocator, so that a scoped
+		// allocator such as std::pmr::polymorphic_allocator reaches it too
+		template<typename... Args>
+		node* make_node(Args&&... args) {
+			node* newnode = pool_.allocate();
+			try {
+				node_traits::construct(pool_.allocator(), std::addressof(newnode->value), std::forward<Args>(args)...);
+			}
+			catch (...) {
+				pool_.deallocate(newnode);
+				throw;
+			}
+			newnode->next = nullptr;
+			newnode->prior = nullptr;
+			return newnode;
+		}
+
+		// the node goes back on the pool's free list for the next insert
+		void destroy_node(node* n) {
+			node_traits::destroy(pool_.allocator(), std::addressof(n->value));
+			pool_.deallocate(n);
+		}
+
+		// merges the sorted runs left and right, linked by next only, taking
+		// from left while right's value is not less - returns the first node
+		template<typename Compare>
+		static node* merge_runs(node* left, node* right, Compare& comp) {
+			node* first = nullptr;
+			node** link = &first;
+			while (left && right) {
+				node*& taken = comp(right->value, left->value) ? right : left;
+				*link = taken;
+				link = &taken->next;
+				taken = taken->next;
+			}
+			*link = left ? left : right;
+			return first;
+		}
+
+		// sets every prior link, and tail_, from the next links
+		void relink_priors() noexcept {
+			node* prior = nullptr;
+			for (node* current = head_; current; current = current->next) {
+				current->prior = prior;
+				prior = current;
+			}
+			tail_ = prior;
+		}
+
+		void swap_nodes(list& other) noexcept {
+			pool_.swap_storage(other.pool_);
+			std::swap(size_, other.size_);
+			std::swap(head_, other.head_);
+			std::swap(tail_, other.tail_);
+		}
+
 		node* head_ = nullptr;
 		node* tail_ = nullptr;
 		size_t size_ = 0;
+		node_pool<node, node_allocator> pool_;  // every node lives in here
 	};
 
+	namespace pmr {
+		// list whose nodes come from a std::pmr::memory_resource, eg
+		//   std::pmr::monotonic_buffer_resource arena;
+		//   wheel::pmr::list<int> l(&arena);
+		template< typename T >
+		using list = wheel::list<T, std::pmr::polymorphic_allocator<T>>;
+	}
+
 }  // namespace wheel
 
 #endif // LIST_HPP_
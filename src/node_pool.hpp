@@ -0,0 +1,261 @@
+#ifndef NODE_POOL_HPP_
+#define NODE_POOL_HPP_
+
+/*
+Fixed size node allocator for the node based containers.
+
+Nodes are carved out of slabs - contiguous arrays of node sized slots obtained
+from the container's allocator.  A freed node goes on an intrusive free list
+threaded through the free slots themselves, and is handed out again before any
+new slot is used, so steady state insert/erase churn never reaches malloc.
+Slabs double in size from first_slab up to max_slab slots, except that
+reserve() gets one slab big enough for a bulk build in one go.
+
+Memory is only given back to the allocator when the whole pool is released,
+which costs one deallocation per slab rather than one per node.
+
+A pool can adopt another's slabs, as when a list splices in another list's
+nodes.  The slab list, the free list and the runs of never-used slots are
+all kept with a pointer to their last link, so adopting just joins each of
+them on to ours, however many slots there are.  Never-used runs other than
+the current one wait on a spare list until the current run is used up.
+
+Operation       Speed
+allocate        O(1)  // amortized - a new slab is obtained every so often
+deallocate      O(1)
+release         O(slabs)
+adopt           O(1)
+reserve         O(1)  // plus the allocation of a slab
+*/
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace wheel {  // as in re-inventing the wheel
+
+	template< typename Node, typename Allocator = std::allocator<Node> >
+	class node_pool {
+
+		// a slot is either a live node, a link in the free list, the first slot
+		// of a spare run of never-used slots, or - the first slot of each
+		// slab - the slab header
+		union slot {
+			slot* next_free;
+			struct {
+				slot* next_slab;
+				size_t slots;
+			} header;
+			struct {
+				slot* next_run;
+				size_t slots;
+			} run;
+			alignas(Node) unsigned char storage[sizeof(Node)];
+		};
+
+		using slot_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<slot>;
+		using slot_traits = std::allocator_traits<slot_allocator>;
+
+	public:
+		static constexpr size_t first_slab = 32;
+		static constexpr size_t max_slab = 4096;
+
+		node_pool() = default;
+
+		explicit node_pool(const Allocator& alloc) : alloc_(alloc) {}
+
+		node_pool(const node_pool&) = delete;
+		node_pool& operator=(const node_pool&) = delete;
+
+		~node_pool() {
+			release();
+		}
+
+		// O(1) - uninitialized storage for one Node
+		Node* allocate() {
+			slot* s = free_;
+			if (s) {
+				free_ = s->next_free;
+				if (free_ == nullptr) {
+					free_tail_ = nullptr;
+				}
+			}
+			else {
+				if (bump_ == bump_end_) {
+					if (spare_) {
+						take_spare_run();
+					}
+					else {
+						add_slab();
+					}
+				}
+				s = bump_++;
+			}
+			return reinterpret_cast<Node*>(s->storage);
+		}
+
+		// O(1) - n must have come from this pool and its Node already destroyed
+		void deallocate(Node* n) noexcept {
+			slot* s = reinterpret_cast<slot*>(n);
+			s->next_free = free_;
+			if (free_ == nullptr) {
+				free_tail_ = s;
+			}
+			free_ = s;
+		}
+
+		// The next count allocations come from one contiguous slab, in address
+		// order, if the free list is empty - a bulk build lays its nodes out in
+		// the order it makes them.  Unused slots of the current slab wait on
+		// the spare list.
+		void reserve(size_t count) {
+			if (static_cast<size_t>(bump_end_ - bump_) >= count) {
+				return;
+			}
+			slot* first = bump_;
+			slot* last = bump_end_;
+			new_slab(count);
+			push_spare_run(first, last);
+		}
+
+		// O(slabs) - every node handed out is invalidated
+		void release() noexcept {
+			slot* slab = slabs_;
+			while (slab) {
+				slot* next = slab->header.next_slab;
+				slot_allocator slab_alloc(alloc_);
+				slot_traits::deallocate(slab_alloc, slab, slab->header.slots);
+				slab = next;
+			}
+			forget();
+		}
+
+		// O(1) - takes over all of other's slabs, so nodes allocated by other
+		// can now be deallocated here.  The allocators must compare equal.
+		void adopt(node_pool& other) noexcept {
+			if (other.slabs_ == nullptr) {
+				return;
+			}
+
+			other.last_slab_->header.next_slab = slabs_;
+			if (slabs_ == nullptr) {
+				last_slab_ = other.last_slab_;
+			}
+			slabs_ = other.slabs_;
+
+			// other's free list goes in front of ours
+			if (other.free_) {
+				other.free_tail_->next_free = free_;
+				if (free_ == nullptr) {
+					free_tail_ = other.free_tail_;
+				}
+				free_ = other.free_;
+			}
+
+			// other's never-used slots, its current run and its spares, wait
+			// behind our current run
+			push_spare_run(other.bump_, other.bump_end_);
+			if (other.spare_) {
+				other.spare_tail_->run.next_run = spare_;
+				if (spare_ == nullptr) {
+					spare_tail_ = other.spare_tail_;
+				}
+				spare_ = other.spare_;
+			}
+
+			other.forget();
+		}
+
+		// O(1) - exchanges slabs only, allocators stay put
+		void swap_storage(node_pool& other) noexcept {
+			std::swap(slabs_, other.slabs_);
+			std::swap(last_slab_, other.last_slab_);
+			std::swap(free_, other.free_);
+			std::swap(free_tail_, other.free_tail_);
+			std::swap(spare_, other.spare_);
+			std::swap(spare_tail_, other.spare_tail_);
+			std::swap(bump_, other.bump_);
+			std::swap(bump_end_, other.bump_end_);
+			std::swap(next_slab_size_, other.next_slab_size_);
+		}
+
+		Allocator& allocator() noexcept {
+			return alloc_;
+		}
+
+		const Allocator& allocator() const noexcept {
+			return alloc_;
+		}
+
+	private:
+		void add_slab() {
+			new_slab(next_slab_size_);
+			if (next_slab_size_ < max_slab) {
+				next_slab_size_ *= 2;
+			}
+		}
+
+		// the new slab's slots become the current run - the caller sees to
+		// what was left of the old one
+		void new_slab(size_t count) {
+			size_t slots = count + 1;  // + 1 for the header
+			slot_allocator slab_alloc(alloc_);
+			slot* slab = slot_traits::allocate(slab_alloc, slots);
+			slab->header.next_slab = slabs_;
+			slab->header.slots = slots;
+			if (slabs_ == nullptr) {
+				last_slab_ = slab;
+			}
+			slabs_ = slab;
+			bump_ = slab + 1;
+			bump_end_ = slab + slots;
+		}
+
+		// puts the never-used slots [first, last) on the front of the spare list
+		void push_spare_run(slot* first, slot* last) noexcept {
+			if (first == last) {
+				return;
+			}
+			first->run.next_run = spare_;
+			first->run.slots = static_cast<size_t>(last - first);
+			if (spare_ == nullptr) {
+				spare_tail_ = first;
+			}
+			spare_ = first;
+		}
+
+		// the first spare run becomes the current one
+		void take_spare_run() noexcept {
+			slot* run = spare_;
+			spare_ = run->run.next_run;
+			if (spare_ == nullptr) {
+				spare_tail_ = nullptr;
+			}
+			bump_ = run;
+			bump_end_ = run + run->run.slots;
+		}
+
+		// empty, without giving anything back
+		void forget() noexcept {
+			slabs_ = last_slab_ = nullptr;
+			free_ = free_tail_ = nullptr;
+			spare_ = spare_tail_ = nullptr;
+			bump_ = bump_end_ = nullptr;
+			next_slab_size_ = first_slab;
+		}
+
+		slot* slabs_ = nullptr;       // singly linked through each header
+		slot* last_slab_ = nullptr;
+		slot* free_ = nullptr;        // recycled slots
+		slot* free_tail_ = nullptr;
+		slot* spare_ = nullptr;       // runs of never-used slots, waiting their turn
+		slot* spare_tail_ = nullptr;
+		slot* bump_ = nullptr;        // next never-used slot of the current run
+		slot* bump_end_ = nullptr;
+		size_t next_slab_size_ = first_slab;
+		Allocator alloc_;
+	};
+
+}  // namespace wheel
+
+#endif // NODE_POOL_HPP_
@@ -0,0 +1,227 @@
+/*
+An ordered map of unique keys to values, like std::map.
+
+The set's sibling - the same tree (rb_tree.hpp), but each node holds a
+std::pair<const Key, T> ordered by its first member.
+
+Keys are ordered by Compare.  If Compare is transparent (has an
+is_transparent member type, as std::less<> does) find, at and erase also
+accept anything Compare can compare with a Key, without building a Key
+first - so a map keyed on std::string with std::less<> can be searched with a
+std::string_view or a string literal and no temporary string is allocated.
+
+Operation       Speed
+insert          O(log n)
+operator[]      O(log n)
+find, at        O(log n)
+erase           O(log n)
+begin           O(log n)
+++, --          O(1)  // amortized - a full traversal is O(n)
+clear           O(chunks), O(n) if keys or values have a destructor
+*/
+
+#ifndef ORDERED_MAP_HPP_
+#define ORDERED_MAP_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#include "rb_tree.hpp"
+
+namespace wheel {  // as in re-inventing the wheel
+
+    template< typename Key, typename T, typename Compare = std::less<Key>,
+              typename Allocator = std::allocator<std::pair<const Key, T>> >
+    class ordered_map {
+        using tree_type = rb_tree<Key, std::pair<const Key, T>, first_key, Compare, Allocator>;
+
+    public:
+
+        using key_type = Key;
+        using mapped_type = T;
+        using value_type = std::pair<const Key, T>;
+        using key_compare = Compare;
+        using allocator_type = Allocator;
+        using iterator = typename tree_type::iterator;
+        using const_iterator = typename tree_type::const_iterator;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        ordered_map() = default;
+
+        explicit ordered_map(const Allocator& alloc) : tree_(Compare(), alloc) {}
+
+        explicit ordered_map(const Compare& comp, const Allocator& alloc = Allocator()) : tree_(comp, alloc) {}
+
+        // O(log n) - as for ordered_set, the iterator is to the inserted element
+        // or to the one with the same key that prevented the insertion
+        std::pair<iterator, bool> insert(const value_type& value) {
+            return tree_.try_emplace(value.first, value);
+        }
+
+        std::pair<iterator, bool> insert(value_type&& value) {
+            return tree_.try_emplace(value.first, std::move(value));
+        }
+
+        // O(log n) - the mapped value is only constructed, from args, if key is new
+        template< typename... Args >
+        std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+            return tree_.try_emplace(key, std::piecewise_construct,
+                std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+
+        // O(log n) - inserts a value initialised T if key is new
+        T& operator[](const Key& key) {
+            return try_emplace(key).first->second;
+        }
+
+        T& operator[](Key&& key) {
+            auto result = tree_.try_emplace(key, std::piecewise_construct,
+                std::forward_as_tuple(std::move(key)), std::tuple<>());
+            return result.first->second;
+        }
+
+        // O(log n) - throws std::out_of_range if key is not in the map
+        T& at(const Key& key) {
+            return checked(tree_.find_node(key));
+        }
+
+        const T& at(const Key& key) const {
+            return checked(tree_.find_node(key));
+        }
+
+        template< typename K, typename C = Compare, typename = typename C::is_transparent >
+        T& at(const K& key) {
+            return checked(tree_.find_node(key));
+        }
+
+        template< typename K, typename C = Compare, typename = typename C::is_transparent >
+        const T& at(const K& key) const {
+            return checked(tree_.find_node(key));
+        }
+
+        // O(log n)
+        iterator find(const Key& key) {
+            return tree_.find(key);
+        }
+
+        const_iterator find(const Key& key) const {
+            return tree_.find(key);
+        }
+
+        template< typename K, typename C = Compare, typename = typename C::is_transparent >
+        iterator find(const K& key) {
+            return tree_.find(key);
+        }
+
+        template< typename K, typename C = Compare, typename = typename C::is_transparent >
+        const_iterator find(const K& key) const {
+            return tree_.find(key);
+        }
+
+        // O(log n) - returns the number of elements removed, 0 or 1
+        size_t erase(const Key& key) {
+            return tree_.erase(key);
+        }
+
+        template< typename K, typename C = Compare, typename = typename C::is_transparent >
+        size_t erase(const K& key) {
+            return tree_.erase(key);
+        }
+
+        void clear() {
+            tree_.clear();
+        }
+
+        size_t size() const {
+            return tree_.size();
+        }
+
+        bool empty() const {
+            return tree_.size() == 0;
+        }
+
+        key_compare key_comp() const {
+            return tree_.key_comp();
+        }
+
+        allocator_type get_allocator() const {
+            return tree_.get_allocator();
+        }
+
+        // O(log n) - in key order
+        iterator begin() {
+            return tree_.begin();
+        }
+
+        const_iterator begin() const {
+            return tree_.begin();
+        }
+
+        // O(1)
+        iterator end() {
+            return tree_.end();
+        }
+
+        const_iterator end() const {
+            return tree_.end();
+        }
+
+        const_iterator cbegin() const {
+            return begin();
+        }
+
+        const_iterator cend() const {
+            return end();
+        }
+
+        reverse_iterator rbegin() {
+            return reverse_iterator(end());
+        }
+
+        const_reverse_iterator rbegin() const {
+            return const_reverse_iterator(end());
+        }
+
+        reverse_iterator rend() {
+            return reverse_iterator(begin());
+        }
+
+        const_reverse_iterator rend() const {
+            return const_reverse_iterator(begin());
+        }
+
+        const_reverse_iterator crbegin() const {
+            return rbegin();
+        }
+
+        const_reverse_iterator crend() const {
+            return rend();
+        }
+
+    private:
+        static T& checked(typename tree_type::node* found) {
+            if (found == nullptr) {
+                throw std::out_of_range("wheel::ordered_map::at - key not found");
+            }
+            return found->value.second;
+        }
+
+        tree_type tree_;
+    };
+
+    namespace pmr {
+        // ordered_map whose nodes come from a std::pmr::memory_resource
+        template< typename Key, typename T, typename Compare = std::less<Key> >
+        using ordered_map = wheel::ordered_map<Key, T, Compare, std::pmr::polymorphic_allocator<std::pair<const Key, T>>>;
+    }
+
+}  // namespace wheel
+
+#endif // ORDERED_MAP_HPP_
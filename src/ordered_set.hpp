@@ -1,196 +1,318 @@
-/* example:
-
-	8                                      4
-   / \                                    /  \
-  5   10                                 2    6
- / \    \                              / \   / \
-1   7   12                            1  3  5   7
-
-All nodes on left contain values < parent node
-All nodes on right contain values > parent node
-
-Simple example of binary search tree operations:
-1. basic data structure with value, left and right links
-2. search - recursive - find()
-3. insert - add_node()
-4. delete all nodes - deallocate_nodes() - cleanup
-5. various traversal operations
+/*
+An ordered set of unique keys, like std::set.
 
 This first example is a set.  This is a bit less work because there
-is no need for a key value pair - the set is just the key
-
+is no need for a key value pair - the set is just the key.  The tree itself
+is in rb_tree.hpp, shared with ordered_map.
+
+The Backend policy picks the tree.  rb_tree_backend, the default, is the
+red-black tree.  btree_backend<> is the btree in btree.hpp, which packs
+many keys into each node and so takes far fewer cache misses per lookup in
+a big set - but insert and erase move keys between nodes, so they
+invalidate iterators to other keys.
+
+Keys are ordered by Compare.  If Compare is transparent (has an
+is_transparent member type, as std::less<> does) find, erase and the range
+queries also accept anything Compare can compare with a Key, without building
+a Key first.
+
+Operation       Speed
+insert          O(log n)
+insert range    O(n) into an empty set if sorted, O(n log n) if not
+find            O(log n)
+erase           O(log n)
+lower_bound     O(log n)  // and upper_bound, equal_range
+count_range     O(log n)
+rank, select    O(log n)
+set_union       O(m log(n/m + 1))  // and set_intersection, set_difference, for
+                                   // m <= n keys - O(n + m) with btree_backend
+begin           O(log n)
+++, --          O(1)  // amortized - a full traversal is O(n)
+clear           O(chunks), O(n) if keys have a destructor
 */
 
 #ifndef ORDERED_SET_HPP_
 #define ORDERED_SET_HPP_
 
+#include <algorithm>
 #include <cstddef>
-#include <utility>
+#include <functional>
+#include <initializer_list>
 #include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+#include <vector>
 
-namespace wheel {  // as in re-inventing the wheel
-
-struct binary_tree_node {
-	int value;
-	binary_tree_node* left = nullptr;
-	binary_tree_node* right = nullptr;
-};
+#include "btree.hpp"
+#include "rb_tree.hpp"
 
+namespace wheel {  // as in re-inventing the wheel
 
+  template< typename Key, typename Compare = std::less<Key>, typename Allocator = std::allocator<Key>,
+            typename Backend = rb_tree_backend >
   class ordered_set {
+      using tree_type = typename Backend::template tree<Key, Key, identity_key, Compare, Allocator>;
+
   public:
 
-      struct iterator {
+      using key_type = Key;
+      using value_type = Key;
+      using key_compare = Compare;
+      using allocator_type = Allocator;
+      // keys can't be changed in place, that could break the order, so both
+      // iterators are const
+      using iterator = typename tree_type::const_iterator;
+      using const_iterator = typename tree_type::const_iterator;
+      using reverse_iterator = std::reverse_iterator<iterator>;
+      using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
-          using value_type = int; // T;
-          using difference_type = std::ptrdiff_t;
-          using pointer = int*; // T*;
-          using reference = int&; // T&;
-          using iterator_category = std::bidirectional_iterator_tag;
+    ordered_set() = default;
 
-          constexpr iterator(binary_tree_node* p) noexcept : ptr_{ p } {}
+    explicit ordered_set(const Allocator& alloc) : tree_(Compare(), alloc) {}
 
-          iterator& operator++() {
-              if (ptr_) {
-                  ptr_ = ptr_->left;  // this is wrong
-              }
-              return *this;
-          }
+    explicit ordered_set(const Compare& comp, const Allocator& alloc = Allocator()) : tree_(comp, alloc) {}
 
-          iterator operator++(int) {
-              auto old = *this;
-              if (ptr_) {
-                  ptr_ = ptr_->left;  // this is wrong next;
-              }
-              return old;
-          }
+    // O(n) if the keys arrive sorted, O(n log n) otherwise - see insert(first, last)
+    template< typename InputIterator, typename = typename std::iterator_traits<InputIterator>::iterator_category >
+    ordered_set(InputIterator first, InputIterator last, const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+        : tree_(comp, alloc) {
+        insert(first, last);
+    }
 
-          int& operator*() const { return ptr_->value; }
-          int* operator->() { return &ptr_->value; }
+    ordered_set(std::initializer_list<Key> init, const Compare& comp = Compare(), const Allocator& alloc = Allocator())
+        : tree_(comp, alloc) {
+        insert(init.begin(), init.end());
+    }
 
-          bool operator==(const iterator& other) const { return ptr_ == other.ptr_; }
-          bool operator!=(const iterator& other) const { return ptr_ != other.ptr_; }
+    // Returns a pair consisting of an iterator to the inserted element(or to the
+    // element that prevented the insertion) and a bool value set to true if the
+    // insertion took place.
+    // O(log n)
+    std::pair<iterator, bool> insert(const Key& value) {
+        return tree_.try_emplace(value, value);
+    }
 
-          binary_tree_node* ptr_ = nullptr;
-      };
+    std::pair<iterator, bool> insert(Key&& value) {
+        return tree_.try_emplace(value, std::move(value));
+    }
 
+    // Into an empty set the keys are not inserted one by one - the tree is
+    // built in one go, balanced, in O(n).  If a forward range is already
+    // strictly increasing it is used as it is, otherwise the keys are copied
+    // out, sorted and deduplicated first, which costs O(n log n).  Into a set
+    // that already has keys, each is inserted in turn, O(m log(n + m)).  As
+    // for repeated single inserts, the first of equivalent keys is kept.
+    template< typename InputIterator, typename = typename std::iterator_traits<InputIterator>::iterator_category >
+    void insert(InputIterator first, InputIterator last) {
+        using category = typename std::iterator_traits<InputIterator>::iterator_category;
+        if (size() != 0) {
+            for (; first != last; ++first) {
+                insert(*first);
+            }
+            return;
+        }
 
+        auto in_order = [this](const Key& a, const Key& b) { return key_comp()(a, b); };
+        if constexpr (std::is_base_of<std::forward_iterator_tag, category>::value) {
+            if (std::adjacent_find(first, last, std::not_fn(in_order)) == last) {
+                tree_.assign_sorted(first, static_cast<size_t>(std::distance(first, last)));
+                return;
+            }
+        }
 
-    ordered_set() = default;
+        std::vector<Key, Allocator> staged(first, last, get_allocator());
+        std::stable_sort(staged.begin(), staged.end(), in_order);
+        auto equivalent = [this](const Key& a, const Key& b) { return !key_comp()(a, b); };
+        staged.erase(std::unique(staged.begin(), staged.end(), equivalent), staged.end());
+        tree_.assign_sorted(std::make_move_iterator(staged.begin()), staged.size());
+    }
 
-    ~ordered_set() {
-        clear();
+    void insert(std::initializer_list<Key> init) {
+        insert(init.begin(), init.end());
     }
 
-    // Returns a pair consisting of an iterator to the inserted element(or to the 
-    // element that prevented the insertion) and a bool value set to true if the 
-    // insertion took place.
-    std::pair<ordered_set::iterator, bool> insert(int value) {
-        std::pair<ordered_set::iterator, bool> result{nullptr, false};
-        if (root == nullptr) {
-            root = make_node(value);
-            ++size_;
-            result.first = root;
-            result.second = true;
-        }
-        else {
-            binary_tree_node* inserted_node = nullptr;;
-            if (add_node(root, value, inserted_node)) {
-                ++size_;
-                result.first = inserted_node;
-                result.second = true;
-            }
-        }
-        return result;
+    // O(log n)
+    iterator find(const Key& key) const {
+        return tree_.find(key);
+    }
+
+    template< typename K, typename C = Compare, typename = typename C::is_transparent >
+    iterator find(const K& key) const {
+        return tree_.find(key);
+    }
+
+    // O(log n) - the first key not less than key
+    iterator lower_bound(const Key& key) const {
+        return tree_.lower_bound(key);
+    }
+
+    template< typename K, typename C = Compare, typename = typename C::is_transparent >
+    iterator lower_bound(const K& key) const {
+        return tree_.lower_bound(key);
+    }
+
+    // O(log n) - the first key greater than key
+    iterator upper_bound(const Key& key) const {
+        return tree_.upper_bound(key);
+    }
+
+    template< typename K, typename C = Compare, typename = typename C::is_transparent >
+    iterator upper_bound(const K& key) const {
+        return tree_.upper_bound(key);
+    }
+
+    // O(log n) - the keys equivalent to key, which is at most one
+    std::pair<iterator, iterator> equal_range(const Key& key) const {
+        return { lower_bound(key), upper_bound(key) };
+    }
+
+    template< typename K, typename C = Compare, typename = typename C::is_transparent >
+    std::pair<iterator, iterator> equal_range(const K& key) const {
+        return { lower_bound(key), upper_bound(key) };
+    }
+
+    // O(log n) - the number of keys less than key
+    size_t rank(const Key& key) const {
+        return tree_.rank(key);
     }
 
-    iterator find(const int& key) {
-        binary_tree_node* node = find(root, key);
-        if (node == nullptr) {
-            return iterator(nullptr);
+    template< typename K, typename C = Compare, typename = typename C::is_transparent >
+    size_t rank(const K& key) const {
+        return tree_.rank(key);
+    }
+
+    // O(log n) - the number of keys in [first, last), without visiting them
+    size_t count_range(const Key& first, const Key& last) const {
+        if (!key_comp()(first, last)) {
+            return 0;
         }
-        else {
-            return iterator(node);
+        return rank(last) - rank(first);
+    }
+
+    template< typename K, typename C = Compare, typename = typename C::is_transparent >
+    size_t count_range(const K& first, const K& last) const {
+        if (!key_comp()(first, last)) {
+            return 0;
         }
+        return rank(last) - rank(first);
+    }
+
+    // O(log n) - the key with index i in order, the i + 1 th smallest, or end()
+    // if i >= size()
+    iterator select(size_t i) const {
+        return tree_.select(i);
+    }
+
+    // O(log n) - returns the number of elements removed, 0 or 1
+    size_t erase(const Key& key) {
+        return tree_.erase(key);
+    }
+
+    template< typename K, typename C = Compare, typename = typename C::is_transparent >
+    size_t erase(const K& key) {
+        return tree_.erase(key);
     }
-    //const_iterator find(const int& key) const {
-//
-//    }
 
     // INVESTIGATE why c++11 version has noexcept
     void clear() {
-        deallocate_nodes(root);
-        root = nullptr;
-        size_ = 0;
+        tree_.clear();
     }
 
     size_t size() const {
-        return size_;
+        return tree_.size();
+    }
+
+    key_compare key_comp() const {
+        return tree_.key_comp();
+    }
+
+    allocator_type get_allocator() const {
+        return tree_.get_allocator();
+    }
+
+    // O(log n)
+    iterator begin() const {
+        return tree_.begin();
     }
 
    // O(1)
-    iterator end() {
-        return nullptr;
+    iterator end() const {
+        return tree_.end();
+    }
+
+    const_iterator cbegin() const {
+        return begin();
+    }
+
+    const_iterator cend() const {
+        return end();
+    }
+
+    reverse_iterator rbegin() const {
+        return reverse_iterator(end());
+    }
+
+    reverse_iterator rend() const {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator crbegin() const {
+        return rbegin();
+    }
+
+    const_reverse_iterator crend() const {
+        return rend();
     }
 
   private:
-      binary_tree_node* make_node(int value) {
-          binary_tree_node* node = new binary_tree_node;
-          node->value = value;
-          node->left = nullptr;
-          node->right = nullptr;
-          return node;
-      }
-
-      bool add_node(binary_tree_node* tree, int value, binary_tree_node*& inserted_node) {
-          if (value < tree->value) {
-              if (tree->left == nullptr) {
-                  tree->left = make_node(value);
-                  inserted_node = tree->left;
-                  return true;
-              }
-              else {
-                  return add_node(tree->left, value, inserted_node);
-              }
-          }
-          else if (value > tree->value) {
-              if (tree->right == nullptr) {
-                  tree->right = make_node(value);
-                  inserted_node = tree->right;
-                  return true;
-              }
-              else {
-                  return add_node(tree->right, value, inserted_node);
-              }
-          }
-          // note that if value is equal, do nothing right now
-          return false; // means value already added
-      }
-
-      binary_tree_node* find(binary_tree_node* tree, int value) {
-          if (tree == nullptr || tree->value == value)
-              return tree;
-          else {
-              if (value < tree->value)
-                  return find(tree->left, value);
-              else
-                  return find(tree->right, value);
-          }
-      }
-
-      void deallocate_nodes(binary_tree_node* tree) {
-          if (tree != nullptr) {
-              deallocate_nodes(tree->left);
-              deallocate_nodes(tree->right);
-              delete tree;
-          }
-      }
-
-    binary_tree_node* root = nullptr;
-    size_t size_ = 0;
+    template< typename K, typename C, typename A, typename B >
+    friend ordered_set<K, C, A, B> set_union(ordered_set<K, C, A, B> a, ordered_set<K, C, A, B> b);
 
+    template< typename K, typename C, typename A, typename B >
+    friend ordered_set<K, C, A, B> set_intersection(ordered_set<K, C, A, B> a, ordered_set<K, C, A, B> b);
+
+    template< typename K, typename C, typename A, typename B >
+    friend ordered_set<K, C, A, B> set_difference(ordered_set<K, C, A, B> a, ordered_set<K, C, A, B> b);
+
+    tree_type tree_;
   };
-  
+
+  // Set algebra on whole sets, without a lookup per key.  The result is
+  // made out of the arguments' nodes, so pass them with std::move if they
+  // are not needed afterwards - otherwise each is copied first, in O(n).
+  // Where both have an equivalent key, a's is kept.  Large sets are split
+  // up and the pieces worked on in parallel.
+  template< typename Key, typename Compare, typename Allocator, typename Backend >
+  ordered_set<Key, Compare, Allocator, Backend> set_union(ordered_set<Key, Compare, Allocator, Backend> a,
+                                                          ordered_set<Key, Compare, Allocator, Backend> b) {
+      a.tree_.unite(b.tree_);
+      return a;
+  }
+
+  template< typename Key, typename Compare, typename Allocator, typename Backend >
+  ordered_set<Key, Compare, Allocator, Backend> set_intersection(ordered_set<Key, Compare, Allocator, Backend> a,
+                                                                 ordered_set<Key, Compare, Allocator, Backend> b) {
+      a.tree_.intersect(b.tree_);
+      return a;
+  }
+
+  // the keys of a that are not in b
+  template< typename Key, typename Compare, typename Allocator, typename Backend >
+  ordered_set<Key, Compare, Allocator, Backend> set_difference(ordered_set<Key, Compare, Allocator, Backend> a,
+                                                               ordered_set<Key, Compare, Allocator, Backend> b) {
+      a.tree_.subtract(b.tree_);
+      return a;
+  }
+
+  namespace pmr {
+      // ordered_set whose nodes come from a std::pmr::memory_resource, eg
+      //   std::pmr::monotonic_buffer_resource arena;
+      //   wheel::pmr::ordered_set<int> s(&arena);
+      template< typename Key, typename Compare = std::less<Key>, typename Backend = rb_tree_backend >
+      using ordered_set = wheel::ordered_set<Key, Compare, std::pmr::polymorphic_allocator<Key>, Backend>;
+  }
+
 
 }  // namespace wheel
 
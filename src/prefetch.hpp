@@ -0,0 +1,40 @@
+#ifndef PREFETCH_HPP_
+#define PREFETCH_HPP_
+
+/*
+Software prefetch - a hint to start loading the cache line holding an
+address, so that it has arrived by the time it is needed.  A prefetch never
+faults, so the address need not be valid - but it is passed as an integer
+where it may be past the end of an array, so no out of range pointer is
+ever formed.  Compiles to nothing where there is no way to ask for it.
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+namespace wheel {  // as in re-inventing the wheel
+
+    // the usual line size - 64 bytes on x86-64 and most arm cores
+    constexpr size_t cache_line_bytes = 64;
+
+    inline void prefetch(std::uintptr_t address) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(reinterpret_cast<const void*>(address));
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0);
+#else
+        (void)address;
+#endif
+    }
+
+    inline void prefetch(const void* address) noexcept {
+        prefetch(reinterpret_cast<std::uintptr_t>(address));
+    }
+
+}  // namespace wheel
+
+#endif // PREFETCH_HPP_
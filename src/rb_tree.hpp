@@ -0,0 +1,1293 @@
+/* example:
+
+	8                                      4
+   / \                                    /  \
+  5   10                                 2    6
+ / \    \                              / \   / \
+1   7   12                            1  3  5   7
+
+All nodes on left contain keys < parent node
+All nodes on right contain keys > parent node
+
+The engine behind ordered_set and ordered_map.  It stores Values, orders
+them by the Key that KeyOfValue extracts, compared with Compare.  For a set
+the value is the key, for a map the value is a key/mapped pair.
+
+The tree is a red-black tree, so it stays balanced whatever order values
+arrive in - sorted input does not degenerate into a linked list:
+1. every node is red or black, and the root is black
+2. a red node has no red child
+3. every path from a node down to an empty link passes the same number
+   of black nodes
+Together these keep the longest path at most twice the shortest, so the
+height is at most 2 log2(n + 1).
+
+Binary search tree operations:
+1. basic data structure with value, left, right and parent links plus colour
+2. search - find_node()
+3. insert - try_emplace(), then insert_fixup() recolours and rotates
+4. erase - remove_node(), then erase_fixup()
+5. delete all nodes - deallocate_nodes() - cleanup
+6. walk in order - successor(), predecessor() - for the iterators
+None of these recurse.
+7. bulk build from sorted values - assign_sorted() - recurses, but only
+   log2(n) deep as the tree it builds is balanced
+8. union, intersection and difference of two trees - unite(), intersect(),
+   subtract() - split and join detached subtrees, recursing log2(n) deep,
+   as tasks on the shared thread_pool while there is plenty to do
+
+Nodes are bump allocated from contiguous chunks by a node_pool, so nodes
+inserted together sit together in memory, and clear() hands back whole
+chunks - O(chunks) rather than a free per node.  Erased nodes are recycled.
+
+Operation       Speed
+try_emplace     O(log n)
+assign_sorted   O(n)
+find_node       O(log n)
+erase           O(log n)
+lower_bound     O(log n)
+upper_bound     O(log n)
+rank, select    O(log n)  // each node keeps the size of its subtree
+unite           O(m log(n/m + 1))  // and intersect, subtract - m <= n
+begin           O(log n)
+++, --          O(1)  // amortized - O(log n) worst case
+clear           O(chunks), O(n) if values have a destructor
+*/
+
+#ifndef RB_TREE_HPP_
+#define RB_TREE_HPP_
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "node_pool.hpp"
+#include "thread_pool.hpp"
+
+namespace wheel {  // as in re-inventing the wheel
+
+    template< typename Value >
+    struct binary_tree_node {
+        Value value;
+        binary_tree_node* left = nullptr;
+        binary_tree_node* right = nullptr;
+        binary_tree_node* parent = nullptr;
+        bool red = true;
+        size_t size = 1;   // nodes in the subtree rooted here, for rank and select
+    };
+
+    // KeyOfValue for sets - the value is the key
+    struct identity_key {
+        template< typename T >
+        const T& operator()(const T& value) const { return value; }
+    };
+
+    // KeyOfValue for maps - the key is the first of the pair
+    struct first_key {
+        template< typename Pair >
+        const typename Pair::first_type& operator()(const Pair& value) const { return value.first; }
+    };
+
+    // Holds the comparison object.  An empty one such as std::less is held as
+    // a base class, so the empty base optimisation means it takes no space.
+    template< typename Compare, bool = std::is_empty<Compare>::value && !std::is_final<Compare>::value >
+    class compare_holder : private Compare {
+    public:
+        compare_holder() = default;
+        explicit compare_holder(const Compare& comp) : Compare(comp) {}
+        const Compare& comp() const { return *this; }
+    };
+
+    template< typename Compare >
+    class compare_holder<Compare, false> {
+    public:
+        compare_holder() = default;
+        explicit compare_holder(const Compare& comp) : comp_(comp) {}
+        const Compare& comp() const { return comp_; }
+    private:
+        Compare comp_;
+    };
+
+    template< typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator >
+    class rb_tree : private compare_holder<Compare> {
+    public:
+
+        using node = binary_tree_node<Value>;
+        using allocator_type = Allocator;
+
+        // In order, via the parent links - amortized O(1) per step, since a full
+        // traversal crosses each link twice.  The tree is needed to step back
+        // from end(), which is a null node.
+        template< bool Const >
+        class tree_iterator {
+        public:
+            using value_type = Value;
+            using difference_type = std::ptrdiff_t;
+            using pointer = std::conditional_t<Const, const Value*, Value*>;
+            using reference = std::conditional_t<Const, const Value&, Value&>;
+            using iterator_category = std::bidirectional_iterator_tag;
+
+            constexpr tree_iterator() noexcept = default;
+            constexpr tree_iterator(node* p, const rb_tree* tree) noexcept : ptr_{ p }, tree_{ tree } {}
+
+            // iterator converts to const_iterator, not the other way
+            template< bool WasConst, typename = std::enable_if_t<Const && !WasConst> >
+            constexpr tree_iterator(const tree_iterator<WasConst>& other) noexcept : ptr_{ other.ptr_ }, tree_{ other.tree_ } {}
+
+            tree_iterator& operator++() {
+                ptr_ = successor(ptr_);
+                return *this;
+            }
+
+            tree_iterator operator++(int) {
+                auto old = *this;
+                ++*this;
+                return old;
+            }
+
+            tree_iterator& operator--() {
+                ptr_ = ptr_ ? predecessor(ptr_) : rightmost(tree_->root_);
+                return *this;
+            }
+
+            tree_iterator operator--(int) {
+                auto old = *this;
+                --*this;
+                return old;
+            }
+
+            reference operator*() const { return ptr_->value; }
+            pointer operator->() const { return &ptr_->value; }
+
+            friend bool operator==(const tree_iterator& a, const tree_iterator& b) { return a.ptr_ == b.ptr_; }
+            friend bool operator!=(const tree_iterator& a, const tree_iterator& b) { return a.ptr_ != b.ptr_; }
+
+            node* ptr_ = nullptr;
+            const rb_tree* tree_ = nullptr;
+        };
+
+        using iterator = tree_iterator<false>;
+        using const_iterator = tree_iterator<true>;
+
+        rb_tree() = default;
+
+        rb_tree(const Compare& comp, const Allocator& alloc)
+            : compare_holder<Compare>(comp), pool_(node_allocator(alloc)) {}
+
+        // O(n) - the copy is a bulk build from other's values, in order
+        rb_tree(const rb_tree& other)
+            : rb_tree(other, Allocator(node_traits::select_on_container_copy_construction(other.pool_.allocator()))) {}
+
+        rb_tree(const rb_tree& other, const Allocator& alloc)
+            : compare_holder<Compare>(other.comp()), pool_(node_allocator(alloc)) {
+            assign_sorted(other.begin(), other.size());
+        }
+
+        // O(1) - the nodes change hands, iterators to them stay valid
+        rb_tree(rb_tree&& other) noexcept
+            : compare_holder<Compare>(other.comp()), pool_(other.pool_.allocator()) {
+            swap_nodes(other);
+        }
+
+        // O(n) - as for list, the copy is made with the allocator *this ends up
+        // with, then swapped in
+        rb_tree& operator=(const rb_tree& other) {
+            if (this != &other) {
+                constexpr bool propagate = node_traits::propagate_on_container_copy_assignment::value;
+                rb_tree copy(other, propagate ? Allocator(other.pool_.allocator()) : Allocator(pool_.allocator()));
+                swap_nodes(copy);
+                if constexpr (propagate) {
+                    std::swap(pool_.allocator(), copy.pool_.allocator());
+                }
+                static_cast<compare_holder<Compare>&>(*this) = other;
+            }
+            return *this;
+        }
+
+        // O(1) - unless the allocators differ and cannot be propagated, then
+        // each value is moved into a node of our own, O(n)
+        rb_tree& operator=(rb_tree&& other) noexcept(node_traits::propagate_on_container_move_assignment::value ||
+                                                     node_traits::is_always_equal::value) {
+            if (this == &other) {
+                return *this;
+            }
+            if constexpr (node_traits::propagate_on_container_move_assignment::value) {
+                clear();
+                pool_.allocator() = std::move(other.pool_.allocator());
+                swap_nodes(other);
+            }
+            else {
+                if (node_traits::is_always_equal::value || pool_.allocator() == other.pool_.allocator()) {
+                    clear();
+                    swap_nodes(other);
+                }
+                else {
+                    assign_sorted(std::make_move_iterator(other.begin()), other.size());
+                    other.clear();
+                }
+            }
+            static_cast<compare_holder<Compare>&>(*this) = other;
+            return *this;
+        }
+
+        ~rb_tree() {
+            clear();
+        }
+
+        // O(log n) - if no value has an equivalent key, a node is built from
+        // args and linked in.  Returns the value with key, and whether it is new.
+        // The node is only built once we know it is wanted.
+        template< typename K, typename... Args >
+        std::pair<iterator, bool> try_emplace(const K& key, Args&&... args) {
+            // subtree sizes are counted up on the way down, and put back in
+            // the rare case that nothing is inserted
+            node* parent = nullptr;
+            node** link = &root_;
+            while (*link != nullptr) {
+                parent = *link;
+                if (comp()(key, key_of(parent->value))) {
+                    link = &parent->left;
+                }
+                else if (comp()(key_of(parent->value), key)) {
+                    link = &parent->right;
+                }
+                else {
+                    uncount_path(parent->parent);
+                    return { iterator(parent, this), false };
+                }
+                ++parent->size;
+            }
+
+            node* inserted;
+            try {
+                inserted = make_node(std::forward<Args>(args)...);
+            }
+            catch (...) {
+                uncount_path(parent);
+                throw;
+            }
+            inserted->parent = parent;
+            *link = inserted;
+            ++size_;
+            insert_fixup(inserted);
+            return { iterator(inserted, this), true };
+        }
+
+        // O(n) - replaces the contents with count values read in order from
+        // first, whose keys must be strictly increasing.  The tree is built
+        // bottom-up with no comparisons and no rotations: each subtree is split
+        // evenly around its middle value, so every level is full except maybe
+        // the last, and the nodes of that last level are red.  Nodes come from
+        // one contiguous run of the pool, in key order.
+        template< typename InputIterator >
+        void assign_sorted(InputIterator first, size_t count) {
+            clear();
+            if (count == 0) {
+                return;
+            }
+            size_t deepest = 0;   // depth of the last level
+            while ((count >> (deepest + 1)) != 0) {
+                ++deepest;
+            }
+            pool_.reserve(count);
+            try {
+                root_ = build_balanced(first, count, 0, deepest);
+            }
+            catch (...) {
+                pool_.release();
+                throw;
+            }
+            root_->parent = nullptr;
+            size_ = count;
+        }
+
+        // O(log n) - one comparison per level, then one to check for equivalence.
+        // K is Key, or anything Compare can compare with Key if it is transparent.
+        template< typename K >
+        node* find_node(const K& key) const {
+            node* candidate = lower_node(key);
+            if (candidate != nullptr && !comp()(key, key_of(candidate->value))) {
+                return candidate;
+            }
+            return nullptr;
+        }
+
+        // O(log n) - the first node whose key is not less than key, or null
+        template< typename K >
+        node* lower_node(const K& key) const {
+            node* candidate = nullptr;
+            node* tree = root_;
+            while (tree != nullptr) {
+                if (!comp()(key_of(tree->value), key)) {
+                    candidate = tree;
+                    tree = tree->left;
+                }
+                else {
+                    tree = tree->right;
+                }
+            }
+            return candidate;
+        }
+
+        // O(log n) - the first node whose key is greater than key, or null
+        template< typename K >
+        node* upper_node(const K& key) const {
+            node* candidate = nullptr;
+            node* tree = root_;
+            while (tree != nullptr) {
+                if (comp()(key, key_of(tree->value))) {
+                    candidate = tree;
+                    tree = tree->left;
+                }
+                else {
+                    tree = tree->right;
+                }
+            }
+            return candidate;
+        }
+
+        template< typename K >
+        iterator find(const K& key) {
+            return iterator(find_node(key), this);
+        }
+
+        template< typename K >
+        const_iterator find(const K& key) const {
+            return const_iterator(find_node(key), this);
+        }
+
+        template< typename K >
+        iterator lower_bound(const K& key) {
+            return iterator(lower_node(key), this);
+        }
+
+        template< typename K >
+        const_iterator lower_bound(const K& key) const {
+            return const_iterator(lower_node(key), this);
+        }
+
+        template< typename K >
+        iterator upper_bound(const K& key) {
+            return iterator(upper_node(key), this);
+        }
+
+        template< typename K >
+        const_iterator upper_bound(const K& key) const {
+            return const_iterator(upper_node(key), this);
+        }
+
+        // O(log n) - how many values have keys less than key.  Going right
+        // passes over the left subtree and the node itself.
+        template< typename K >
+        size_t rank(const K& key) const {
+            size_t less = 0;
+            node* tree = root_;
+            while (tree != nullptr) {
+                if (comp()(key_of(tree->value), key)) {
+                    less += subtree_size(tree->left) + 1;
+                    tree = tree->right;
+                }
+                else {
+                    tree = tree->left;
+                }
+            }
+            return less;
+        }
+
+        // O(log n) - the value with index i in order, or end() if there are
+        // not that many
+        const_iterator select(size_t i) const {
+            node* tree = root_;
+            while (tree != nullptr) {
+                size_t left = subtree_size(tree->left);
+                if (i < left) {
+                    tree = tree->left;
+                }
+                else if (i == left) {
+                    break;
+                }
+                else {
+                    i -= left + 1;
+                    tree = tree->right;
+                }
+            }
+            return const_iterator(tree, this);
+        }
+
+        // O(log n) - returns the number of elements removed, 0 or 1
+        template< typename K >
+        size_t erase(const K& key) {
+            node* found = find_node(key);
+            if (found == nullptr) {
+                return 0;
+            }
+            remove_node(found);
+            destroy_node(found);
+            --size_;
+            return 1;
+        }
+
+        // Set algebra on whole trees.  For trees of m and n values, m <= n,
+        // each is O(m log(n/m + 1)) - O(m) when the sizes are close, O(log n)
+        // when one is tiny - rather than O(m log n) for a lookup per value.
+        // *this becomes the result, built out of the two trees' nodes, and
+        // other ends up empty.  Where both have a value with the same key,
+        // *this's is kept.  Compare must not throw.
+        void unite(rb_tree& other) {
+            combine(other, [this](subtree a, subtree b, unsigned spawn, discarded& trash) {
+                return union_of(a, b, spawn, trash);
+            });
+        }
+
+        void intersect(rb_tree& other) {
+            combine(other, [this](subtree a, subtree b, unsigned spawn, discarded& trash) {
+                return intersection_of(a, b, spawn, trash);
+            });
+        }
+
+        // takes away the values whose keys are in other
+        void subtract(rb_tree& other) {
+            combine(other, [this](subtree a, subtree b, unsigned spawn, discarded& trash) {
+                return difference_of(a, b, spawn, trash);
+            });
+        }
+
+        // O(chunks) - only values needing a destructor are visited
+        void clear() {
+            if constexpr (!std::is_trivially_destructible<Value>::value) {
+                deallocate_nodes(root_);
+            }
+            pool_.release();
+            root_ = nullptr;
+            size_ = 0;
+        }
+
+        size_t size() const {
+            return size_;
+        }
+
+        // O(log n) - down the left edge
+        iterator begin() {
+            return iterator(leftmost(root_), this);
+        }
+
+        const_iterator begin() const {
+            return const_iterator(leftmost(root_), this);
+        }
+
+        // O(1)
+        iterator end() {
+            return iterator(nullptr, this);
+        }
+
+        const_iterator end() const {
+            return const_iterator(nullptr, this);
+        }
+
+        const Compare& key_comp() const {
+            return comp();
+        }
+
+        allocator_type get_allocator() const {
+            return Allocator(pool_.allocator());
+        }
+
+    private:
+        using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<node>;
+        using node_traits = std::allocator_traits<node_allocator>;
+
+        using compare_holder<Compare>::comp;
+
+        static const Key& key_of(const Value& value) {
+            return KeyOfValue()(value);
+        }
+
+        // new nodes are red, so that adding one never changes a black height.
+        // The value is built through the allocator, so that a scoped allocator
+        // such as std::pmr::polymorphic_allocator reaches it too.
+        template< typename... Args >
+        node* make_node(Args&&... args) {
+            node* n = pool_.allocate();
+            try {
+                node_traits::construct(pool_.allocator(), std::addressof(n->value), std::forward<Args>(args)...);
+            }
+            catch (...) {
+                pool_.deallocate(n);
+                throw;
+            }
+            n->left = nullptr;
+            n->right = nullptr;
+            n->parent = nullptr;
+            n->red = true;
+            n->size = 1;
+            return n;
+        }
+
+        // builds a subtree of count values from first, in order - left subtree,
+        // node, right subtree - so nodes are allocated in key order.  Recursion
+        // depth is log2(count).  If a value throws, the values built so far are
+        // destroyed, and assign_sorted releases their nodes.
+        template< typename InputIterator >
+        node* build_balanced(InputIterator& first, size_t count, size_t depth, size_t deepest) {
+            if (count == 0) {
+                return nullptr;
+            }
+            size_t left_count = (count - 1) / 2;
+            node* left = build_balanced(first, left_count, depth + 1, deepest);
+            node* n;
+            try {
+                n = make_node(*first);
+            }
+            catch (...) {
+                deallocate_nodes(left);
+                throw;
+            }
+            ++first;
+            try {
+                n->right = build_balanced(first, count - left_count - 1, depth + 1, deepest);
+            }
+            catch (...) {
+                deallocate_nodes(left);
+                node_traits::destroy(pool_.allocator(), std::addressof(n->value));
+                throw;
+            }
+            n->left = left;
+            if (left) {
+                left->parent = n;
+            }
+            if (n->right) {
+                n->right->parent = n;
+            }
+            n->red = depth == deepest && depth > 0;
+            n->size = count;
+            return n;
+        }
+
+        // the node goes back on the pool's free list for the next insert
+        void destroy_node(node* n) {
+            node_traits::destroy(pool_.allocator(), std::addressof(n->value));
+            pool_.deallocate(n);
+        }
+
+        static node* leftmost(node* n) {
+            while (n && n->left) {
+                n = n->left;
+            }
+            return n;
+        }
+
+        static node* rightmost(node* n) {
+            while (n && n->right) {
+                n = n->right;
+            }
+            return n;
+        }
+
+        // the next node in order - the leftmost of the right subtree, or else
+        // the first ancestor we reach from its left.  Null after the last.
+        static node* successor(node* n) {
+            if (n->right) {
+                return leftmost(n->right);
+            }
+            node* parent = n->parent;
+            while (parent && n == parent->right) {
+                n = parent;
+                parent = parent->parent;
+            }
+            return parent;
+        }
+
+        // mirror image of successor
+        static node* predecessor(node* n) {
+            if (n->left) {
+                return rightmost(n->left);
+            }
+            node* parent = n->parent;
+            while (parent && n == parent->left) {
+                n = parent;
+                parent = parent->parent;
+            }
+            return parent;
+        }
+
+        static size_t subtree_size(const node* n) {
+            return n ? n->size : 0;
+        }
+
+        // n and every node above it has one fewer below it
+        static void uncount_path(node* n) {
+            for (; n != nullptr; n = n->parent) {
+                --n->size;
+            }
+        }
+
+        static bool is_red(const node* n) {
+            return n != nullptr && n->red;
+        }
+
+        /*
+             x               y
+            / \             / \
+           a   y    ->     x   c
+              / \         / \
+             b   c       a   b
+        */
+        void rotate_left(node* x) {
+            node* y = x->right;
+            x->right = y->left;
+            if (y->left) {
+                y->left->parent = x;
+            }
+            replace_child(x, y);
+            y->left = x;
+            x->parent = y;
+            y->size = x->size;
+            x->size = subtree_size(x->left) + subtree_size(x->right) + 1;
+        }
+
+        // mirror image of rotate_left
+        void rotate_right(node* x) {
+            node* y = x->left;
+            x->left = y->right;
+            if (y->right) {
+                y->right->parent = x;
+            }
+            replace_child(x, y);
+            y->right = x;
+            x->parent = y;
+            y->size = x->size;
+            x->size = subtree_size(x->left) + subtree_size(x->right) + 1;
+        }
+
+        // makes replacement take x's place under x's parent
+        void replace_child(node* x, node* replacement) {
+            node* parent = x->parent;
+            if (parent == nullptr) {
+                root_ = replacement;
+            }
+            else if (x == parent->left) {
+                parent->left = replacement;
+            }
+            else {
+                parent->right = replacement;
+            }
+            if (replacement) {
+                replacement->parent = parent;
+            }
+        }
+
+        // x is red, so the only rule that can be broken is a red parent.
+        // A red uncle means recolour and move the problem two levels up, a black
+        // uncle means at most two rotations and we are done.
+        void insert_fixup(node* x) {
+            while (is_red(x->parent)) {
+                node* parent = x->parent;
+                node* grandparent = parent->parent;  // exists, a red node is never the root_
+                if (parent == grandparent->left) {
+                    node* uncle = grandparent->right;
+                    if (is_red(uncle)) {
+                        parent->red = false;
+                        uncle->red = false;
+                        grandparent->red = true;
+                        x = grandparent;
+                    }
+                    else {
+                        if (x == parent->right) {
+                            x = parent;
+                            rotate_left(x);
+                            parent = x->parent;
+                        }
+                        parent->red = false;
+                        grandparent->red = true;
+                        rotate_right(grandparent);
+                    }
+                }
+                else {
+                    node* uncle = grandparent->left;
+                    if (is_red(uncle)) {
+                        parent->red = false;
+                        uncle->red = false;
+                        grandparent->red = true;
+                        x = grandparent;
+                    }
+                    else {
+                        if (x == parent->left) {
+                            x = parent;
+                            rotate_right(x);
+                            parent = x->parent;
+                        }
+                        parent->red = false;
+                        grandparent->red = true;
+                        rotate_left(grandparent);
+                    }
+                }
+            }
+            root_->red = false;
+        }
+
+        // unlinks x from the tree, rebalancing if a black node went missing
+        void remove_node(node* x) {
+            node* child = nullptr;          // moves into the vacated position
+            node* child_parent = nullptr;   // child may be null, so track its parent
+            bool removed_red = x->red;
+
+            // the node that really leaves its place is x, or the successor
+            // that replaces it - every subtree above that loses one
+            node* vacated = x->left && x->right ? leftmost(x->right) : x;
+            uncount_path(vacated->parent);
+
+            if (x->left == nullptr) {
+                child = x->right;
+                child_parent = x->parent;
+                replace_child(x, child);
+            }
+            else if (x->right == nullptr) {
+                child = x->left;
+                child_parent = x->parent;
+                replace_child(x, child);
+            }
+            else {
+                // two children - the in-order successor takes x's place
+                node* next = leftmost(x->right);
+                removed_red = next->red;
+                child = next->right;
+                if (next->parent == x) {
+                    child_parent = next;
+                }
+                else {
+                    child_parent = next->parent;
+                    replace_child(next, child);
+                    next->right = x->right;
+                    next->right->parent = next;
+                }
+                replace_child(x, next);
+                next->left = x->left;
+                next->left->parent = next;
+                next->red = x->red;
+                next->size = x->size;
+            }
+
+            if (!removed_red) {
+                erase_fixup(child, child_parent);
+            }
+        }
+
+        // the path through x is one black short.  Borrow from the sibling's
+        // side by recolouring and rotating, or push the deficit up a level.
+        void erase_fixup(node* x, node* parent) {
+            while (x != root_ && !is_red(x)) {
+                if (x == parent->left) {
+                    node* sibling = parent->right;  // exists, it has black height >= 1
+                    if (sibling->red) {
+                        sibling->red = false;
+                        parent->red = true;
+                        rotate_left(parent);
+                        sibling = parent->right;
+                    }
+                    if (!is_red(sibling->left) && !is_red(sibling->right)) {
+                        sibling->red = true;
+                        x = parent;
+                        parent = x->parent;
+                    }
+                    else {
+                        if (!is_red(sibling->right)) {
+                            sibling->left->red = false;
+                            sibling->red = true;
+                            rotate_right(sibling);
+                            sibling = parent->right;
+                        }
+                        sibling->red = parent->red;
+                        parent->red = false;
+                        sibling->right->red = false;
+                        rotate_left(parent);
+                        x = root_;
+                    }
+                }
+                else {
+                    node* sibling = parent->left;
+                    if (sibling->red) {
+                        sibling->red = false;
+                        parent->red = true;
+                        rotate_right(parent);
+                        sibling = parent->left;
+                    }
+                    if (!is_red(sibling->left) && !is_red(sibling->right)) {
+                        sibling->red = true;
+                        x = parent;
+                        parent = x->parent;
+                    }
+                    else {
+                        if (!is_red(sibling->left)) {
+                            sibling->right->red = false;
+                            sibling->red = true;
+                            rotate_left(sibling);
+                            sibling = parent->left;
+                        }
+                        sibling->red = parent->red;
+                        parent->red = false;
+                        sibling->left->red = false;
+                        rotate_right(parent);
+                        x = root_;
+                    }
+                }
+            }
+            if (x) {
+                x->red = false;
+            }
+        }
+
+        void swap_nodes(rb_tree& other) noexcept {
+            pool_.swap_storage(other.pool_);
+            std::swap(root_, other.root_);
+            std::swap(size_, other.size_);
+        }
+
+        /*
+        Set algebra by split and join, after Blelloch, Ferizovic and Sun,
+        "Just Join for Parallel Ordered Sets".  Two primitives do all the
+        balancing:
+          join(l, k, r)   every key in l < k's < every key in r - links them into
+                          one tree in O(difference in black height)
+          split(t, key)   the keys of t less than key, the node with key if there
+                          is one, and the keys greater - O(log n)
+        Union then splits b around a's root and recurses on the two halves on
+        each side, which are independent, so they can run on two threads.
+        Intersection and difference have the same shape.
+
+        The pieces are worked on as detached subtrees, so rotations here touch
+        only the nodes they are given, never root_.  Every subtree has a black
+        root, so a black height is all it takes to join two.
+        */
+
+        // a detached subtree and its black height - the black nodes on any path
+        // from its root down, the root included
+        struct subtree {
+            node* root = nullptr;
+            size_t height = 0;
+        };
+
+        struct split_result {
+            subtree less;
+            node* equal;
+            subtree greater;
+        };
+
+        // Nodes and whole subtrees a set operation drops, linked through their
+        // parent pointers.  Each task has its own, so parallel tasks never touch
+        // the pool; the values are destroyed and the nodes freed by recycle() at
+        // the end, on one thread, in case the allocator is not thread safe.
+        struct discarded {
+            node* head = nullptr;
+            node* tail = nullptr;
+
+            void push_tree(node* n) {
+                if (n == nullptr) {
+                    return;
+                }
+                n->parent = head;
+                head = n;
+                if (tail == nullptr) {
+                    tail = n;
+                }
+            }
+
+            // just n, not its children
+            void push_node(node* n) {
+                n->left = nullptr;
+                n->right = nullptr;
+                n->size = 1;
+                push_tree(n);
+            }
+
+            void splice(discarded& other) {
+                if (other.head == nullptr) {
+                    return;
+                }
+                other.tail->parent = head;
+                head = other.head;
+                if (tail == nullptr) {
+                    tail = other.tail;
+                }
+            }
+        };
+
+        // sets below this many values between them are not worth a thread
+        static constexpr size_t parallel_cutoff = 1 << 16;
+
+        template< typename Operation >
+        void combine(rb_tree& other, Operation operation) {
+            node* other_root = take_nodes(other);
+            discarded trash;
+            subtree result = operation(subtree{ root_, black_height(root_) },
+                                       subtree{ other_root, black_height(other_root) }, spawn_depth(), trash);
+            root_ = result.root;
+            if (root_) {
+                root_->parent = nullptr;
+            }
+            size_ = subtree_size(root_);
+            recycle(trash);
+        }
+
+        // moves other's nodes into our pool and returns its root, leaving other
+        // empty.  Nodes from an allocator that is not equal to ours are no use
+        // here, so then the values are first moved into nodes of our own, O(m).
+        node* take_nodes(rb_tree& other) {
+            if (!node_traits::is_always_equal::value && !(pool_.allocator() == other.pool_.allocator())) {
+                rb_tree moved(comp(), Allocator(pool_.allocator()));
+                moved.assign_sorted(std::make_move_iterator(other.begin()), other.size());
+                other.clear();
+                return take_nodes(moved);
+            }
+            pool_.adopt(other.pool_);
+            node* root = other.root_;
+            other.root_ = nullptr;
+            other.size_ = 0;
+            return root;
+        }
+
+        // The dropped nodes go back on the free list.  A dropped subtree whose
+        // values need no destructor is not walked - that could cost more than
+        // the operation itself - its nodes come back with the pool's slabs.
+        void recycle(discarded& trash) {
+            node* n = trash.head;
+            while (n != nullptr) {
+                node* next = n->parent;
+                if constexpr (std::is_trivially_destructible<Value>::value) {
+                    if (n->size == 1) {
+                        pool_.deallocate(n);
+                    }
+                }
+                else {
+                    recycle_nodes(n);
+                }
+                n = next;
+            }
+        }
+
+        // how many levels of the recursion fork - enough for a task per core.
+        // Asking for the number of cores can mean reading a file, so it is
+        // only done once.
+        static unsigned spawn_depth() {
+            static const unsigned depth = [] {
+                unsigned levels = 0;
+                for (unsigned threads = std::thread::hardware_concurrency(); threads > 1; threads = (threads + 1) / 2) {
+                    ++levels;
+                }
+                return levels;
+            }();
+            return depth;
+        }
+
+        // runs left and right, each given a spawn budget and a discarded list,
+        // as two tasks on the shared thread_pool if there is budget left and
+        // work enough for both - parallel_for joins them, and a worker that
+        // forks helps with its own tasks rather than blocking
+        template< typename Left, typename Right >
+        static std::pair<subtree, subtree> fork(size_t work, unsigned spawn, discarded& trash, Left left, Right right) {
+            if (spawn == 0 || work < parallel_cutoff) {
+                subtree less = left(spawn, trash);
+                return { less, right(spawn, trash) };
+            }
+            discarded left_trash;
+            subtree less;
+            subtree greater;
+            thread_pool::shared().parallel_for(0, 2, [&](size_t begin, size_t end) {
+                for (size_t side = begin; side != end; ++side) {
+                    if (side == 0) {
+                        less = left(spawn - 1, left_trash);
+                    }
+                    else {
+                        greater = right(spawn - 1, trash);
+                    }
+                }
+            }, 1);
+            trash.splice(left_trash);
+            return { less, greater };
+        }
+
+        static size_t black_height(const node* n) {
+            size_t height = 0;
+            for (; n != nullptr; n = n->left) {
+                height += !n->red;
+            }
+            return height;
+        }
+
+        // a child of a black root of black height parent_height, as a subtree of
+        // its own - blackened if it is red
+        static subtree child_tree(node* child, size_t parent_height) {
+            subtree tree{ child, parent_height - 1 };
+            if (is_red(child)) {
+                child->red = false;
+                ++tree.height;
+            }
+            return tree;
+        }
+
+        static void link(node* n, node* left, node* right) {
+            n->left = left;
+            n->right = right;
+            if (left) {
+                left->parent = n;
+            }
+            if (right) {
+                right->parent = n;
+            }
+            n->size = subtree_size(left) + subtree_size(right) + 1;
+        }
+
+        // rotate_left and rotate_right for a detached subtree - returns the new
+        // subtree root, whose parent the caller sets
+        static node* rotate_left_detached(node* x) {
+            node* y = x->right;
+            x->right = y->left;
+            if (y->left) {
+                y->left->parent = x;
+            }
+            y->left = x;
+            x->parent = y;
+            y->size = x->size;
+            x->size = subtree_size(x->left) + subtree_size(x->right) + 1;
+            return y;
+        }
+
+        static node* rotate_right_detached(node* x) {
+            node* y = x->left;
+            x->left = y->right;
+            if (y->right) {
+                y->right->parent = x;
+            }
+            y->right = x;
+            x->parent = y;
+            y->size = x->size;
+            x->size = subtree_size(x->left) + subtree_size(x->right) + 1;
+            return y;
+        }
+
+        // O(log n) - every key in left is less than k's, which is less than every
+        // key in right.  If one side is higher, k goes red onto its spine, at the
+        // first black node no higher than the other side, with those two as its
+        // children - see join_right.  Red roots are made black, so the result
+        // has a black root too.
+        static subtree join(subtree left, node* k, subtree right) {
+            subtree joined;
+            if (left.height > right.height) {
+                joined = { join_right(left.root, left.height, k, right.root, right.height), left.height };
+            }
+            else if (left.height < right.height) {
+                joined = { join_left(left.root, left.height, k, right.root, right.height), right.height };
+            }
+            else {
+                link(k, left.root, right.root);
+                k->red = false;
+                return { k, left.height + 1 };
+            }
+            if (joined.root->red) {
+                joined.root->red = false;
+                ++joined.height;
+            }
+            return joined;
+        }
+
+        // down t's right spine to a black node of black height r_height.  k, red,
+        // takes its place.  That breaks at most the no red under red rule, and
+        // only just below a red node, which is put right at the black node above
+        // by a rotation - much as in insert_fixup.
+        static node* join_right(node* t, size_t t_height, node* k, node* r, size_t r_height) {
+            if (t_height == r_height && !is_red(t)) {
+                link(k, t, r);
+                k->red = true;
+                return k;
+            }
+            node* right = join_right(t->right, t->red ? t_height : t_height - 1, k, r, r_height);
+            t->right = right;
+            right->parent = t;
+            t->size = subtree_size(t->left) + right->size + 1;
+            if (!t->red && right->red && is_red(right->right)) {
+                right->right->red = false;
+                return rotate_left_detached(t);
+            }
+            return t;
+        }
+
+        // mirror image of join_right
+        static node* join_left(node* l, size_t l_height, node* k, node* t, size_t t_height) {
+            if (t_height == l_height && !is_red(t)) {
+                link(k, l, t);
+                k->red = true;
+                return k;
+            }
+            node* left = join_left(l, l_height, k, t->left, t->red ? t_height : t_height - 1);
+            t->left = left;
+            left->parent = t;
+            t->size = left->size + subtree_size(t->right) + 1;
+            if (!t->red && left->red && is_red(left->left)) {
+                left->left->red = false;
+                return rotate_right_detached(t);
+            }
+            return t;
+        }
+
+        // O(log n) - joins the left and right pieces back up on the way out of
+        // the search for key
+        template< typename K >
+        split_result split(subtree tree, const K& key) const {
+            node* n = tree.root;
+            if (n == nullptr) {
+                return { subtree{}, nullptr, subtree{} };
+            }
+            subtree less = child_tree(n->left, tree.height);
+            subtree greater = child_tree(n->right, tree.height);
+            if (comp()(key, key_of(n->value))) {
+                split_result parts = split(less, key);
+                parts.greater = join(parts.greater, n, greater);
+                return parts;
+            }
+            if (comp()(key_of(n->value), key)) {
+                split_result parts = split(greater, key);
+                parts.less = join(less, n, parts.less);
+                return parts;
+            }
+            return { less, n, greater };
+        }
+
+        // O(log n) - the tree without its last node, and that node
+        static std::pair<subtree, node*> split_last(subtree tree) {
+            node* n = tree.root;
+            subtree less = child_tree(n->left, tree.height);
+            if (n->right == nullptr) {
+                return { less, n };
+            }
+            std::pair<subtree, node*> rest = split_last(child_tree(n->right, tree.height));
+            return { join(less, n, rest.first), rest.second };
+        }
+
+        // join without a middle node - borrows the last of left
+        static subtree join(subtree left, subtree right) {
+            if (left.root == nullptr) {
+                return right;
+            }
+            std::pair<subtree, node*> rest = split_last(left);
+            return join(rest.first, rest.second, right);
+        }
+
+        // split b around a's root and unite the halves on each side of it
+        subtree union_of(subtree a, subtree b, unsigned spawn, discarded& trash) const {
+            if (a.root == nullptr) {
+                return b;
+            }
+            if (b.root == nullptr) {
+                return a;
+            }
+            node* k = a.root;
+            subtree a_less = child_tree(k->left, a.height);
+            subtree a_greater = child_tree(k->right, a.height);
+            size_t work = a.root->size + b.root->size;
+            split_result parts = split(b, key_of(k->value));
+            if (parts.equal) {
+                trash.push_node(parts.equal);
+            }
+            std::pair<subtree, subtree> halves = fork(work, spawn, trash,
+                [&](unsigned budget, discarded& t) { return union_of(a_less, parts.less, budget, t); },
+                [&](unsigned budget, discarded& t) { return union_of(a_greater, parts.greater, budget, t); });
+            return join(halves.first, k, halves.second);
+        }
+
+        // a's root stays if b has its key, otherwise it goes
+        subtree intersection_of(subtree a, subtree b, unsigned spawn, discarded& trash) const {
+            if (a.root == nullptr || b.root == nullptr) {
+                trash.push_tree(a.root);
+                trash.push_tree(b.root);
+                return subtree{};
+            }
+            node* k = a.root;
+            subtree a_less = child_tree(k->left, a.height);
+            subtree a_greater = child_tree(k->right, a.height);
+            size_t work = a.root->size + b.root->size;
+            split_result parts = split(b, key_of(k->value));
+            std::pair<subtree, subtree> halves = fork(work, spawn, trash,
+                [&](unsigned budget, discarded& t) { return intersection_of(a_less, parts.less, budget, t); },
+                [&](unsigned budget, discarded& t) { return intersection_of(a_greater, parts.greater, budget, t); });
+            if (parts.equal) {
+                trash.push_node(parts.equal);
+                return join(halves.first, k, halves.second);
+            }
+            trash.push_node(k);
+            return join(halves.first, halves.second);
+        }
+
+        // split a around b's root, which goes, along with any match in a
+        subtree difference_of(subtree a, subtree b, unsigned spawn, discarded& trash) const {
+            if (a.root == nullptr || b.root == nullptr) {
+                trash.push_tree(b.root);
+                return a;
+            }
+            node* k = b.root;
+            subtree b_less = child_tree(k->left, b.height);
+            subtree b_greater = child_tree(k->right, b.height);
+            size_t work = a.root->size + b.root->size;
+            split_result parts = split(a, key_of(k->value));
+            trash.push_node(k);
+            if (parts.equal) {
+                trash.push_node(parts.equal);
+            }
+            std::pair<subtree, subtree> halves = fork(work, spawn, trash,
+                [&](unsigned budget, discarded& t) { return difference_of(parts.less, b_less, budget, t); },
+                [&](unsigned budget, discarded& t) { return difference_of(parts.greater, b_greater, budget, t); });
+            return join(halves.first, halves.second);
+        }
+
+        // as deallocate_nodes, but the nodes go back on the free list
+        void recycle_nodes(node* tree) {
+            while (tree != nullptr) {
+                node* left = tree->left;
+                if (left != nullptr) {
+                    tree->left = left->right;
+                    left->right = tree;
+                    tree = left;
+                }
+                else {
+                    node* right = tree->right;
+                    destroy_node(tree);
+                    tree = right;
+                }
+            }
+        }
+
+        // O(n) time, O(1) space - a node with a left child is rotated right until
+        // it has none, then it is destroyed and we carry on with its right subtree.
+        // The nodes' memory goes back with the pool's chunks.
+        void deallocate_nodes(node* tree) {
+            while (tree != nullptr) {
+                node* left = tree->left;
+                if (left != nullptr) {
+                    tree->left = left->right;
+                    left->right = tree;
+                    tree = left;
+                }
+                else {
+                    node* right = tree->right;
+                    node_traits::destroy(pool_.allocator(), std::addressof(tree->value));
+                    tree = right;
+                }
+            }
+        }
+
+
+        node* root_ = nullptr;
+        size_t size_ = 0;
+        node_pool<node, node_allocator> pool_;  // every node lives in here
+    };
+
+    // ordered_set backend policy selecting the red-black tree - the default
+    struct rb_tree_backend {
+        template< typename Key, typename Value, typename KeyOfValue, typename Compare, typename Allocator >
+        using tree = rb_tree<Key, Value, KeyOfValue, Compare, Allocator>;
+    };
+
+}  // namespace wheel
+
+#endif // RB_TREE_HPP_
@@ -0,0 +1,483 @@
+/*
+Vectorised find, count, min, max, sum and equal for arrays of ints and
+floating point numbers - over a wheel::vector, or any [first, last) of
+pointers.
+
+The standard algorithms look at one element per step; these look at a
+whole register's worth - 8 ints or floats with AVX2, 4 with SSE4.2 - and
+find and equal check four registers between branches.  The code for each
+operation is written once, with GCC's vector extensions, and compiled
+twice, inside functions marked target("avx2") and target("sse4.2"), so the
+rest of the program needs no special compiler flags.  Which copy runs is
+decided once, at the first call, by asking the cpu with CPUID (and the OS,
+for AVX, with XGETBV).  Without either, or for element types other than 4
+and 8 byte integers, float and double, or on other compilers and cpus, the
+plain standard algorithm runs instead.
+
+Results are those of the standard algorithms, with two exceptions:
+1. sum adds the lanes separately and then together, so a floating point
+   sum is rounded differently from std::accumulate's left to right one.
+   Integers are summed in 64 bits, wrapping on overflow.
+2. min and max of a range holding a NaN are unspecified.
+
+Operation       Speed
+find            O(n)  // and count, min, max, sum, equal - n / lanes steps
+detected_level  O(1)  // CPUID once, then cached
+*/
+
+#ifndef SIMD_HPP_
+#define SIMD_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <numeric>
+#include <type_traits>
+
+#include "vector.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define WHEEL_SIMD_X86
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace wheel {  // as in re-inventing the wheel
+namespace simd {
+
+    // the instruction sets there are kernels for, in order
+    enum class level { scalar, sse4, avx2 };
+
+    // the integer sum is 64 bits, so it does not overflow where the elements would
+    template< typename T >
+    using sum_type = std::conditional_t<std::is_floating_point<T>::value, T,
+                     std::conditional_t<std::is_signed<T>::value, long long, unsigned long long>>;
+
+    namespace detail {
+
+        // the best level this cpu and OS support
+        inline level detect() {
+#ifdef WHEEL_SIMD_X86
+            unsigned int eax, ebx, ecx, edx;
+            if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+                return level::scalar;
+            }
+            bool sse4 = (ecx & bit_SSE4_1) && (ecx & bit_SSE4_2);
+            // AVX registers are only usable if the OS saves them on a context
+            // switch - XCR0 bits 1 and 2, read with XGETBV
+            bool avx = false;
+            if ((ecx & bit_OSXSAVE) && (ecx & bit_AVX)) {
+                unsigned int xcr0_low, xcr0_high;
+                __asm__("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+                avx = (xcr0_low & 6) == 6;
+            }
+            bool avx2 = avx && __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & bit_AVX2);
+            return avx2 ? level::avx2 : sse4 ? level::sse4 : level::scalar;
+#else
+            return level::scalar;
+#endif
+        }
+
+        inline std::atomic<level>& chosen() {
+            static std::atomic<level> in_use(detect());
+            return in_use;
+        }
+
+        // keeps a parameter out of template argument deduction, so find(v, 0)
+        // works for a vector of any T
+        template< typename T >
+        struct same {
+            using type = T;
+        };
+
+        // the element types the kernels handle - the rest use the standard
+        // algorithms
+        template< typename T >
+        constexpr bool vectorised = std::is_arithmetic<T>::value && !std::is_same<T, bool>::value
+                                    && (sizeof(T) == 4 || sizeof(T) == 8);
+
+        // Each kernel has a scalar version, the standard algorithm, and on x86
+        // a vector one, run<Bytes>, for registers of Bytes bytes.  run is
+        // always inlined, so it is compiled for the instruction set of the
+        // target function it is called from.
+        struct find_kernel {
+            template< typename T >
+            static const T* scalar(const T* first, const T* last, T value) {
+                return std::find(first, last, value);
+            }
+#ifdef WHEEL_SIMD_X86
+            template< size_t Bytes, typename T >
+            __attribute__((always_inline)) static inline const T* run(const T* first, const T* last, T value);
+#endif
+        };
+
+        struct count_kernel {
+            template< typename T >
+            static size_t scalar(const T* first, const T* last, T value) {
+                return static_cast<size_t>(std::count(first, last, value));
+            }
+#ifdef WHEEL_SIMD_X86
+            template< size_t Bytes, typename T >
+            __attribute__((always_inline)) static inline size_t run(const T* first, const T* last, T value);
+#endif
+        };
+
+        template< bool Max >
+        struct extreme_kernel {
+            template< typename T >
+            static T scalar(const T* first, const T* last) {
+                return Max ? *std::max_element(first, last) : *std::min_element(first, last);
+            }
+#ifdef WHEEL_SIMD_X86
+            template< size_t Bytes, typename T >
+            __attribute__((always_inline)) static inline T run(const T* first, const T* last);
+#endif
+        };
+
+        struct sum_kernel {
+            template< typename T >
+            static sum_type<T> scalar(const T* first, const T* last) {
+                if constexpr (std::is_floating_point<T>::value) {
+                    return std::accumulate(first, last, T());
+                }
+                else {
+                    // unsigned, so overflow wraps
+                    unsigned long long total = 0;
+                    for (; first != last; ++first) {
+                        total += static_cast<unsigned long long>(static_cast<sum_type<T>>(*first));
+                    }
+                    return static_cast<sum_type<T>>(total);
+                }
+            }
+#ifdef WHEEL_SIMD_X86
+            template< size_t Bytes, typename T >
+            __attribute__((always_inline)) static inline sum_type<T> run(const T* first, const T* last);
+#endif
+        };
+
+        struct equal_kernel {
+            template< typename T >
+            static bool scalar(const T* first, const T* last, const T* other) {
+                return std::equal(first, last, other);
+            }
+#ifdef WHEEL_SIMD_X86
+            template< size_t Bytes, typename T >
+            __attribute__((always_inline)) static inline bool run(const T* first, const T* last, const T* other);
+#endif
+        };
+
+#ifdef WHEEL_SIMD_X86
+        // Bytes / sizeof(T) lanes of T, in one register if Bytes is its size
+        template< typename T, size_t Bytes >
+        struct lanes_of {
+            typedef T type __attribute__((vector_size(Bytes)));
+        };
+
+        template< typename T, size_t Bytes >
+        using lanes = typename lanes_of<T, Bytes>::type;
+
+        // Vectors are passed by reference - by value, outside a target
+        // function, they would have a different ABI from inside one.
+        template< typename Vector, typename T >
+        __attribute__((always_inline)) inline void load(Vector& v, const T* address) {
+            std::memcpy(&v, address, sizeof(Vector));   // unaligned
+        }
+
+        template< typename Vector, typename T >
+        __attribute__((always_inline)) inline void splat(Vector& v, T value) {
+            for (size_t i = 0; i < sizeof(Vector) / sizeof(T); ++i) {
+                v[i] = value;
+            }
+        }
+
+        // True if any lane of a comparison result is set - one PTEST.  These
+        // are not always_inline, as a kernel is not compiled for AVX until it
+        // is inlined into run_avx2, and then they are inlined in turn.
+        template< typename Mask >
+        __attribute__((target("avx2"))) inline bool any(const Mask& mask, std::integral_constant<size_t, 32>) {
+            __m256i bits;
+            std::memcpy(&bits, &mask, sizeof bits);
+            return !_mm256_testz_si256(bits, bits);
+        }
+
+        template< typename Mask >
+        __attribute__((target("sse4.2"))) inline bool any(const Mask& mask, std::integral_constant<size_t, 16>) {
+            __m128i bits;
+            std::memcpy(&bits, &mask, sizeof bits);
+            return !_mm_testz_si128(bits, bits);
+        }
+
+        template< typename Mask >
+        __attribute__((always_inline)) inline bool any(const Mask& mask) {
+            return any(mask, std::integral_constant<size_t, sizeof(Mask)>());
+        }
+
+        // Four registers at a time with a single branch, then the standard
+        // algorithm over what is left - from the block holding the match, if
+        // there is one.
+        template< size_t Bytes, typename T >
+        inline const T* find_kernel::run(const T* first, const T* last, T value) {
+            constexpr size_t n = Bytes / sizeof(T);
+            using V = lanes<T, Bytes>;
+            V needle, a, b, c, d;
+            splat(needle, value);
+            for (; static_cast<size_t>(last - first) >= 4 * n; first += 4 * n) {
+                load(a, first);
+                load(b, first + n);
+                load(c, first + 2 * n);
+                load(d, first + 3 * n);
+                if (any((a == needle) | (b == needle) | (c == needle) | (d == needle))) {
+                    break;
+                }
+            }
+            return std::find(first, last, value);
+        }
+
+        // A comparison sets a lane to -1, so subtracting the masks counts the
+        // matches in every lane.  Lanes are as wide as T, so counts are
+        // collected before a lane could overflow.
+        template< size_t Bytes, typename T >
+        inline size_t count_kernel::run(const T* first, const T* last, T value) {
+            constexpr size_t n = Bytes / sizeof(T);
+            constexpr size_t most_steps = size_t(1) << 30;
+            using V = lanes<T, Bytes>;
+            using Mask = decltype(V() == V());
+            V needle, a;
+            splat(needle, value);
+            size_t total = 0;
+            while (static_cast<size_t>(last - first) >= n) {
+                size_t steps = std::min(static_cast<size_t>(last - first) / n, most_steps);
+                Mask counts = Mask();
+                for (size_t step = 0; step < steps; ++step, first += n) {
+                    load(a, first);
+                    counts -= a == needle;
+                }
+                for (size_t i = 0; i < n; ++i) {
+                    total += static_cast<size_t>(counts[i]);
+                }
+            }
+            return total + static_cast<size_t>(std::count(first, last, value));
+        }
+
+        // [first, last) must not be empty.  Four registers of candidates, as
+        // for sum, all starting from the first n elements.
+        template< bool Max >
+        template< size_t Bytes, typename T >
+        inline T extreme_kernel<Max>::run(const T* first, const T* last) {
+            constexpr size_t n = Bytes / sizeof(T);
+            using V = lanes<T, Bytes>;
+            if (static_cast<size_t>(last - first) < n) {
+                return scalar(first, last);
+            }
+            V a, b0, b1, b2, b3;
+            auto keep = [&](V& best, const T* address) __attribute__((always_inline)) {
+                load(a, address);
+                best = (Max ? best < a : a < best) ? a : best;
+            };
+            load(b0, first);
+            b1 = b2 = b3 = b0;
+            for (first += n; static_cast<size_t>(last - first) >= 4 * n; first += 4 * n) {
+                keep(b0, first);
+                keep(b1, first + n);
+                keep(b2, first + 2 * n);
+                keep(b3, first + 3 * n);
+            }
+            for (; static_cast<size_t>(last - first) >= n; first += n) {
+                keep(b0, first);
+            }
+            auto better = [](T x, T y) { return (Max ? x < y : y < x) ? y : x; };
+            T result = b0[0];
+            for (size_t i = 0; i < n; ++i) {
+                result = better(better(result, b0[i]), better(b1[i], better(b2[i], b3[i])));
+            }
+            for (; first != last; ++first) {
+                result = better(result, *first);
+            }
+            return result;
+        }
+
+        // Four accumulators, so successive adds need not wait for each other.
+        // Integers are widened to 64 bit lanes - so a register of sums takes
+        // half a register of 4 byte ints - and added unsigned so that overflow
+        // wraps.
+        template< size_t Bytes, typename T >
+        inline sum_type<T> sum_kernel::run(const T* first, const T* last) {
+            using Total = std::conditional_t<std::is_floating_point<T>::value, T, unsigned long long>;
+            constexpr size_t n = Bytes / sizeof(Total);
+            using Part = lanes<T, n * sizeof(T)>;
+            using Wide = lanes<sum_type<T>, Bytes>;
+            using Sums = lanes<Total, Bytes>;
+            Part part;
+            auto add = [&](Sums& sum, const T* address) __attribute__((always_inline)) {
+                load(part, address);
+                sum += (Sums)__builtin_convertvector(part, Wide);
+            };
+            Sums s0 = Sums(), s1 = Sums(), s2 = Sums(), s3 = Sums();
+            for (; static_cast<size_t>(last - first) >= 4 * n; first += 4 * n) {
+                add(s0, first);
+                add(s1, first + n);
+                add(s2, first + 2 * n);
+                add(s3, first + 3 * n);
+            }
+            for (; static_cast<size_t>(last - first) >= n; first += n) {
+                add(s0, first);
+            }
+            Sums all = (s0 + s1) + (s2 + s3);
+            Total total = Total();
+            for (size_t i = 0; i < n; ++i) {
+                total += all[i];
+            }
+            for (; first != last; ++first) {
+                total += static_cast<Total>(static_cast<sum_type<T>>(*first));
+            }
+            return static_cast<sum_type<T>>(total);
+        }
+
+        // Integers are equal if their bytes are, and std::equal already hands
+        // them to memcmp, which the C library vectorises - so only floating
+        // point, where -0 == 0 and NaN != NaN, needs a kernel.
+        template< size_t Bytes, typename T >
+        inline bool equal_kernel::run(const T* first, const T* last, const T* other) {
+            if constexpr (std::is_integral<T>::value) {
+                return std::equal(first, last, other);
+            }
+            constexpr size_t n = Bytes / sizeof(T);
+            using V = lanes<T, Bytes>;
+            V a0, a1, a2, a3, b0, b1, b2, b3;
+            for (; static_cast<size_t>(last - first) >= 4 * n; first += 4 * n, other += 4 * n) {
+                load(a0, first);
+                load(a1, first + n);
+                load(a2, first + 2 * n);
+                load(a3, first + 3 * n);
+                load(b0, other);
+                load(b1, other + n);
+                load(b2, other + 2 * n);
+                load(b3, other + 3 * n);
+                if (any((a0 != b0) | (a1 != b1) | (a2 != b2) | (a3 != b3))) {
+                    return false;
+                }
+            }
+            return std::equal(first, last, other);
+        }
+
+        // the only functions compiled for AVX2 and SSE4.2
+        template< typename Kernel, typename... Args >
+        __attribute__((target("avx2"))) auto run_avx2(Args... args) {
+            return Kernel::template run<32>(args...);
+        }
+
+        template< typename Kernel, typename... Args >
+        __attribute__((target("sse4.2"))) auto run_sse4(Args... args) {
+            return Kernel::template run<16>(args...);
+        }
+#endif
+
+        template< typename Kernel, typename T, typename... Args >
+        auto dispatch(Args... args) {
+            if constexpr (vectorised<T>) {
+#ifdef WHEEL_SIMD_X86
+                switch (chosen().load(std::memory_order_relaxed)) {
+                case level::avx2:
+                    return run_avx2<Kernel>(args...);
+                case level::sse4:
+                    return run_sse4<Kernel>(args...);
+                case level::scalar:
+                    break;
+                }
+#endif
+            }
+            return Kernel::scalar(args...);
+        }
+
+    }  // namespace detail
+
+    // the best level the cpu supports
+    inline level detected_level() {
+        static const level detected = detail::detect();
+        return detected;
+    }
+
+    // the level the kernels run at - detected_level() unless changed by use_level
+    inline level active_level() {
+        return detail::chosen().load(std::memory_order_relaxed);
+    }
+
+    // Runs the kernels at wanted, or at the detected level if that is lower -
+    // for tests and benchmarks.  Returns the level now in use.
+    inline level use_level(level wanted) {
+        level in_use = std::min(wanted, detected_level());
+        detail::chosen().store(in_use, std::memory_order_relaxed);
+        return in_use;
+    }
+
+    // the first element equal to value, or last
+    template< typename T >
+    const T* find(const T* first, const T* last, typename detail::same<T>::type value) {
+        return detail::dispatch<detail::find_kernel, T>(first, last, value);
+    }
+
+    template< typename T >
+    size_t count(const T* first, const T* last, typename detail::same<T>::type value) {
+        return detail::dispatch<detail::count_kernel, T>(first, last, value);
+    }
+
+    // the smallest element - [first, last) must not be empty
+    template< typename T >
+    T min(const T* first, const T* last) {
+        return detail::dispatch<detail::extreme_kernel<false>, T>(first, last);
+    }
+
+    // the largest element - [first, last) must not be empty
+    template< typename T >
+    T max(const T* first, const T* last) {
+        return detail::dispatch<detail::extreme_kernel<true>, T>(first, last);
+    }
+
+    template< typename T >
+    sum_type<T> sum(const T* first, const T* last) {
+        return detail::dispatch<detail::sum_kernel, T>(first, last);
+    }
+
+    // true if [first, last) equals the range of the same length at other
+    template< typename T >
+    bool equal(const T* first, const T* last, const T* other) {
+        return detail::dispatch<detail::equal_kernel, T>(first, last, other);
+    }
+
+    // the same over a whole wheel::vector
+    template< typename T, typename Allocator, typename Growth >
+    const T* find(const vector<T, Allocator, Growth>& v, typename detail::same<T>::type value) {
+        return simd::find(v.begin(), v.end(), value);
+    }
+
+    template< typename T, typename Allocator, typename Growth >
+    size_t count(const vector<T, Allocator, Growth>& v, typename detail::same<T>::type value) {
+        return simd::count(v.begin(), v.end(), value);
+    }
+
+    template< typename T, typename Allocator, typename Growth >
+    T min(const vector<T, Allocator, Growth>& v) {
+        return simd::min(v.begin(), v.end());
+    }
+
+    template< typename T, typename Allocator, typename Growth >
+    T max(const vector<T, Allocator, Growth>& v) {
+        return simd::max(v.begin(), v.end());
+    }
+
+    template< typename T, typename Allocator, typename Growth >
+    sum_type<T> sum(const vector<T, Allocator, Growth>& v) {
+        return simd::sum(v.begin(), v.end());
+    }
+
+    // equal sizes and equal elements
+    template< typename T, typename A1, typename G1, typename A2, typename G2 >
+    bool equal(const vector<T, A1, G1>& a, const vector<T, A2, G2>& b) {
+        return a.size() == b.size() && simd::equal(a.begin(), a.end(), b.begin());
+    }
+
+}  // namespace simd
+}  // namespace wheel
+
+#endif // SIMD_HPP_
@@ -0,0 +1,262 @@
+/* example, the keys 1 to 10 in Eytzinger order:
+
+    index   1   2   3   4   5   6   7   8   9  10
+    key     7   4   9   2   6   8  10   1   3   5
+
+                      7
+                /           \
+              4               9
+           /     \          /   \
+          2       6        8     10
+         / \     /
+        1   3   5
+
+A read-only set of keys laid out for searching.  A binary search of a big
+sorted array misses the cache at almost every step, and each miss has to
+finish before the next address is known.  Here the keys are stored as a
+complete binary search tree in breadth first order - the Eytzinger layout -
+so node k's children are 2k and 2k + 1, with no pointers.  That helps in
+two ways:
+1. the first few levels, which every search passes through, are packed
+   together at the front, so they stay in the cache
+2. the 16 (for 4 byte keys) descendants of node k four levels down are
+   the adjacent nodes 16k to 16k + 15 - one cache line, if the array is
+   aligned - so a search prefetches it four steps ahead and, on a big
+   array, runs four memory fetches at once rather than one
+The search itself is branch free - each step goes to 2k + (key of k < key)
+- and ends when k runs off the tree; the last left turn taken, found by
+dropping the trailing right turns from k, is the answer.
+
+find_many() runs a group of searches in lockstep, a level at a time, so
+there are many independent misses in flight at once even without
+prefetching.
+
+The keys need not be sorted or unique.  Duplicates stay, and lower_bound
+finds the first of them.
+
+Operation       Speed
+static_index    O(n log n)  // sorts the keys, O(n) if already sorted
+contains        O(log n)
+lower_bound     O(log n)
+find_many       O(m log n)  // for m queries
+*/
+
+#ifndef STATIC_INDEX_HPP_
+#define STATIC_INDEX_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include "prefetch.hpp"
+#include "rb_tree.hpp"   // compare_holder
+#include "vector.hpp"
+
+namespace wheel {  // as in re-inventing the wheel
+
+    template< typename Key, typename Compare = std::less<Key>, typename Allocator = std::allocator<Key> >
+    class static_index : private compare_holder<Compare> {
+    public:
+
+        using key_type = Key;
+        using key_compare = Compare;
+        using allocator_type = Allocator;
+
+        // O(n log n) - takes the keys by value, so pass them with std::move if
+        // they are not needed afterwards.  The layout is built in a new array
+        // from the same allocator.
+        explicit static_index(vector<Key, Allocator> keys, const Compare& comp = Compare())
+            : compare_holder<Compare>(comp), keys_(std::move(keys)) {
+            size_ = keys_.size();
+            if (size_ == 0) {
+                return;
+            }
+            std::sort(keys_.begin(), keys_.end(), this->comp());
+            // slack to align the tree, and slot 0, which is not used.  Both
+            // are filled with copies of a key, as vector holds only built values.
+            vector<Key, Allocator> layout(size_ + keys_per_line, keys_[0], keys_.get_allocator());
+            offset_ = aligning_offset(layout.begin());
+            Key* tree = layout.begin() + offset_;
+            size_t next = 0;
+            fill(tree, 1, next);
+            keys_ = std::move(layout);
+            for (size_t levels = size_ + 1; levels > 1; levels /= 2) {
+                ++full_levels_;
+            }
+        }
+
+        static_index(const static_index&) = delete;
+        static_index& operator=(const static_index&) = delete;
+
+        // O(1) - the array stays where it is, so it stays aligned.  other is
+        // left empty.
+        static_index(static_index&& other) noexcept
+            : compare_holder<Compare>(other.comp()), keys_(std::move(other.keys_)),
+              offset_(std::exchange(other.offset_, 0)), size_(std::exchange(other.size_, 0)),
+              full_levels_(std::exchange(other.full_levels_, 0)) {}
+
+        static_index& operator=(static_index&& other) noexcept {
+            static_cast<compare_holder<Compare>&>(*this) = other;
+            keys_ = std::move(other.keys_);
+            offset_ = std::exchange(other.offset_, 0);
+            size_ = std::exchange(other.size_, 0);
+            full_levels_ = std::exchange(other.full_levels_, 0);
+            return *this;
+        }
+
+        // O(log n)
+        bool contains(const Key& key) const {
+            return found(search(key), key) != nullptr;
+        }
+
+        template< typename K, typename C = Compare, typename = typename C::is_transparent >
+        bool contains(const K& key) const {
+            return found(search(key), key) != nullptr;
+        }
+
+        // O(log n) - the first key not less than key, or null if every key is
+        // less
+        const Key* lower_bound(const Key& key) const {
+            return at(search(key));
+        }
+
+        template< typename K, typename C = Compare, typename = typename C::is_transparent >
+        const Key* lower_bound(const K& key) const {
+            return at(search(key));
+        }
+
+        // O(m log n) - for each query in [first, last), writes to out a pointer
+        // to the equal key, or null if there is none.  Queries are taken in
+        // groups that go down the tree together, level by level.
+        template< typename RandomIterator, typename OutputIterator >
+        OutputIterator find_many(RandomIterator first, RandomIterator last, OutputIterator out) const {
+            const Key* tree = keys_.begin() + offset_;
+            size_t k[group];
+            while (first != last) {
+                size_t count = std::min<size_t>(group, static_cast<size_t>(last - first));
+                for (size_t i = 0; i < count; ++i) {
+                    k[i] = 1;
+                }
+                for (size_t level = 0; level < full_levels_; ++level) {
+                    for (size_t i = 0; i < count; ++i) {
+                        prefetch_descendants(tree, k[i]);
+                        k[i] = 2 * k[i] + comp()(tree[k[i]], first[i]);
+                    }
+                }
+                for (size_t i = 0; i < count; ++i) {
+                    *out++ = found(last_left_turn(last_level(tree, k[i], first[i])), first[i]);
+                }
+                first += count;
+            }
+            return out;
+        }
+
+        size_t size() const {
+            return size_;
+        }
+
+        bool empty() const {
+            return size_ == 0;
+        }
+
+        key_compare key_comp() const {
+            return comp();
+        }
+
+        allocator_type get_allocator() const {
+            return keys_.get_allocator();
+        }
+
+    private:
+        using compare_holder<Compare>::comp;
+
+        // the keys in one cache line - the descendants log2 of that many levels
+        // down are side by side.  Keys that don't divide a line are not aligned.
+        static constexpr size_t keys_per_line = cache_line_bytes % sizeof(Key) == 0 ? cache_line_bytes / sizeof(Key) : 1;
+        static constexpr size_t group = 16;
+
+        // skips the keys needed to put tree index 0 at the start of a line,
+        // so every block of descendants 16k to 16k + 15 (for 4 byte keys) is
+        // exactly one line
+        static size_t aligning_offset(const Key* array) {
+            size_t misalignment = reinterpret_cast<std::uintptr_t>(array) % cache_line_bytes;
+            size_t gap = (cache_line_bytes - misalignment) % cache_line_bytes;
+            return gap % sizeof(Key) == 0 && gap / sizeof(Key) < keys_per_line ? gap / sizeof(Key) : 0;
+        }
+
+        // in order over the implicit tree rooted at k, so the sorted keys go in
+        // in order - recursion depth is log2(n)
+        void fill(Key* tree, size_t k, size_t& next) {
+            if (k > size_) {
+                return;
+            }
+            fill(tree, 2 * k, next);
+            tree[k] = std::move(keys_[next++]);
+            fill(tree, 2 * k + 1, next);
+        }
+
+        // the tree index reached by walking down from the root - every step
+        // goes right if the node's key is less than key, left otherwise
+        template< typename K >
+        size_t search(const K& key) const {
+            const Key* tree = keys_.begin() + offset_;
+            size_t k = 1;
+            for (size_t level = 0; level < full_levels_; ++level) {
+                prefetch_descendants(tree, k);
+                k = 2 * k + comp()(tree[k], key);
+            }
+            return last_left_turn(last_level(tree, k, key));
+        }
+
+        // every level but the last is full, the last needs a bounds check
+        template< typename K >
+        size_t last_level(const Key* tree, size_t k, const K& key) const {
+            if (k <= size_) {
+                k = 2 * k + comp()(tree[k], key);
+            }
+            return k;
+        }
+
+        // the walk ends past a leaf.  The answer is the node where it last went
+        // left - strip the right turns, the trailing 1 bits, and that left turn.
+        // 0 means it never went left, every key is less.
+        static size_t last_left_turn(size_t k) {
+#if defined(__GNUC__) || defined(__clang__)
+            return k >> (__builtin_ctzll(~static_cast<unsigned long long>(k)) + 1);
+#else
+            while (k & 1) {
+                k >>= 1;
+            }
+            return k >> 1;
+#endif
+        }
+
+        static void prefetch_descendants(const Key* tree, size_t k) {
+            prefetch(reinterpret_cast<std::uintptr_t>(tree) + k * keys_per_line * sizeof(Key));
+        }
+
+        const Key* at(size_t k) const {
+            return k == 0 ? nullptr : keys_.begin() + offset_ + k;
+        }
+
+        // the lower bound at k, if its key is equivalent to key
+        template< typename K >
+        const Key* found(size_t k, const K& key) const {
+            const Key* candidate = at(k);
+            return candidate != nullptr && !comp()(key, *candidate) ? candidate : nullptr;
+        }
+
+
+        vector<Key, Allocator> keys_;   // the tree, from offset_ + 1
+        size_t offset_ = 0;
+        size_t size_ = 0;
+        size_t full_levels_ = 0;        // levels with every slot in use
+    };
+
+}  // namespace wheel
+
+#endif // STATIC_INDEX_HPP_
@@ -0,0 +1,483 @@
+/*
+A fixed set of worker threads, the executor behind the wheel parallel
+algorithms - and anything else that wants to run tasks on every core.
+
+Each worker owns a Chase-Lev deque of tasks (Chase and Lev, "Dynamic
+circular work-stealing deque", 2005, with the C11 memory orders of Le, Pop,
+Cohen and Zappa Nardelli, 2013).  The owner pushes and pops at the bottom
+without a lock - the newest task, the one most likely still in its cache.
+An idle worker steals from the top of someone else's deque, the oldest and
+so usually the biggest piece of work left, with one compare and swap.
+Tasks submitted by threads outside the pool wait in a shared, locked queue
+until a worker takes them.  Workers with nothing to do sleep.
+
+parallel_for splits its range lazily (Tzannes et al, "Lazy binary
+splitting", 2010): a worker runs grain indexes at a time, and only when its
+own deque is empty - when other workers have stolen everything it offered -
+does it push half of what is left for them.  So a range is cut into as few
+pieces as keeps every worker busy, however uneven the work, with grain only
+a lower bound.  The thread calling it joins in if it is one of the workers,
+so parallel_for nests; any other thread sleeps until the range is done.
+
+submit returns a std::future.  A task must not block waiting for a future
+of a task that is queued behind it - use parallel_for to wait for work
+from inside the pool.
+
+Operation       Speed
+thread_pool(n)  O(n)  // starts n threads
+submit          O(1)  // amortized - a deque doubles when full
+parallel_for    O(n / threads + log n)  // plus O(log n) splits per steal
+shared          O(1)  // one pool for the program, started at the first call
+*/
+
+#ifndef THREAD_POOL_HPP_
+#define THREAD_POOL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace wheel {  // as in re-inventing the wheel
+
+    namespace detail {
+
+        // something to run, once, then delete
+        struct pool_task {
+            virtual ~pool_task() = default;
+            virtual void run() = 0;
+        };
+
+        template< typename Function >
+        struct function_task : pool_task {
+            explicit function_task(Function f) : f_(std::move(f)) {}
+            void run() override { f_(); }
+            Function f_;
+        };
+
+        template< typename Function >
+        pool_task* make_task(Function f) {
+            return new function_task<Function>(std::move(f));
+        }
+
+        // The deque of one worker.  Only the owner calls push and pop, anyone
+        // may call steal.  The ring is a power of two slots, indexed by
+        // position modulo its size; top and bottom only ever grow, apart from
+        // pop's brief decrement of bottom.  A full ring is copied into one
+        // twice the size, and the old one kept until the deque goes - a thief
+        // may still be reading it.
+        class work_deque {
+        public:
+            work_deque() : ring_(new ring(64, nullptr)) {}
+
+            work_deque(const work_deque&) = delete;
+            work_deque& operator=(const work_deque&) = delete;
+
+            ~work_deque() {
+                ring* r = ring_.load(std::memory_order_relaxed);
+                while (r) {
+                    ring* older = r->older;
+                    delete r;
+                    r = older;
+                }
+            }
+
+            void push(pool_task* t) {
+                std::int64_t b = bottom_.load(std::memory_order_relaxed);
+                std::int64_t tp = top_.load(std::memory_order_acquire);
+                ring* r = ring_.load(std::memory_order_relaxed);
+                if (b - tp >= static_cast<std::int64_t>(r->size)) {
+                    r = grow(r, tp, b);
+                }
+                r->at(b).store(t, std::memory_order_relaxed);
+                bottom_.store(b + 1, std::memory_order_release);
+            }
+
+            // the newest task, or nullptr
+            pool_task* pop() {
+                std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+                ring* r = ring_.load(std::memory_order_relaxed);
+                // seq_cst, so a thief either sees the smaller bottom or we
+                // see its larger top - both cannot take the last task
+                bottom_.store(b, std::memory_order_seq_cst);
+                std::int64_t tp = top_.load(std::memory_order_seq_cst);
+                if (tp > b) {
+                    bottom_.store(b + 1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+                pool_task* t = r->at(b).load(std::memory_order_relaxed);
+                if (tp == b) {
+                    // the last task - race any thief for it
+                    if (!top_.compare_exchange_strong(tp, tp + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                        t = nullptr;
+                    }
+                    bottom_.store(b + 1, std::memory_order_relaxed);
+                }
+                return t;
+            }
+
+            // the oldest task, or nullptr if there is none or another thread
+            // got it first
+            pool_task* steal() {
+                std::int64_t tp = top_.load(std::memory_order_seq_cst);
+                std::int64_t b = bottom_.load(std::memory_order_seq_cst);
+                if (tp >= b) {
+                    return nullptr;
+                }
+                ring* r = ring_.load(std::memory_order_acquire);
+                pool_task* t = r->at(tp).load(std::memory_order_relaxed);
+                if (!top_.compare_exchange_strong(tp, tp + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    return nullptr;
+                }
+                return t;
+            }
+
+            // only a guide - it may be out of date by the time it returns
+            bool empty() const {
+                return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+            }
+
+        private:
+            struct ring {
+                ring(size_t slots, ring* previous)
+                    : size(slots), tasks(new std::atomic<pool_task*>[slots]), older(previous) {}
+
+                std::atomic<pool_task*>& at(std::int64_t position) {
+                    return tasks[static_cast<size_t>(position) & (size - 1)];
+                }
+
+                size_t size;
+                std::unique_ptr<std::atomic<pool_task*>[]> tasks;
+                ring* older;
+            };
+
+            ring* grow(ring* r, std::int64_t tp, std::int64_t b) {
+                ring* bigger = new ring(r->size * 2, r);
+                for (std::int64_t i = tp; i != b; ++i) {
+                    bigger->at(i).store(r->at(i).load(std::memory_order_relaxed), std::memory_order_relaxed);
+                }
+                ring_.store(bigger, std::memory_order_release);
+                return bigger;
+            }
+
+            // apart, so the owner's bottom and the thieves' top do not share a
+            // cache line
+            alignas(64) std::atomic<std::int64_t> top_{ 0 };
+            alignas(64) std::atomic<std::int64_t> bottom_{ 0 };
+            std::atomic<ring*> ring_;
+        };
+
+    }  // namespace detail
+
+    class thread_pool {
+    public:
+        explicit thread_pool(size_t threads = default_threads()) {
+            threads = std::max<size_t>(threads, 1);
+            workers_.reserve(threads);
+            for (size_t i = 0; i < threads; ++i) {
+                workers_.push_back(std::make_unique<worker>());
+            }
+            for (size_t i = 0; i < threads; ++i) {
+                workers_[i]->thread = std::thread([this, i] { work(i); });
+            }
+        }
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        // runs the tasks already submitted, then stops the workers
+        ~thread_pool() {
+            {
+                std::lock_guard<std::mutex> lock(sleep_lock_);
+                stopping_ = true;
+            }
+            wake_.notify_all();
+            for (auto& w : workers_) {
+                w->thread.join();
+            }
+        }
+
+        // the number of worker threads
+        size_t size() const {
+            return workers_.size();
+        }
+
+        static size_t default_threads() {
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        // the pool the parallel algorithms use unless given another
+        static thread_pool& shared() {
+            static thread_pool pool;
+            return pool;
+        }
+
+        // Runs f(args...) on a worker.  The arguments are copied or moved in,
+        // like std::thread's, and the future delivers f's result or exception.
+        template< typename Function, typename... Args >
+        auto submit(Function&& f, Args&&... args)
+            -> std::future<std::invoke_result_t<std::decay_t<Function>, std::decay_t<Args>...>> {
+            using result = std::invoke_result_t<std::decay_t<Function>, std::decay_t<Args>...>;
+            std::packaged_task<result()> job(
+                [f = std::forward<Function>(f), arguments = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                    return std::apply(std::move(f), std::move(arguments));
+                });
+            std::future<result> done = job.get_future();
+            schedule(detail::make_task(std::move(job)));
+            return done;
+        }
+
+        // Calls body(begin, end) for consecutive pieces of [first, last),
+        // together covering it once, and returns when every call has.  Pieces
+        // are at most grain long - 0 picks a grain that gives each worker a
+        // few dozen pieces.  If a call throws, the pieces of its range not yet
+        // started are skipped, and the first exception is rethrown here once
+        // the pieces already running have finished.
+        template< typename Body >
+        void parallel_for(size_t first, size_t last, Body body, size_t grain = 0) {
+            if (first >= last) {
+                return;
+            }
+            if (grain == 0) {
+                grain = std::max<size_t>(1, (last - first) / (size() * 32));
+            }
+            if (last - first <= grain) {
+                body(first, last);
+                return;
+            }
+
+            group pending;
+            size_t self = current_worker();
+            if (self == npos) {
+                schedule(detail::make_task([this, &body, &pending, first, last, grain] {
+                    run_range(body, pending, first, last, grain);
+                }));
+            }
+            else {
+                run_range(body, pending, first, last, grain);
+                // what was split off may still be in our own deque
+                while (!pending.done()) {
+                    if (!run_one(self)) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+            pending.wait();
+            pending.rethrow();
+        }
+
+    private:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        struct worker {
+            detail::work_deque tasks;
+            std::thread thread;
+            std::uint32_t victim_seed = 0;  // where to start looking for work to steal
+        };
+
+        // the pieces of one parallel_for, counted up as a range is split and
+        // down as each piece finishes
+        class group {
+        public:
+            void add() {
+                remaining_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void fail(std::exception_ptr error) {
+                std::lock_guard<std::mutex> lock(lock_);
+                if (!error_) {
+                    error_ = error;
+                }
+            }
+
+            // under the lock, so wait() cannot return, and the group go away,
+            // before the last piece has finished with it
+            void finish() {
+                std::lock_guard<std::mutex> lock(lock_);
+                if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    finished_.notify_all();
+                }
+            }
+
+            bool done() const {
+                return remaining_.load(std::memory_order_acquire) == 0;
+            }
+
+            void wait() {
+                std::unique_lock<std::mutex> lock(lock_);
+                finished_.wait(lock, [this] { return done(); });
+            }
+
+            void rethrow() {
+                if (error_) {
+                    std::rethrow_exception(error_);
+                }
+            }
+
+        private:
+            std::atomic<size_t> remaining_{ 1 };
+            std::mutex lock_;
+            std::condition_variable finished_;
+            std::exception_ptr error_;
+        };
+
+        // grain indexes at a time, giving away half of what is left whenever
+        // our deque is empty and so someone may be looking for work
+        template< typename Body >
+        void run_range(Body& body, group& pending, size_t begin, size_t end, size_t grain) {
+            size_t self = current_worker();
+            try {
+                while (begin < end) {
+                    if (end - begin > grain && workers_[self]->tasks.empty()) {
+                        size_t middle = begin + (end - begin) / 2;
+                        pending.add();
+                        push(self, detail::make_task([this, &body, &pending, middle, end, grain] {
+                            run_range(body, pending, middle, end, grain);
+                        }));
+                        end = middle;
+                    }
+                    else {
+                        size_t stop = std::min(end, begin + grain);
+                        body(begin, stop);
+                        begin = stop;
+                    }
+                }
+            }
+            catch (...) {
+                pending.fail(std::current_exception());
+            }
+            pending.finish();
+        }
+
+        // which of our workers the calling thread is, or npos
+        size_t current_worker() const {
+            return current().pool == this ? current().index : npos;
+        }
+
+        struct identity {
+            const thread_pool* pool = nullptr;
+            size_t index = npos;
+        };
+
+        static identity& current() {
+            static thread_local identity me;
+            return me;
+        }
+
+        // onto our own deque if we are a worker, otherwise the shared queue
+        void schedule(detail::pool_task* t) {
+            size_t self = current_worker();
+            if (self != npos) {
+                push(self, t);
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(injected_lock_);
+                injected_.push_back(t);
+            }
+            announce();
+        }
+
+        void push(size_t self, detail::pool_task* t) {
+            workers_[self]->tasks.push(t);
+            announce();
+        }
+
+        // Counts a new task and wakes a sleeper if there is one.  A worker
+        // going to sleep counts itself in sleepers_ before it checks queued_,
+        // and we count the task before we check sleepers_, so at least one of
+        // us sees the other.
+        void announce() {
+            queued_.fetch_add(1, std::memory_order_seq_cst);
+            if (sleepers_.load(std::memory_order_seq_cst) != 0) {
+                { std::lock_guard<std::mutex> lock(sleep_lock_); }
+                wake_.notify_one();
+            }
+        }
+
+        // our newest task, else the oldest submitted from outside, else the
+        // oldest of some other worker's
+        detail::pool_task* find_task(size_t self) {
+            worker& me = *workers_[self];
+            if (detail::pool_task* t = me.tasks.pop()) {
+                return t;
+            }
+            if (queued_.load(std::memory_order_relaxed) == 0) {
+                return nullptr;
+            }
+            {
+                std::lock_guard<std::mutex> lock(injected_lock_);
+                if (!injected_.empty()) {
+                    detail::pool_task* t = injected_.front();
+                    injected_.pop_front();
+                    return t;
+                }
+            }
+            // xorshift, so workers do not all pile onto the same victim
+            me.victim_seed ^= me.victim_seed << 13;
+            me.victim_seed ^= me.victim_seed >> 17;
+            me.victim_seed ^= me.victim_seed << 5;
+            size_t start = me.victim_seed % workers_.size();
+            for (size_t i = 0; i < workers_.size(); ++i) {
+                size_t victim = (start + i) % workers_.size();
+                if (victim != self) {
+                    if (detail::pool_task* t = workers_[victim]->tasks.steal()) {
+                        return t;
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        bool run_one(size_t self) {
+            detail::pool_task* t = find_task(self);
+            if (t == nullptr) {
+                return false;
+            }
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            std::unique_ptr<detail::pool_task> owned(t);
+            owned->run();
+            return true;
+        }
+
+        void work(size_t self) {
+            current() = identity{ this, self };
+            workers_[self]->victim_seed = static_cast<std::uint32_t>(self * 2654435761u + 1);
+            for (;;) {
+                if (run_one(self)) {
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(sleep_lock_);
+                sleepers_.fetch_add(1, std::memory_order_seq_cst);
+                wake_.wait(lock, [this] { return stopping_ || queued_.load(std::memory_order_seq_cst) > 0; });
+                sleepers_.fetch_sub(1, std::memory_order_relaxed);
+                if (stopping_ && queued_.load(std::memory_order_acquire) == 0) {
+                    return;
+                }
+            }
+        }
+
+        std::vector<std::unique_ptr<worker>> workers_;
+        std::mutex injected_lock_;
+        std::deque<detail::pool_task*> injected_;  // submitted from outside the pool
+        std::atomic<size_t> queued_{ 0 };          // tasks waiting anywhere
+        std::atomic<size_t> sleepers_{ 0 };
+        std::mutex sleep_lock_;
+        std::condition_variable wake_;
+        bool stopping_ = false;
+    };
+
+}  // namespace wheel
+
+#endif // THREAD_POOL_HPP_
@@ -0,0 +1,695 @@
+#ifndef UNROLLED_LIST_HPP_
+#define UNROLLED_LIST_HPP_
+
+/* example, N = 4:
+
+    [ 1 2 3 . ] <-> [ 4 5 . . ] <-> [ 6 7 8 9 ]
+
+A doubly linked list of chunks, each holding up to N values side by side -
+for lists of small values, where wheel::list spends two pointers (16 bytes)
+on every int and every step of a walk is a load that has to wait for the
+last one.  Here the pointers are paid once per chunk, and a walk reads N
+values along an array before it follows a pointer, so iterating is close to
+iterating a vector.
+
+Each chunk keeps its values packed at the front.  Inserting into a full
+chunk splits it in two halves first, and an erase that leaves a chunk less
+than half full merges it with a neighbour when the two fit in one, or
+borrows a value from it when they don't.  So chunks stay at least half full
+(apart from the ends, and where lists were spliced) and the list stays
+within about twice the size of the values.  Chunks come from a node_pool,
+as list's nodes do.
+
+The default N puts about 256 bytes of values in a chunk, and never fewer
+than 8 values.
+
+Unlike list, values move between chunks: insert and erase invalidate
+iterators to the values in the chunks they touch and end(), and push_front
+and pop_front move the values of the first chunk along.  T's move
+constructor and assignment should not throw.
+
+Operation       Speed
+push_back       O(1)
+push_front      O(N)  // shifts the first chunk along - O(1) as N is fixed
+pop_back        O(1)
+pop_front       O(N)
+insert, erase   O(N)  // at an iterator, shifts within one or two chunks
+remove          O(n)  // compacts as it goes
+splice          O(N)
+begin, ++, --   O(1)
+clear           O(chunks), O(slabs) if T has a trivial destructor
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+#include "node_pool.hpp"
+
+namespace wheel {  // as in re-inventing the wheel
+
+	// values per chunk unless told otherwise - about 256 bytes, at least 8
+	template< typename T >
+	constexpr size_t unrolled_chunk_size() {
+		return sizeof(T) * 8 >= 256 ? 8 : 256 / sizeof(T);
+	}
+
+	template< typename T, size_t N = unrolled_chunk_size<T>(), typename Allocator = std::allocator<T> >
+	class unrolled_list {
+		static_assert(N >= 2, "a chunk must hold at least two values, to be split");
+
+	public:
+
+		using allocator_type = Allocator;
+
+		static constexpr size_t chunk_size = N;
+
+		struct chunk {
+			chunk* next = nullptr;
+			chunk* prior = nullptr;
+			size_t count = 0;
+			alignas(T) unsigned char storage[N * sizeof(T)];
+
+			T* values() noexcept { return reinterpret_cast<T*>(storage); }
+			const T* values() const noexcept { return reinterpret_cast<const T*>(storage); }
+		};
+
+		// A value is a chunk and an index into it.  end() is one past the last
+		// value of the last chunk, so -- from end() works and ++ only moves to
+		// the next chunk when there is one.
+		struct iterator {
+
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+			using pointer = T*;
+			using reference = T&;
+			using iterator_category = std::bidirectional_iterator_tag;
+
+			constexpr iterator() noexcept = default;
+
+			constexpr iterator(chunk* c, size_t i) noexcept : chunk_{ c }, index_{ i } {}
+
+			iterator& operator++() {
+				if (++index_ == chunk_->count && chunk_->next) {
+					chunk_ = chunk_->next;
+					index_ = 0;
+				}
+				return *this;
+			}
+
+			iterator operator++(int) {
+				auto old = *this;
+				++*this;
+				return old;
+			}
+
+			iterator& operator--() {
+				if (index_ == 0) {
+					chunk_ = chunk_->prior;
+					index_ = chunk_->count;
+				}
+				--index_;
+				return *this;
+			}
+
+			iterator operator--(int) {
+				auto old = *this;
+				--*this;
+				return old;
+			}
+
+			T& operator*() const { return chunk_->values()[index_]; }
+			T* operator->() const { return chunk_->values() + index_; }
+
+			bool operator==(const iterator& other) const { return chunk_ == other.chunk_ && index_ == other.index_; }
+			bool operator!=(const iterator& other) const { return !(*this == other); }
+
+			chunk* chunk_ = nullptr;
+			size_t index_ = 0;
+		};
+
+		struct const_iterator {
+
+			using value_type = const T;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const T*;
+			using reference = const T&;
+			using iterator_category = std::bidirectional_iterator_tag;
+
+			constexpr const_iterator() noexcept = default;
+
+			constexpr const_iterator(const chunk* c, size_t i) noexcept : chunk_{ c }, index_{ i } {}
+
+			// Implicit conversion from iterator:
+			constexpr const_iterator(iterator const& it) noexcept : chunk_{ it.chunk_ }, index_{ it.index_ } {}
+
+			const_iterator& operator++() {
+				if (++index_ == chunk_->count && chunk_->next) {
+					chunk_ = chunk_->next;
+					index_ = 0;
+				}
+				return *this;
+			}
+
+			const_iterator operator++(int) {
+				auto old = *this;
+				++*this;
+				return old;
+			}
+
+			const_iterator& operator--() {
+				if (index_ == 0) {
+					chunk_ = chunk_->prior;
+					index_ = chunk_->count;
+				}
+				--index_;
+				return *this;
+			}
+
+			const_iterator operator--(int) {
+				auto old = *this;
+				--*this;
+				return old;
+			}
+
+			const T& operator*() const { return chunk_->values()[index_]; }
+			const T* operator->() const { return chunk_->values() + index_; }
+
+			bool operator==(const const_iterator& other) const { return chunk_ == other.chunk_ && index_ == other.index_; }
+			bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+			chunk const* chunk_ = nullptr;
+			size_t index_ = 0;
+		};
+
+		// O(1)
+		unrolled_list() = default;
+
+		// O(1)
+		explicit unrolled_list(const Allocator& alloc) : pool_(chunk_allocator(alloc)) {}
+
+		// O(n)
+		template <typename InputIterator, typename = typename std::iterator_traits<InputIterator>::iterator_category>
+		unrolled_list(InputIterator first, InputIterator last, const Allocator& alloc = Allocator())
+			: unrolled_list(alloc)
+		{
+			std::for_each(first, last, [this](auto&& item) { emplace_back(std::forward<decltype(item)>(item)); });
+		}
+
+		// O(n)
+		unrolled_list(std::initializer_list<T> init, const Allocator& alloc = Allocator())
+			: unrolled_list(init.begin(), init.end(), alloc) {}
+
+		// O(n) - copy constructor
+		unrolled_list(unrolled_list const& other)
+			: unrolled_list(other, Allocator(chunk_traits::select_on_container_copy_construction(other.pool_.allocator())))
+		{}
+
+		// O(n) - copy constructor using a different allocator
+		unrolled_list(unrolled_list const& other, const Allocator& alloc)
+			: unrolled_list(other.begin(), other.end(), alloc)
+		{}
+
+		// O(n) copy assignment - copy and swap, as for list
+		unrolled_list& operator=(unrolled_list const& other)
+		{
+			if (this != &other) {
+				constexpr bool propagate = chunk_traits::propagate_on_container_copy_assignment::value;
+				unrolled_list copy(other, propagate ? Allocator(other.pool_.allocator()) : Allocator(pool_.allocator()));
+				swap_chunks(copy);
+				if constexpr (propagate) {
+					std::swap(pool_.allocator(), copy.pool_.allocator());
+				}
+			}
+			return *this;
+		}
+
+		// O(1) move assignment - O(n) if the allocators differ and cannot be
+		// propagated, as for list
+		unrolled_list& operator=(unrolled_list&& other) noexcept(chunk_traits::propagate_on_container_move_assignment::value ||
+		                                                         chunk_traits::is_always_equal::value)
+		{
+			if constexpr (chunk_traits::propagate_on_container_move_assignment::value) {
+				clear();
+				pool_.allocator() = std::move(other.pool_.allocator());
+				swap_chunks(other);
+			}
+			else {
+				if (chunk_traits::is_always_equal::value || pool_.allocator() == other.pool_.allocator()) {
+					clear();
+					swap_chunks(other);
+				}
+				else {
+					unrolled_list moved(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()), Allocator(pool_.allocator()));
+					swap_chunks(moved);
+					other.clear();
+				}
+			}
+			return *this;
+		}
+
+		// O(1) move constructor
+		unrolled_list(unrolled_list&& other) noexcept : unrolled_list(Allocator(other.pool_.allocator())) {
+			swap_chunks(other);
+		}
+
+		// O(n)
+		~unrolled_list() {
+			clear();
+		}
+
+		// O(1)
+		friend void swap(unrolled_list& first, unrolled_list& second) // nothrow
+		{
+			if constexpr (chunk_traits::propagate_on_container_swap::value) {
+				std::swap(first.pool_.allocator(), second.pool_.allocator());
+			}
+			first.swap_chunks(second);
+		}
+
+		// O(1)
+		allocator_type get_allocator() const {
+			return Allocator(pool_.allocator());
+		}
+
+		// O(n), O(slabs) if T has a trivial destructor
+		void clear() {
+			if constexpr (!std::is_trivially_destructible<T>::value) {
+				for (chunk* c = head_; c; c = c->next) {
+					destroy_values(c, 0);
+				}
+			}
+			pool_.release();
+			head_ = nullptr;
+			tail_ = nullptr;
+			size_ = 0;
+		}
+
+		// O(1)
+		bool empty() const {
+			return head_ == nullptr;
+		}
+
+		// O(1)
+		size_t size() const {
+			return size_;
+		}
+
+		// O(n)
+		bool operator==(const unrolled_list& other) const {
+			return size_ == other.size_ && std::equal(begin(), end(), other.begin());
+		}
+
+		bool operator!=(const unrolled_list& other) const {
+			return !(*this == other);
+		}
+
+		// O(1)
+		iterator begin() {
+			return iterator(head_, 0);
+		}
+		const_iterator begin() const {
+			return const_iterator(head_, 0);
+		}
+
+		// O(1)
+		iterator end() {
+			return tail_ ? iterator(tail_, tail_->count) : iterator();
+		}
+		const_iterator end() const {
+			return tail_ ? const_iterator(tail_, tail_->count) : const_iterator();
+		}
+
+		// O(1)
+		T& front() { return head_->values()[0]; }
+		const T& front() const { return head_->values()[0]; }
+
+		// O(1)
+		T& back() { return tail_->values()[tail_->count - 1]; }
+		const T& back() const { return tail_->values()[tail_->count - 1]; }
+
+		// O(1)
+		void push_back(const T& value) {
+			emplace_back(value);
+		}
+
+		void push_back(T&& value) {
+			emplace_back(std::move(value));
+		}
+
+		// O(1) - into the last chunk, or a new one if it is full
+		template<typename... Args>
+		void emplace_back(Args&&... args) {
+			if (tail_ && tail_->count < N) {
+				construct(tail_, std::forward<Args>(args)...);
+			}
+			else {
+				add_chunk_before(nullptr, std::forward<Args>(args)...);
+			}
+			++size_;
+		}
+
+		// O(N)
+		void push_front(const T& value) {
+			emplace_front(value);
+		}
+
+		void push_front(T&& value) {
+			emplace_front(std::move(value));
+		}
+
+		// O(N) - the first chunk's values move up one, or a new chunk goes in
+		// front if it is full
+		template<typename... Args>
+		void emplace_front(Args&&... args) {
+			if (head_ && head_->count < N) {
+				place(head_, 0, std::forward<Args>(args)...);
+			}
+			else {
+				add_chunk_before(head_, std::forward<Args>(args)...);
+			}
+			++size_;
+		}
+
+		// O(1)
+		void pop_back() {
+			if (tail_) {
+				destroy_values(tail_, tail_->count - 1);
+				if (tail_->count == 0) {
+					free_chunk(tail_);
+				}
+				--size_;
+			}
+		}
+
+		// O(N)
+		void pop_front() {
+			if (head_) {
+				erase(begin());
+			}
+		}
+
+		// O(N)
+		// pos - iterator before which the content will be inserted. pos may be the end() iterator
+		// returns iterator pointing to the inserted value
+		iterator insert(const_iterator pos, const T& value) {
+			return emplace(pos, value);
+		}
+
+		iterator insert(const_iterator pos, T&& value) {
+			return emplace(pos, std::move(value));
+		}
+
+		// O(N) - a full chunk is split in two first, unless the value can go on
+		// the end of the chunk before
+		template<typename... Args>
+		iterator emplace(const_iterator pos, Args&&... args) {
+			chunk* c = const_cast<chunk*>(pos.chunk_);
+			size_t i = pos.index_;
+			if (c == nullptr || (i == c->count && c->count == N)) {
+				// empty, or the end of a full last chunk
+				add_chunk_before(nullptr, std::forward<Args>(args)...);
+				++size_;
+				return iterator(tail_, 0);
+			}
+			if (c->count == N) {
+				if (i == 0 && c->prior && c->prior->count < N) {
+					c = c->prior;
+					i = c->count;
+				}
+				else {
+					T value(std::forward<Args>(args)...);   // first, args may refer to a value that moves
+					chunk* upper = split(c, N - N / 2);
+					if (i > c->count) {
+						i -= c->count;
+						c = upper;
+					}
+					place(c, i, std::move(value));
+					++size_;
+					return iterator(c, i);
+				}
+			}
+			place(c, i, std::forward<Args>(args)...);
+			++size_;
+			return iterator(c, i);
+		}
+
+		// O(N)
+		// pos must be dereferenceable - ie cannot pass in end
+		// return iterator following the erased element
+		iterator erase(const_iterator pos) {
+			chunk* c = const_cast<chunk*>(pos.chunk_);
+			size_t i = pos.index_;
+			T* values = c->values();
+			std::move(values + i + 1, values + c->count, values + i);
+			destroy_values(c, c->count - 1);
+			--size_;
+
+			if (c->count == 0) {
+				chunk* next = c->next;
+				free_chunk(c);
+				return next ? iterator(next, 0) : end();
+			}
+			if (c->count < N / 2) {
+				// under half full - merge with a neighbour if the two fit in one,
+				// or else borrow a value from it
+				chunk* next = c->next;
+				chunk* prior = c->prior;
+				if (next && c->count + next->count <= N) {
+					relocate(next, 0, c);
+					free_chunk(next);
+				}
+				else if (next) {
+					T* moved = next->values();
+					construct(c, std::move(moved[0]));
+					std::move(moved + 1, moved + next->count, moved);
+					destroy_values(next, next->count - 1);
+				}
+				else if (prior && prior->count + c->count <= N) {
+					i += prior->count;
+					relocate(c, 0, prior);
+					free_chunk(c);
+					c = prior;
+				}
+				else if (prior) {
+					place(c, 0, std::move(prior->values()[prior->count - 1]));
+					destroy_values(prior, prior->count - 1);
+					++i;
+				}
+			}
+			return at(c, i);
+		}
+
+		// O(n) - the values kept are moved up over the ones removed, so the
+		// chunks come out full
+		size_t remove(const T& value) {
+			iterator kept = begin();
+			size_t count{ 0 };
+			for (iterator current = begin(); current != end(); ++current) {
+				if (*current == value) {
+					++count;
+				}
+				else {
+					if (kept != current) {
+						*kept = std::move(*current);
+					}
+					++kept;
+				}
+			}
+			truncate(kept);
+			return count;
+		}
+
+		// O(N)
+		// pos - element before which the content will be inserted. pos may be the end() iterator
+		// the chunk at pos is split there first.  The allocators must compare equal.
+		void splice(const_iterator pos, unrolled_list& other) {
+			if (other.empty()) {
+				return;
+			}
+
+			chunk* after = const_cast<chunk*>(pos.chunk_);
+			if (after && pos.index_ == after->count) {
+				after = nullptr;   // end()
+			}
+			else if (after && pos.index_ > 0) {
+				after = split(after, pos.index_);
+			}
+
+			// other's chunks are now ours, so are the slabs they live in
+			pool_.adopt(other.pool_);
+			link_before(after, other.head_, other.tail_);
+
+			size_ += other.size_;
+			other.size_ = 0;
+			other.head_ = other.tail_ = nullptr;
+		}
+
+		// O(n)
+		void reverse() {
+			chunk* current = head_;
+			while (current) {
+				std::swap(current->next, current->prior);
+				std::reverse(current->values(), current->values() + current->count);
+				current = current->prior;
+			}
+			std::swap(head_, tail_);
+		}
+
+	private:
+		using chunk_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<chunk>;
+		using chunk_traits = std::allocator_traits<chunk_allocator>;
+
+		// canonical iterator to the ith value of c, which may be one past its
+		// last - the first of the next chunk, if there is one
+		iterator at(chunk* c, size_t i) {
+			if (i == c->count && c->next) {
+				return iterator(c->next, 0);
+			}
+			return iterator(c, i);
+		}
+
+		// a value on the end of c, which must have room - through the allocator,
+		// so that a scoped allocator reaches it too
+		template<typename... Args>
+		void construct(chunk* c, Args&&... args) {
+			chunk_traits::construct(pool_.allocator(), c->values() + c->count, std::forward<Args>(args)...);
+			++c->count;
+		}
+
+		// a value at i in c, which must have room, moving those from i up one
+		template<typename... Args>
+		void place(chunk* c, size_t i, Args&&... args) {
+			if (i == c->count) {
+				construct(c, std::forward<Args>(args)...);
+				return;
+			}
+			T value(std::forward<Args>(args)...);   // first, args may refer to a value in c
+			T* values = c->values();
+			construct(c, std::move(values[c->count - 1]));
+			std::move_backward(values + i, values + c->count - 2, values + c->count - 1);
+			values[i] = std::move(value);
+		}
+
+		// destroys the values of c from first on
+		void destroy_values(chunk* c, size_t first) noexcept {
+			if constexpr (!std::is_trivially_destructible<T>::value) {
+				for (size_t i = first; i < c->count; ++i) {
+					chunk_traits::destroy(pool_.allocator(), c->values() + i);
+				}
+			}
+			c->count = first;
+		}
+
+		// moves the values of from, from first on, onto the end of to
+		void relocate(chunk* from, size_t first, chunk* to) {
+			T* values = from->values();
+			for (size_t i = first; i < from->count; ++i) {
+				construct(to, std::move(values[i]));
+			}
+			destroy_values(from, first);
+		}
+
+		// a chunk holding one value, linked in before pos (nullptr for the end)
+		template<typename... Args>
+		void add_chunk_before(chunk* pos, Args&&... args) {
+			chunk* fresh = ::new (static_cast<void*>(pool_.allocate())) chunk;
+			try {
+				construct(fresh, std::forward<Args>(args)...);
+			}
+			catch (...) {
+				pool_.deallocate(fresh);
+				throw;
+			}
+			link_before(pos, fresh, fresh);
+		}
+
+		// moves the values of c from at on into a new chunk linked after it
+		chunk* split(chunk* c, size_t at) {
+			chunk* upper = ::new (static_cast<void*>(pool_.allocate())) chunk;
+			relocate(c, at, upper);
+			link_before(c->next, upper, upper);
+			return upper;
+		}
+
+		// links the chain first .. last in before pos (nullptr for the end)
+		void link_before(chunk* pos, chunk* first, chunk* last) noexcept {
+			chunk* before = pos ? pos->prior : tail_;
+			first->prior = before;
+			last->next = pos;
+			if (before) {
+				before->next = first;
+			}
+			else {
+				head_ = first;
+			}
+			if (pos) {
+				pos->prior = last;
+			}
+			else {
+				tail_ = last;
+			}
+		}
+
+		// unlinks c, which must be empty, and gives it back to the pool
+		void free_chunk(chunk* c) noexcept {
+			if (c->prior) {
+				c->prior->next = c->next;
+			}
+			else {
+				head_ = c->next;
+			}
+			if (c->next) {
+				c->next->prior = c->prior;
+			}
+			else {
+				tail_ = c->prior;
+			}
+			pool_.deallocate(c);
+		}
+
+		// destroys the values from pos to the end
+		void truncate(iterator pos) {
+			if (pos.chunk_ == nullptr) {
+				return;
+			}
+			chunk* c = pos.chunk_;
+			while (c != tail_) {
+				size_ -= tail_->count;
+				destroy_values(tail_, 0);
+				free_chunk(tail_);
+			}
+			size_ -= c->count - pos.index_;
+			destroy_values(c, pos.index_);
+			if (c->count == 0) {
+				free_chunk(c);
+			}
+		}
+
+		void swap_chunks(unrolled_list& other) noexcept {
+			pool_.swap_storage(other.pool_);
+			std::swap(size_, other.size_);
+			std::swap(head_, other.head_);
+			std::swap(tail_, other.tail_);
+		}
+
+		chunk* head_ = nullptr;
+		chunk* tail_ = nullptr;
+		size_t size_ = 0;
+		node_pool<chunk, chunk_allocator> pool_;  // every chunk lives in here
+	};
+
+	namespace pmr {
+		// unrolled_list whose chunks come from a std::pmr::memory_resource
+		template< typename T, size_t N = unrolled_chunk_size<T>() >
+		using unrolled_list = wheel::unrolled_list<T, N, std::pmr::polymorphic_allocator<T>>;
+	}
+
+}  // namespace wheel
+
+#endif // UNROLLED_LIST_HPP_
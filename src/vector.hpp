@@ -14,105 +14,282 @@ size()          O(1)
 v[ i ]          O(1)
 push_back(x)    O(1)
 pop_back        O(1)
-insert          O(size())  // TODO
+insert          O(size())  // implemented single element only
 erase           O(size())  // implemented single element only
 front, back     O(1)
 */
 
 #include <iterator>
 #include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #include <initializer_list>
-#include <iostream>  // debug output
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 namespace wheel {  // as in re-inventing the wheel
 
+    // A type is trivially relocatable if moving an object to a new address and
+    // forgetting the old one (no destructor call) can be done with a memcpy.
+    // Trivially copyable types always qualify.  Other types, for example a handle
+    // owning a pointer, can opt in by specialising this trait:
+    //
+    //   template<> struct wheel::is_trivially_relocatable<my_handle> : std::true_type {};
     template< typename T >
+    struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+    // Growth policies - where vector storage comes from and how it grows.
+
+    // Every resize gets a fresh block from the vector's Allocator and relocates
+    // the elements across.
+    struct relocating_growth {
+        static constexpr bool grows_in_place = false;
+    };
+
+    // Resizes by asking the C heap to extend the existing block, which for a
+    // big buffer avoids copying it at all.  Small buffers use realloc.  On
+    // linux buffers of at least huge_threshold bytes are page-aligned mappings
+    // grown with mremap, which moves page table entries rather than bytes.
+    // Only used for trivially relocatable T - other types relocate as usual
+    // through allocate/deallocate.  Failure throws std::bad_alloc and leaves
+    // the original block untouched.  This policy owns the memory itself, so it
+    // can only be combined with std::allocator.
+    struct inplace_growth {
+        static constexpr bool grows_in_place = true;
+        static constexpr size_t huge_threshold = 1u << 20;
+
+        static void* allocate(size_t bytes) {
+#ifdef __linux__
+            if (is_huge(bytes)) {
+                void* block = ::mmap(nullptr, round_to_pages(bytes), PROT_READ | PROT_WRITE,
+                                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (block == MAP_FAILED) {
+                    throw std::bad_alloc();
+                }
+                return block;
+            }
+#endif
+            void* block = std::malloc(bytes == 0 ? 1 : bytes);
+            if (block == nullptr) {
+                throw std::bad_alloc();
+            }
+            return block;
+        }
+
+        static void* reallocate(void* block, size_t old_bytes, size_t new_bytes) {
+            if (block == nullptr) {
+                return allocate(new_bytes);
+            }
+#ifdef __linux__
+            if (is_huge(old_bytes) && is_huge(new_bytes)) {
+                void* moved = ::mremap(block, round_to_pages(old_bytes), round_to_pages(new_bytes), MREMAP_MAYMOVE);
+                if (moved == MAP_FAILED) {
+                    throw std::bad_alloc();
+                }
+                return moved;
+            }
+            if (is_huge(old_bytes) != is_huge(new_bytes)) {
+                // crossing the threshold changes allocator so has to copy, once
+                void* moved = allocate(new_bytes);
+                std::memcpy(moved, block, std::min(old_bytes, new_bytes));
+                deallocate(block, old_bytes);
+                return moved;
+            }
+#endif
+            void* moved = std::realloc(block, new_bytes == 0 ? 1 : new_bytes);
+            if (moved == nullptr) {
+                throw std::bad_alloc();
+            }
+            return moved;
+        }
+
+        static void deallocate(void* block, size_t bytes) noexcept {
+            if (block == nullptr) {
+                return;
+            }
+#ifdef __linux__
+            if (is_huge(bytes)) {
+                ::munmap(block, round_to_pages(bytes));
+                return;
+            }
+#endif
+            std::free(block);
+        }
+
+    private:
+        static bool is_huge(size_t bytes) {
+            return bytes >= huge_threshold;
+        }
+
+#ifdef __linux__
+        static size_t round_to_pages(size_t bytes) {
+            static const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+            return (bytes + page - 1) / page * page;
+        }
+#endif
+    };
+
+    template< typename T, typename Allocator = std::allocator<T>, typename Growth = relocating_growth >
     class vector {
+        static_assert(!Growth::grows_in_place || alignof(T) <= alignof(std::max_align_t),
+                      "in-place growth uses malloc, which only guarantees fundamental alignment");
+        static_assert(!Growth::grows_in_place || std::is_same<Allocator, std::allocator<T>>::value,
+                      "in-place growth bypasses the allocator, so cannot honour a custom one");
+
+        using alloc_traits = std::allocator_traits<Allocator>;
+
     public:
+        using value_type = T;
+        using allocator_type = Allocator;
 
         template< typename input_iterator >
-        vector(input_iterator first, input_iterator last) {
-
-            size_ = std::distance(first, last);
-            array_ = nullptr;
-            resize_array(size_);
-            std::copy(first, last, array_);
+        vector(input_iterator first, input_iterator last, const Allocator& alloc = Allocator())
+            : size_(0), capacity_(0), array_(nullptr), alloc_(alloc) {
+            resize_array(std::distance(first, last));
+            construct_from(first, last);
         }
 
-        vector(std::initializer_list<T> init) : size_(init.size()), array_(nullptr) {
-            size_ = init.size();
-            resize_array(size_);
-            std::copy(init.begin(), init.end(), array_);
+        vector(std::initializer_list<T> init, const Allocator& alloc = Allocator())
+            : size_(0), capacity_(0), array_(nullptr), alloc_(alloc) {
+            resize_array(init.size());
+            construct_from(init.begin(), init.end());
         }
 
-        vector() : size_(0), array_(nullptr) {
+        vector() : vector(Allocator()) {}
+
+        explicit vector(const Allocator& alloc) : size_(0), array_(nullptr), alloc_(alloc) {
             resize_array(8);
-            std::cout << "allocating array at address: " << array_ << std::endl;
         }
 
-        vector(size_t count, const T& value) : size_(count), array_(nullptr) {
+        vector(size_t count, const T& value, const Allocator& alloc = Allocator())
+            : size_(0), array_(nullptr), alloc_(alloc) {
             resize_array(count);
-            std::fill(array_, array_+size_, value);
+            try {
+                construct_fill(array_, array_ + count, value);
+            }
+            catch (...) {
+                deallocate(array_, capacity_);
+                throw;
+            }
+            size_ = count;
         }
 
-        vector(const vector& other) : size_(other.size()), capacity_(other.capacity()), array_(nullptr) {
-            resize_array(capacity_);
-            std::cout << "copy ctor allocated array at address: " << array_ << std::endl;
-            std::copy(other.begin(), other.end(), array_);
-        }
+        vector(const vector& other)
+            : vector(other, alloc_traits::select_on_container_copy_construction(other.alloc_)) {}
 
-        vector& operator=(const vector& other) {
-            if (this != &other) {
-                size_ = other.size();
-                delete [] array_;
-                array_ = nullptr;
-                resize_array(other.capacity());
-                std::cout << "op= allocated array at address: " << array_ << std::endl;
-                std::copy(other.begin(), other.end(), array_);
-            }
-            return *this;
+        vector(const vector& other, const Allocator& alloc)
+            : size_(0), capacity_(0), array_(nullptr), alloc_(alloc) {
+            resize_array(other.capacity());
+            construct_from(other.begin(), other.end());
         }
 
-        vector(vector&& other) : size_(other.size()), capacity_(other.capacity()), array_(other.begin()) {
+        vector(vector&& other) noexcept
+            : size_(other.size()), capacity_(other.capacity()), array_(other.begin()), alloc_(std::move(other.alloc_)) {
             other.size_ = 0;
             other.capacity_ = 0;
             other.array_ = nullptr;
         }
 
-        vector& operator=(vector&& other) {
-            //free(array_);
-            delete [] array_;
-            array_ = other.array_;
-            size_ = other.size();
-            capacity_ = other.capacity();
-            other.array_ = nullptr;
-            other.size_ = 0;
-            other.capacity_ = 0;
+        // copy and swap - the copy is made with whichever allocator *this ends up
+        // with, so the swap never leaves an array paired with the wrong allocator,
+        // and if the copy throws *this is left untouched
+        vector& operator=(const vector& other) {
+            if (this != &other) {
+                constexpr bool propagate = alloc_traits::propagate_on_container_copy_assignment::value;
+                vector copy(other, propagate ? other.alloc_ : alloc_);
+                swap_storage(copy);
+                if constexpr (propagate) {
+                    std::swap(alloc_, copy.alloc_);
+                }
+            }
+            return *this;
+        }
+
+        // O(1) unless the allocators differ and cannot be propagated, in which
+        // case the elements have to be moved one by one into our own storage
+        vector& operator=(vector&& other) noexcept(alloc_traits::propagate_on_container_move_assignment::value ||
+                                                   alloc_traits::is_always_equal::value) {
+            if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+                clear();
+                alloc_ = std::move(other.alloc_);
+                swap_storage(other);
+            }
+            else {
+                if (alloc_traits::is_always_equal::value || alloc_ == other.alloc_) {
+                    clear();
+                    swap_storage(other);
+                }
+                else {
+                    vector moved(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()), alloc_);
+                    swap_storage(moved);
+                    other.clear();
+                }
+            }
+            return *this;
         }
 
         ~vector() {
             clear();
         }
 
+        // allocators are only exchanged if they say so - otherwise, as for the
+        // standard containers, they must compare equal
+        friend void swap(vector& first, vector& second) noexcept {
+            if constexpr (alloc_traits::propagate_on_container_swap::value) {
+                std::swap(first.alloc_, second.alloc_);
+            }
+            first.swap_storage(second);
+        }
+
+        allocator_type get_allocator() const {
+            return alloc_;
+        }
 
-        // O(n) - implementation below will leak - I think, because have to call destructor on each element?
+        // O(n) - elements destroyed in reverse order, like a C array, then storage released
         void clear() {
-            std::cout << "deallocating array at address: " << array_ << std::endl;
-            delete [] array_;
+            destroy(array_, array_ + size_);
+            deallocate(array_, capacity_);
             array_ = nullptr;
             size_ = 0u;
             capacity_ = 0u;
         }
 
         void push_back(const T& v) {
+            emplace_back(v);
+        }
+
+        void push_back(T&& v) {
+            emplace_back(std::move(v));
+        }
+
+        template<typename... Args>
+        T& emplace_back(Args&&... args) {
             if (size_ == capacity_) {
+                // args may refer to an element of this vector, so build the new
+                // value before growing invalidates it
+                T value(std::forward<Args>(args)...);
                 resize_array(size_ == 0 ? 8 : size_ * 2);
+                construct(array_ + size_, std::move_if_noexcept(value));
             }
-            array_[size_++] = v;
+            else {
+                construct(array_ + size_, std::forward<Args>(args)...);
+            }
+            return array_[size_++];
         }
 
         void pop_back() {
             --size_;
+            alloc_traits::destroy(alloc_, array_ + size_);
         }
 
         size_t size() const { return size_; }
@@ -161,36 +338,216 @@ namespace wheel {  // as in re-inventing the wheel
             return capacity_;
         }
 
+        static constexpr size_t max_size() {
+            return std::numeric_limits<size_t>::max() / sizeof(T);
+        }
+
+        // O(size()) if the capacity has to grow
+        void reserve(size_t new_capacity) {
+            if (new_capacity > capacity_) {
+                resize_array(new_capacity);
+            }
+        }
+
+        // O(size()) - returns pointer to the inserted element
+        T* insert(const T* pos, const T& value) {
+            return emplace(pos, value);
+        }
+
+        T* insert(const T* pos, T&& value) {
+            return emplace(pos, std::move(value));
+        }
+
+        template<typename... Args>
+        T* emplace(const T* pos, Args&&... args) {
+            size_t index = pos - array_;
+            // as in emplace_back, args may refer to one of our elements
+            T value(std::forward<Args>(args)...);
+            if (size_ == capacity_) {
+                resize_array(size_ == 0 ? 8 : size_ * 2);
+            }
+
+            T* where = array_ + index;
+            if (where == end()) {
+                construct(where, std::move_if_noexcept(value));
+            }
+            else if constexpr (is_trivially_relocatable<T>::value) {
+                std::memmove(static_cast<void*>(where + 1), where, (size_ - index) * sizeof(T));
+                try {
+                    construct(where, std::move_if_noexcept(value));
+                }
+                catch (...) {
+                    std::memmove(static_cast<void*>(where), where + 1, (size_ - index) * sizeof(T));
+                    throw;
+                }
+            }
+            else {
+                construct(end(), std::move(array_[size_ - 1]));
+                std::move_backward(where, end() - 1, end());
+                *where = std::move(value);
+            }
+            ++size_;
+            return where;
+        }
+
         T* erase(T* pos) {
-            T* next = pos+1;
-            std::copy(next, end(), pos);
-            --size_;
+            if constexpr (is_trivially_relocatable<T>::value) {
+                alloc_traits::destroy(alloc_, pos);
+                std::memmove(static_cast<void*>(pos), pos + 1, (end() - pos - 1) * sizeof(T));
+                --size_;
+            }
+            else {
+                std::move(pos + 1, end(), pos);
+                pop_back();
+            }
             return pos;
         }
 
     private:
+        // move elements to the new array if that cannot throw, otherwise copy them
+        // so that a throwing copy leaves the original array intact
+        using relocate_iterator = std::conditional_t<
+            std::is_nothrow_move_constructible<T>::value || !std::is_copy_constructible<T>::value,
+            std::move_iterator<T*>, T*>;
+
+        // storage only - no T is constructed until an element is added
         void resize_array(size_t new_size) {
 
-            T* temp = nullptr;
-            if (array_) {
-                temp = new T[new_size];
-                std::copy(array_, array_ + size_, temp);
+            if constexpr (Growth::grows_in_place && is_trivially_relocatable<T>::value) {
+                if (new_size > max_size()) {
+                    throw std::bad_array_new_length();
+                }
+                array_ = static_cast<T*>(Growth::reallocate(array_, capacity_ * sizeof(T), new_size * sizeof(T)));
+                capacity_ = new_size;
+                return;
+            }
+
+            T* temp = allocate(new_size);
+            if constexpr (is_trivially_relocatable<T>::value) {
+                // one block copy, and the old objects are simply forgotten
+                if (size_ != 0) {
+                    std::memcpy(static_cast<void*>(temp), array_, size_ * sizeof(T));
+                }
                 std::swap(array_, temp);
-                delete[] temp;
             }
             else {
-                array_ = new T[new_size];
+                try {
+                    construct_copy(relocate_iterator(array_), relocate_iterator(array_ + size_), temp);
+                }
+                catch (...) {
+                    deallocate(temp, new_size);
+                    throw;
+                }
+                std::swap(array_, temp);
+                destroy(temp, temp + size_);
             }
+            deallocate(temp, capacity_);
 
             capacity_ = new_size;
 
         }
 
+        // fills the freshly allocated array_, which the caller's constructor owns
+        // until it returns, so free it here if an element constructor throws
+        template< typename input_iterator >
+        void construct_from(input_iterator first, input_iterator last) {
+            try {
+                size_ = construct_copy(first, last, array_) - array_;
+            }
+            catch (...) {
+                deallocate(array_, capacity_);
+                array_ = nullptr;
+                capacity_ = 0;
+                throw;
+            }
+        }
+
+        // elements are always built through the allocator, so that a scoped
+        // allocator such as std::pmr::polymorphic_allocator reaches them too
+        template<typename... Args>
+        void construct(T* where, Args&&... args) {
+            alloc_traits::construct(alloc_, where, std::forward<Args>(args)...);
+        }
+
+        // like std::uninitialized_copy - on failure destroys what it built
+        template< typename input_iterator >
+        T* construct_copy(input_iterator first, input_iterator last, T* dest) {
+            T* current = dest;
+            try {
+                for (; first != last; ++first, ++current) {
+                    construct(current, *first);
+                }
+            }
+            catch (...) {
+                destroy(dest, current);
+                throw;
+            }
+            return current;
+        }
+
+        void construct_fill(T* first, T* last, const T& value) {
+            T* current = first;
+            try {
+                for (; current != last; ++current) {
+                    construct(current, value);
+                }
+            }
+            catch (...) {
+                destroy(first, current);
+                throw;
+            }
+        }
+
+        T* allocate(size_t count) {
+            if (count > max_size()) {
+                throw std::bad_array_new_length();
+            }
+            if constexpr (Growth::grows_in_place) {
+                return static_cast<T*>(Growth::allocate(count * sizeof(T)));
+            }
+            else {
+                return alloc_traits::allocate(alloc_, count);
+            }
+        }
+
+        void deallocate(T* array, size_t count) noexcept {
+            if (array == nullptr) {
+                return;
+            }
+            if constexpr (Growth::grows_in_place) {
+                Growth::deallocate(array, count * sizeof(T));
+            }
+            else {
+                alloc_traits::deallocate(alloc_, array, count);
+            }
+        }
+
+        void destroy(T* first, T* last) noexcept {
+            while (last != first) {
+                alloc_traits::destroy(alloc_, --last);
+            }
+        }
+
+        void swap_storage(vector& other) noexcept {
+            std::swap(size_, other.size_);
+            std::swap(capacity_, other.capacity_);
+            std::swap(array_, other.array_);
+        }
+
         size_t size_ = 0;
         size_t capacity_ = 0;
         T* array_ = nullptr;
+        Allocator alloc_;
     };
 
+    namespace pmr {
+        // vector whose storage comes from a std::pmr::memory_resource, eg
+        //   std::pmr::monotonic_buffer_resource arena;
+        //   wheel::pmr::vector<int> v(&arena);
+        template< typename T >
+        using vector = wheel::vector<T, std::pmr::polymorphic_allocator<T>>;
+    }
+
 } // end of namespace wheel
 
 #endif // VECTOR_
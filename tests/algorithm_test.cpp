@@ -0,0 +1,154 @@
+#include "algorithm.hpp"
+#include "list.hpp"
+#include "vector.hpp"
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include "detect_leaks.hpp"  // no valgrind on windows
+#endif
+
+#include "gtest/gtest.h"
+
+using namespace wheel;
+
+class algorithm_test : public ::testing::Test {
+protected:
+	void SetUp() override {
+#ifdef _WIN32
+		start_detecting();
+#endif
+	}
+
+	// void TearDown() override {}
+};
+
+namespace {
+
+	// enough elements for many chunks
+	constexpr size_t many = 100000;
+
+	std::vector<int> random_ints(size_t count, unsigned seed) {
+		std::mt19937 rng(seed);
+		std::uniform_int_distribution<int> values(-1000000, 1000000);
+		std::vector<int> result(count);
+		for (int& v : result) {
+			v = values(rng);
+		}
+		return result;
+	}
+
+}
+
+TEST_F(algorithm_test, for_each_over_vector_and_list) {
+	vector<int> v(many, 1);
+	wheel::for_each(execution::par, v.begin(), v.end(), [](int& x) { x *= 3; });
+	EXPECT_TRUE(std::all_of(v.begin(), v.end(), [](int x) { return x == 3; }));
+
+	std::vector<int> values(many);
+	std::iota(values.begin(), values.end(), 0);
+	list<int> l(values.begin(), values.end());
+	wheel::for_each(execution::par_unseq, l.begin(), l.end(), [](int& x) { x += 1; });
+	int expected = 1;
+	for (int x : l) {
+		ASSERT_EQ(x, expected++);
+	}
+}
+
+TEST_F(algorithm_test, for_each_empty_and_small_ranges) {
+	vector<int> v;
+	wheel::for_each(execution::par, v.begin(), v.end(), [](int&) { FAIL(); });
+	v.push_back(5);
+	wheel::for_each(execution::par, v.begin(), v.end(), [](int& x) { x = 6; });
+	EXPECT_EQ(v[0], 6);
+}
+
+TEST_F(algorithm_test, transform_list_into_vector) {
+	std::vector<int> values = random_ints(many, 1);
+	list<int> l(values.begin(), values.end());
+	vector<long long> out(many, 0);
+	long long* end = wheel::transform(execution::par, l.begin(), l.end(), out.begin(),
+		[](int x) { return 2LL * x; });
+	EXPECT_EQ(end, out.end());
+	for (size_t i = 0; i < values.size(); ++i) {
+		ASSERT_EQ(out[i], 2LL * values[i]);
+	}
+}
+
+TEST_F(algorithm_test, copy_vector_into_list) {
+	std::vector<int> values = random_ints(many, 2);
+	vector<int> v(values.begin(), values.end());
+	std::vector<int> zeros(many, 0);
+	list<int> target(zeros.begin(), zeros.end());
+	auto end = wheel::copy(execution::par, v.begin(), v.end(), target.begin());
+	EXPECT_TRUE(end == target.end());
+	EXPECT_TRUE(std::equal(values.begin(), values.end(), target.begin()));
+}
+
+TEST_F(algorithm_test, reduce_sums_like_accumulate) {
+	std::vector<int> values = random_ints(many, 3);
+	vector<int> v(values.begin(), values.end());
+	long long expected = std::accumulate(values.begin(), values.end(), 0LL);
+	EXPECT_EQ(wheel::reduce(execution::par, v.begin(), v.end(), 0LL), expected);
+	EXPECT_EQ(wheel::reduce(execution::seq, v.begin(), v.end(), 0LL), expected);
+	EXPECT_EQ(wheel::reduce(execution::par, v.begin(), v.begin(), 42LL), 42);
+	EXPECT_EQ(wheel::reduce(execution::par, v.begin(), v.begin() + 3),
+		values[0] + values[1] + values[2]);
+}
+
+TEST_F(algorithm_test, reduce_keeps_the_order_of_an_associative_op) {
+	// concatenation is associative but not commutative
+	std::vector<std::string> letters;
+	for (int i = 0; i < 20000; ++i) {
+		letters.push_back(std::string(1, static_cast<char>('a' + i % 26)));
+	}
+	list<std::string> l(letters.begin(), letters.end());
+	std::string expected = std::accumulate(letters.begin(), letters.end(), std::string(">"));
+	EXPECT_EQ(wheel::reduce(execution::par, l.begin(), l.end(), std::string(">")), expected);
+}
+
+TEST_F(algorithm_test, sort_vector_matches_std_sort) {
+	for (size_t count : { size_t(0), size_t(1), size_t(1000), size_t(many), size_t(many + 77) }) {
+		std::vector<int> values = random_ints(count, static_cast<unsigned>(count));
+		vector<int> v(values.begin(), values.end());
+		wheel::sort(execution::par, v.begin(), v.end());
+		std::sort(values.begin(), values.end());
+		ASSERT_TRUE(std::equal(values.begin(), values.end(), v.begin())) << count;
+	}
+}
+
+TEST_F(algorithm_test, sort_list_with_comparator_keeps_nodes) {
+	std::vector<int> values = random_ints(many, 4);
+	list<int> l(values.begin(), values.end());
+	int* first_value = &*l.begin();
+	wheel::sort(execution::par, l.begin(), l.end(), std::greater<>());
+	std::sort(values.begin(), values.end(), std::greater<>());
+	EXPECT_TRUE(std::equal(values.begin(), values.end(), l.begin()));
+	EXPECT_EQ(&*l.begin(), first_value);  // values moved, nodes did not
+	EXPECT_EQ(l.size(), values.size());
+}
+
+TEST_F(algorithm_test, policy_on_own_pool) {
+	thread_pool pool(2);
+	std::vector<int> values = random_ints(many, 5);
+	vector<int> v(values.begin(), values.end());
+	wheel::sort(execution::par.on(pool), v.begin(), v.end());
+	EXPECT_TRUE(std::is_sorted(v.begin(), v.end()));
+	wheel::sort(execution::seq, v.begin(), v.end(), std::greater<>());
+	EXPECT_TRUE(std::is_sorted(v.begin(), v.end(), std::greater<>()));
+}
+
+TEST_F(algorithm_test, exception_from_element_operation_reaches_caller) {
+	vector<int> v(many, 0);
+	v[many / 2] = 1;
+	EXPECT_THROW(wheel::for_each(execution::par, v.begin(), v.end(), [](int x) {
+		if (x == 1) {
+			throw std::invalid_argument("one");
+		}
+	}), std::invalid_argument);
+}
@@ -0,0 +1,282 @@
+#include "concurrent_ordered_set.hpp"
+#include "counting_resource.hpp"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include "detect_leaks.hpp"  // no valgrind on windows
+#endif
+
+#include "gtest/gtest.h"
+
+using namespace wheel;
+
+class concurrent_ordered_set_test : public ::testing::Test {
+protected:
+	void SetUp() override {
+#ifdef _WIN32
+		start_detecting();
+#endif
+	}
+
+	// void TearDown() override {}
+};
+
+TEST_F(concurrent_ordered_set_test, insert_returns_iterator_and_whether_inserted) {
+	concurrent_ordered_set<int> s;
+	auto first = s.insert(5);
+	EXPECT_TRUE(first.second);
+	EXPECT_EQ(*first.first, 5);
+	auto again = s.insert(5);
+	EXPECT_FALSE(again.second);
+	EXPECT_EQ(again.first, first.first);
+	EXPECT_EQ(s.size(), 1u);
+}
+
+TEST_F(concurrent_ordered_set_test, iterates_in_order_like_std_set) {
+	std::mt19937 rng(7);
+	std::vector<int> keys(5000);
+	for (int& k : keys) {
+		k = static_cast<int>(rng() % 3000);
+	}
+	concurrent_ordered_set<int> s(keys.begin(), keys.end());
+	std::set<int> expected(keys.begin(), keys.end());
+	EXPECT_EQ(s.size(), expected.size());
+	EXPECT_TRUE(std::equal(expected.begin(), expected.end(), s.begin(), s.end()));
+}
+
+TEST_F(concurrent_ordered_set_test, find_contains_and_lower_bound) {
+	concurrent_ordered_set<int> s{ 10, 20, 30 };
+	EXPECT_TRUE(s.contains(20));
+	EXPECT_FALSE(s.contains(25));
+	EXPECT_EQ(s.count(30), 1u);
+	EXPECT_EQ(s.find(25), s.end());
+	EXPECT_EQ(*s.find(10), 10);
+	EXPECT_EQ(*s.lower_bound(11), 20);
+	EXPECT_EQ(*s.lower_bound(0), 10);
+	EXPECT_EQ(s.lower_bound(31), s.end());
+}
+
+TEST_F(concurrent_ordered_set_test, erase_then_insert_again) {
+	concurrent_ordered_set<std::string> s{ "a", "b", "c" };
+	EXPECT_EQ(s.erase("b"), 1u);
+	EXPECT_EQ(s.erase("b"), 0u);
+	EXPECT_FALSE(s.contains("b"));
+	EXPECT_EQ(s.size(), 2u);
+	EXPECT_EQ(std::vector<std::string>(s.begin(), s.end()), (std::vector<std::string>{ "a", "c" }));
+	EXPECT_TRUE(s.insert("b").second);
+	EXPECT_EQ(std::vector<std::string>(s.begin(), s.end()), (std::vector<std::string>{ "a", "b", "c" }));
+}
+
+TEST_F(concurrent_ordered_set_test, moved_key_is_inserted_intact) {
+	concurrent_ordered_set<std::string> s{ "apple", "cherry" };
+	std::string key(40, 'b');
+	EXPECT_TRUE(s.insert(std::move(key)).second);
+	EXPECT_TRUE(s.contains(std::string(40, 'b')));
+	std::string duplicate(40, 'b');
+	EXPECT_FALSE(s.insert(std::move(duplicate)).second);
+	EXPECT_EQ(duplicate, std::string(40, 'b'));  // not taken
+}
+
+TEST_F(concurrent_ordered_set_test, custom_comparator_and_clear) {
+	concurrent_ordered_set<int, std::greater<int>> s{ 1, 3, 2 };
+	EXPECT_EQ(std::vector<int>(s.begin(), s.end()), (std::vector<int>{ 3, 2, 1 }));
+	s.clear();
+	EXPECT_TRUE(s.empty());
+	EXPECT_EQ(s.begin(), s.end());
+	s.insert(4);
+	EXPECT_EQ(*s.begin(), 4);
+}
+
+TEST_F(concurrent_ordered_set_test, erased_nodes_come_back_at_clear) {
+	counting_resource counter;  // one thread here, so it need not be thread safe
+	{
+		pmr::concurrent_ordered_set<int> s(&counter);
+		for (int i = 0; i < 1000; ++i) {
+			s.insert(i);
+			s.erase(i / 2);
+		}
+		EXPECT_EQ(counter.deallocations, 0u);
+		s.clear();
+		EXPECT_EQ(counter.bytes_outstanding, 0u);
+		s.insert(1);
+	}
+	EXPECT_EQ(counter.bytes_outstanding, 0u);
+	EXPECT_EQ(counter.allocations, counter.deallocations);
+}
+
+TEST_F(concurrent_ordered_set_test, collect_frees_only_erased_nodes) {
+	counting_resource counter;  // one thread here, so it need not be thread safe
+	{
+		pmr::concurrent_ordered_set<int> s(&counter);
+		for (int i = 0; i < 1000; ++i) {
+			s.insert(i);
+		}
+		size_t full = counter.bytes_outstanding;
+		for (int i = 0; i < 1000; i += 2) {
+			s.erase(i);
+		}
+		EXPECT_EQ(counter.bytes_outstanding, full);
+
+		EXPECT_EQ(s.collect(), 500u);
+		EXPECT_EQ(counter.deallocations, 500u);
+		EXPECT_LT(counter.bytes_outstanding, full);
+		EXPECT_EQ(s.collect(), 0u);
+
+		// the odd keys are intact, at every level
+		EXPECT_EQ(s.size(), 500u);
+		std::vector<int> odd(500);
+		for (int i = 0; i < 500; ++i) {
+			odd[i] = 2 * i + 1;
+		}
+		EXPECT_TRUE(std::equal(s.begin(), s.end(), odd.begin(), odd.end()));
+		for (int i = 0; i < 1000; ++i) {
+			EXPECT_EQ(s.contains(i), i % 2 == 1);
+		}
+		EXPECT_TRUE(s.insert(4).second);
+		EXPECT_EQ(s.erase(5), 1u);
+		EXPECT_EQ(*s.lower_bound(4), 4);
+		EXPECT_EQ(*++s.lower_bound(4), 7);
+	}
+	EXPECT_EQ(counter.bytes_outstanding, 0u);
+	EXPECT_EQ(counter.allocations, counter.deallocations);
+}
+
+TEST_F(concurrent_ordered_set_test, collect_after_threads_churn) {
+	concurrent_ordered_set<int> s;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([&s, t] {
+			std::mt19937 rng(t);
+			for (int i = 0; i < 20000; ++i) {
+				int key = static_cast<int>(rng() % 512);
+				if (rng() % 2) {
+					s.insert(key);
+				}
+				else {
+					s.erase(key);
+				}
+			}
+		});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+
+	std::vector<int> before(s.begin(), s.end());
+	s.collect();
+	EXPECT_EQ(std::vector<int>(s.begin(), s.end()), before);
+	EXPECT_EQ(s.size(), before.size());
+	for (int key = 0; key < 512; ++key) {
+		EXPECT_EQ(s.contains(key), std::binary_search(before.begin(), before.end(), key));
+	}
+	for (int key : before) {
+		EXPECT_EQ(s.erase(key), 1u);
+	}
+	EXPECT_TRUE(s.empty());
+	EXPECT_EQ(s.collect(), before.size());
+}
+
+TEST_F(concurrent_ordered_set_test, threads_inserting_the_same_keys_insert_each_once) {
+	concurrent_ordered_set<int> s;
+	std::atomic<int> inserted(0);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([&, t] {
+			std::vector<int> keys(20000);
+			std::iota(keys.begin(), keys.end(), 0);
+			std::shuffle(keys.begin(), keys.end(), std::mt19937(t));
+			for (int k : keys) {
+				if (s.insert(k).second) {
+					++inserted;
+				}
+			}
+		});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	EXPECT_EQ(inserted.load(), 20000);
+	EXPECT_EQ(s.size(), 20000u);
+	int expected = 0;
+	for (int k : s) {
+		ASSERT_EQ(k, expected++);
+	}
+}
+
+TEST_F(concurrent_ordered_set_test, readers_see_stable_keys_while_writers_churn) {
+	// the even keys are never touched, the odd ones come and go
+	concurrent_ordered_set<int> s;
+	for (int k = 0; k < 10000; k += 2) {
+		s.insert(k);
+	}
+	std::atomic<bool> stop(false);
+	std::atomic<int> missing(0);
+	std::vector<std::thread> threads;
+	for (int w = 0; w < 2; ++w) {
+		threads.emplace_back([&, w] {
+			std::mt19937 rng(w);
+			for (int round = 0; round < 40000; ++round) {
+				int k = static_cast<int>(rng() % 5000) * 2 + 1;
+				if (rng() % 2) {
+					s.insert(k);
+				}
+				else {
+					s.erase(k);
+				}
+			}
+		});
+	}
+	for (int r = 0; r < 2; ++r) {
+		threads.emplace_back([&] {
+			while (!stop.load()) {
+				for (int k = 0; k < 10000; k += 2) {
+					if (!s.contains(k)) {
+						++missing;
+					}
+				}
+			}
+		});
+	}
+	threads[0].join();
+	threads[1].join();
+	stop = true;
+	threads[2].join();
+	threads[3].join();
+
+	EXPECT_EQ(missing.load(), 0);
+	EXPECT_TRUE(std::is_sorted(s.begin(), s.end()));
+	EXPECT_EQ(static_cast<size_t>(std::distance(s.begin(), s.end())), s.size());
+	for (int k = 0; k < 10000; k += 2) {
+		ASSERT_TRUE(s.contains(k));
+	}
+}
+
+TEST_F(concurrent_ordered_set_test, each_key_erased_by_exactly_one_thread) {
+	concurrent_ordered_set<int> s;
+	for (int k = 0; k < 20000; ++k) {
+		s.insert(k);
+	}
+	std::atomic<size_t> erased(0);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([&] {
+			for (int k = 0; k < 20000; ++k) {
+				erased += s.erase(k);
+			}
+		});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	EXPECT_EQ(erased.load(), 20000u);
+	EXPECT_TRUE(s.empty());
+	EXPECT_EQ(s.begin(), s.end());
+}
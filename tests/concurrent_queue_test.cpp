@@ -0,0 +1,228 @@
+#include "concurrent_queue.hpp"
+#include "counting_resource.hpp"
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include "detect_leaks.hpp"  // no valgrind on windows
+#endif
+
+#include "gtest/gtest.h"
+
+using namespace wheel;
+
+class concurrent_queue_test : public ::testing::Test {
+protected:
+	void SetUp() override {
+#ifdef _WIN32
+		start_detecting();
+#endif
+	}
+
+	// void TearDown() override {}
+};
+
+namespace {
+
+	// throws when built from a negative number
+	struct picky {
+		picky(int v) : value(v) {
+			if (v < 0) {
+				throw std::invalid_argument("negative");
+			}
+		}
+		int value;
+	};
+
+}
+
+TEST_F(concurrent_queue_test, capacity_rounds_up_to_power_of_two) {
+	EXPECT_EQ(concurrent_queue<int>(0).capacity(), 2u);
+	EXPECT_EQ(concurrent_queue<int>(8).capacity(), 8u);
+	EXPECT_EQ(concurrent_queue<int>(9).capacity(), 16u);
+}
+
+TEST_F(concurrent_queue_test, first_in_first_out_until_full_then_empty) {
+	concurrent_queue<int> q(4);
+	EXPECT_TRUE(q.empty());
+	for (int i = 0; i < 4; ++i) {
+		EXPECT_TRUE(q.try_push(i));
+	}
+	EXPECT_FALSE(q.try_push(99));
+	EXPECT_EQ(q.size(), 4u);
+
+	int out = -1;
+	for (int i = 0; i < 4; ++i) {
+		ASSERT_TRUE(q.try_pop(out));
+		EXPECT_EQ(out, i);
+	}
+	EXPECT_FALSE(q.try_pop(out));
+	EXPECT_TRUE(q.empty());
+}
+
+TEST_F(concurrent_queue_test, wraps_around_the_ring_many_times) {
+	concurrent_queue<int> q(8);
+	int out = 0;
+	for (int i = 0; i < 1000; ++i) {
+		ASSERT_TRUE(q.try_push(i));
+		ASSERT_TRUE(q.try_push(i + 1));
+		ASSERT_TRUE(q.try_pop(out));
+		EXPECT_EQ(out, i);
+		ASSERT_TRUE(q.try_pop(out));
+		EXPECT_EQ(out, i + 1);
+	}
+}
+
+TEST_F(concurrent_queue_test, holds_move_only_values) {
+	concurrent_queue<std::unique_ptr<std::string>> q(2);
+	EXPECT_TRUE(q.try_emplace(new std::string("wheel")));
+	std::unique_ptr<std::string> out;
+	ASSERT_TRUE(q.try_pop(out));
+	EXPECT_EQ(*out, "wheel");
+}
+
+TEST_F(concurrent_queue_test, destructor_and_clear_destroy_what_is_left) {
+	auto counted = std::make_shared<int>(0);
+	{
+		concurrent_queue<std::shared_ptr<int>> q(8);
+		q.try_push(counted);
+		q.try_push(counted);
+		q.clear();
+		EXPECT_EQ(counted.use_count(), 1);
+		EXPECT_TRUE(q.empty());
+		q.try_push(counted);
+		EXPECT_EQ(counted.use_count(), 2);
+	}
+	EXPECT_EQ(counted.use_count(), 1);
+}
+
+TEST_F(concurrent_queue_test, batch_push_and_pop_take_what_fits) {
+	concurrent_queue<int> q(8);
+	std::vector<int> values(12);
+	std::iota(values.begin(), values.end(), 0);
+	EXPECT_EQ(q.try_push_batch(values.begin(), values.end()), 8u);
+	EXPECT_EQ(q.try_push_batch(values.begin(), values.end()), 0u);
+
+	std::vector<int> out;
+	EXPECT_EQ(q.try_pop_batch(std::back_inserter(out), 5), 5u);
+	EXPECT_EQ(q.try_push_batch(values.begin() + 8, values.end()), 4u);
+	EXPECT_EQ(q.try_pop_batch(std::back_inserter(out), 100), 7u);
+	EXPECT_EQ(out, values);
+	EXPECT_EQ(q.try_pop_batch(std::back_inserter(out), 100), 0u);
+}
+
+TEST_F(concurrent_queue_test, throwing_constructor_leaves_a_skipped_hole) {
+	concurrent_queue<picky> q(8);
+	EXPECT_TRUE(q.try_push(picky(1)));
+	EXPECT_THROW(q.try_emplace(-1), std::invalid_argument);
+	std::vector<int> values{ 2, -3, 4 };
+	EXPECT_THROW(q.try_push_batch(values.begin(), values.end()), std::invalid_argument);
+	EXPECT_TRUE(q.try_emplace(5));
+
+	// 1, the 2 of the batch before it threw, then 5 - the holes are skipped
+	picky out(0);
+	std::vector<int> popped;
+	while (q.try_pop(out)) {
+		popped.push_back(out.value);
+	}
+	EXPECT_EQ(popped, (std::vector<int>{ 1, 2, 5 }));
+
+	// a hole at the head of a full ring: the producer a lap on finds the
+	// queue full rather than waiting for the hole to be popped
+	EXPECT_THROW(q.try_emplace(-1), std::invalid_argument);
+	for (int i = 0; i < 7; ++i) {
+		EXPECT_TRUE(q.try_emplace(10 + i));
+	}
+	EXPECT_FALSE(q.try_push(picky(17)));
+	std::vector<int> more{ 17, 18 };
+	EXPECT_EQ(q.try_push_batch(more.begin(), more.end()), 0u);
+
+	popped.clear();
+	while (q.try_pop(out)) {
+		popped.push_back(out.value);
+	}
+	EXPECT_EQ(popped, (std::vector<int>{ 10, 11, 12, 13, 14, 15, 16 }));
+	EXPECT_TRUE(q.try_push(picky(17)));
+}
+
+TEST_F(concurrent_queue_test, ring_comes_from_the_allocator_once) {
+	counting_resource counter;
+	{
+		pmr::concurrent_queue<int> q(64, &counter);
+		for (int i = 0; i < 1000; ++i) {
+			q.try_push(i);
+			int out;
+			q.try_pop(out);
+		}
+		EXPECT_EQ(counter.allocations, 1u);
+	}
+	EXPECT_EQ(counter.bytes_outstanding, 0u);
+}
+
+TEST_F(concurrent_queue_test, many_producers_and_consumers_lose_nothing) {
+	const int producers = 4;
+	const int consumers = 4;
+	const int each = 20000;
+	concurrent_queue<int> q(256);
+	std::atomic<long long> sum(0);
+	std::atomic<int> received(0);
+	std::vector<std::thread> threads;
+
+	for (int p = 0; p < producers; ++p) {
+		threads.emplace_back([&q, p] {
+			std::vector<int> values(each);
+			std::iota(values.begin(), values.end(), p * each);
+			for (auto next = values.begin(); next != values.end(); ) {
+				bool pushed = false;
+				if (p % 2 == 0) {
+					pushed = q.try_push(*next);
+					next += pushed;
+				}
+				else {
+					size_t count = q.try_push_batch(next, next + std::min<std::ptrdiff_t>(8, values.end() - next));
+					pushed = count != 0;
+					next += count;
+				}
+				if (!pushed) {
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+	for (int c = 0; c < consumers; ++c) {
+		threads.emplace_back([&, c] {
+			int batch[16];
+			while (received.load() < producers * each) {
+				size_t got = 0;
+				if (c % 2 == 0) {
+					got = q.try_pop(batch[0]) ? 1 : 0;
+				}
+				else {
+					got = q.try_pop_batch(batch, 16);
+				}
+				if (got == 0) {
+					std::this_thread::yield();
+				}
+				for (size_t i = 0; i < got; ++i) {
+					sum += batch[i];
+				}
+				received += static_cast<int>(got);
+			}
+		});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+
+	long long n = producers * each;
+	EXPECT_EQ(received.load(), n);
+	EXPECT_EQ(sum.load(), n * (n - 1) / 2);
+	EXPECT_TRUE(q.empty());
+}
@@ -0,0 +1,33 @@
+#ifndef COUNTING_RESOURCE_HPP__
+#define COUNTING_RESOURCE_HPP__
+
+#include <cstddef>
+#include <memory_resource>
+
+// memory resource that forwards to new/delete and counts what passes through,
+// so tests can see where a container's memory came from and that it all came back
+class counting_resource : public std::pmr::memory_resource {
+public:
+	size_t allocations = 0;
+	size_t deallocations = 0;
+	size_t bytes_outstanding = 0;
+
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override {
+		++allocations;
+		bytes_outstanding += bytes;
+		return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	}
+
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+		++deallocations;
+		bytes_outstanding -= bytes;
+		std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+};
+
+#endif // COUNTING_RESOURCE_HPP__
@@ -0,0 +1,91 @@
+#include "flat_map.hpp"
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include "detect_leaks.hpp"  // no valgrind on windows
+#endif
+
+#include "gtest/gtest.h"
+
+using namespace wheel;
+
+class flat_map_test : public ::testing::Test {
+protected:
+	void SetUp() override {
+#ifdef _WIN32
+		start_detecting();
+#endif
+	}
+
+	// void TearDown() override {}
+};
+
+TEST_F(flat_map_test, inserted_value_can_be_retrieved) {
+	flat_map<int, std::string> mymap;
+	auto result = mymap.insert({ 2, "two" });
+	EXPECT_TRUE(result.second);
+	EXPECT_EQ(result.first->second, "two");
+	mymap.insert({ 1, "one" });
+
+	EXPECT_EQ(mymap.find(1)->second, "one");
+	EXPECT_EQ(mymap.find(3), mymap.end());
+	EXPECT_EQ(mymap.begin()->first, 1);
+}
+
+TEST_F(flat_map_test, insert_existing_key_keeps_old_value) {
+	flat_map<int, std::string> mymap = { { 1, "one" } };
+	EXPECT_FALSE(mymap.insert({ 1, "uno" }).second);
+	EXPECT_FALSE(mymap.try_emplace(1, "ein").second);
+	EXPECT_EQ(mymap.at(1), "one");
+}
+
+TEST_F(flat_map_test, subscript_inserts_default_then_assigns) {
+	flat_map<std::string, int> mymap;
+	EXPECT_EQ(mymap["b"], 0);
+	mymap["b"] = 5;
+	mymap["a"] += 2;
+	EXPECT_EQ(mymap.size(), 2u);
+	EXPECT_EQ(mymap.begin()->first, "a");
+	EXPECT_EQ(mymap.at("b"), 5);
+}
+
+TEST_F(flat_map_test, at_throws_for_missing_key) {
+	const flat_map<int, int> mymap = { { 1, 10 } };
+	EXPECT_EQ(mymap.at(1), 10);
+	EXPECT_THROW(mymap.at(2), std::out_of_range);
+}
+
+TEST_F(flat_map_test, batch_insert_keeps_existing_values) {
+	flat_map<int, std::string> mymap = { { 2, "two" }, { 4, "four" } };
+	std::vector<std::pair<int, std::string>> more = { { 3, "three" }, { 2, "deux" }, { 1, "one" }, { 3, "trois" } };
+	mymap.insert(more.begin(), more.end());
+	ASSERT_EQ(mymap.size(), 4u);
+	EXPECT_EQ(mymap.at(1), "one");
+	EXPECT_EQ(mymap.at(2), "two");
+	EXPECT_EQ(mymap.at(3), "three");
+	EXPECT_EQ(mymap.at(4), "four");
+}
+
+TEST_F(flat_map_test, erase_and_transparent_lookup) {
+	flat_map<std::string, int, std::less<>> mymap = { { "apple", 1 }, { "pear", 2 } };
+	EXPECT_EQ(mymap.at(std::string_view("pear")), 2);
+	EXPECT_EQ(mymap.erase("apple"), 1u);
+	EXPECT_EQ(mymap.erase("apple"), 0u);
+	EXPECT_EQ(mymap.size(), 1u);
+	EXPECT_EQ(mymap.find("apple"), mymap.end());
+}
+
+TEST_F(flat_map_test, writes_nothing_to_stdout) {
+	testing::internal::CaptureStdout();
+	{
+		flat_map<int, std::string> mymap = { { 2, "two" }, { 1, "one" } };
+		mymap[3] = "three";
+		flat_map<int, std::string> copy(mymap);
+		copy.erase(1);
+		copy.clear();
+	}
+	EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+}
@@ -0,0 +1,180 @@
+#include "flat_set.hpp"
+#include "ordered_set.hpp"
+#include "counting_resource.hpp"
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include "detect_leaks.hpp"  // no valgrind on windows
+#endif
+
+#include "gtest/gtest.h"
+
+using namespace wheel;
+
+class flat_set_test : public ::testing::Test {
+protected:
+	void SetUp() override {
+#ifdef _WIN32
+		start_detecting();
+#endif
+	}
+
+	// void TearDown() override {}
+};
+
+TEST_F(flat_set_test, size_zero_with_default_initialised_set) {
+	flat_set<int> myset;
+	EXPECT_EQ(myset.size(), 0u);
+	EXPECT_TRUE(myset.empty());
+	EXPECT_EQ(myset.begin(), myset.end());
+	EXPECT_EQ(myset.find(1), myset.end());
+}
+
+TEST_F(flat_set_test, insert_keeps_keys_sorted_and_unique) {
+	flat_set<int> myset;
+	for (int k : { 5, 1, 9, 3, 7, 1, 9 }) {
+		myset.insert(k);
+	}
+	EXPECT_EQ(std::vector<int>(myset.begin(), myset.end()), std::vector<int>({ 1, 3, 5, 7, 9 }));
+
+	auto result = myset.insert(3);
+	EXPECT_FALSE(result.second);
+	EXPECT_EQ(*result.first, 3);
+	EXPECT_EQ(myset.size(), 5u);
+}
+
+TEST_F(flat_set_test, find_every_key_and_no_other) {
+	// odd keys only, so every even key falls between two of them
+	for (int count : { 1, 2, 3, 16, 17, 1000 }) {
+		flat_set<int> myset;
+		for (int k = 0; k < count; ++k) {
+			myset.insert(2 * k + 1);
+		}
+		for (int k = 0; k <= 2 * count; ++k) {
+			auto found = myset.find(k);
+			if (k % 2) {
+				ASSERT_NE(found, myset.end());
+				EXPECT_EQ(*found, k);
+			}
+			else {
+				EXPECT_EQ(found, myset.end());
+			}
+			EXPECT_EQ(myset.rank(k), static_cast<size_t>(k / 2));
+			EXPECT_EQ(myset.lower_bound(k) - myset.begin(), k / 2);
+			EXPECT_EQ(myset.upper_bound(k) - myset.begin(), (k + 1) / 2);
+		}
+	}
+}
+
+TEST_F(flat_set_test, erase_removes_only_that_key) {
+	flat_set<int> myset = { 1, 2, 3, 4 };
+	EXPECT_EQ(myset.erase(2), 1u);
+	EXPECT_EQ(myset.erase(2), 0u);
+	EXPECT_EQ(std::vector<int>(myset.begin(), myset.end()), std::vector<int>({ 1, 3, 4 }));
+	myset.clear();
+	EXPECT_EQ(myset.size(), 0u);
+	EXPECT_TRUE(myset.insert(8).second);
+}
+
+TEST_F(flat_set_test, batch_insert_merges_with_existing_keys) {
+	std::mt19937 rng(11);
+	std::uniform_int_distribution<int> keys(0, 5000);
+	flat_set<int> myset;
+	ordered_set<int> expected;
+	for (int batch = 0; batch < 20; ++batch) {
+		std::vector<int> more(batch * 50);
+		for (int& k : more) {
+			k = keys(rng);
+		}
+		myset.insert(more.begin(), more.end());
+		for (int k : more) {
+			expected.insert(k);
+		}
+		ASSERT_EQ(myset.size(), expected.size());
+		EXPECT_TRUE(std::equal(myset.begin(), myset.end(), expected.begin(), expected.end()));
+	}
+}
+
+TEST_F(flat_set_test, batch_insert_keeps_the_first_equivalent_key) {
+	auto less_nocase = [](const std::string& a, const std::string& b) {
+		return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(),
+			[](char x, char y) { return std::tolower(x) < std::tolower(y); });
+	};
+	flat_set<std::string, decltype(less_nocase)> myset({ "b", "D" }, less_nocase);
+	std::vector<std::string> more = { "d", "A", "c", "a", "B" };
+	myset.insert(more.begin(), more.end());
+	EXPECT_EQ(std::vector<std::string>(myset.begin(), myset.end()),
+		std::vector<std::string>({ "A", "b", "c", "D" }));
+}
+
+TEST_F(flat_set_test, range_queries_and_order_statistics) {
+	flat_set<int> myset;
+	for (int k = 10; k <= 100; k += 10) {
+		myset.insert(k);
+	}
+	EXPECT_EQ(myset.count_range(20, 50), 3u);
+	EXPECT_EQ(myset.count_range(50, 20), 0u);
+	EXPECT_EQ(*myset.select(0), 10);
+	EXPECT_EQ(*myset.select(9), 100);
+	EXPECT_EQ(myset.select(10), myset.end());
+	auto range = myset.equal_range(40);
+	EXPECT_EQ(range.second - range.first, 1);
+	EXPECT_EQ(std::vector<int>(myset.rbegin(), myset.rbegin() + 3), std::vector<int>({ 100, 90, 80 }));
+}
+
+TEST_F(flat_set_test, transparent_find_takes_string_view) {
+	flat_set<std::string, std::less<>> myset = { "apple", "pear", "fig" };
+	EXPECT_NE(myset.find(std::string_view("pear")), myset.end());
+	EXPECT_EQ(myset.find("kiwi"), myset.end());
+	EXPECT_EQ(myset.erase("fig"), 1u);
+	EXPECT_EQ(myset.size(), 2u);
+}
+
+TEST_F(flat_set_test, transparent_range_queries) {
+	flat_set<std::string, std::less<>> myset = { "apple", "banana", "cherry", "damson" };
+	EXPECT_EQ(*myset.lower_bound(std::string_view("b")), "banana");
+	EXPECT_EQ(myset.rank(std::string_view("c")), 2u);
+	EXPECT_EQ(myset.count_range(std::string_view("a"), std::string_view("m")), 4u);
+	EXPECT_EQ(myset.count_range(std::string_view("banana"), std::string_view("damson")), 2u);
+	EXPECT_EQ(myset.count_range(std::string_view("d"), std::string_view("b")), 0u);
+}
+
+TEST_F(flat_set_test, set_algebra_matches_std_algorithms) {
+	flat_set<int> a = { 1, 3, 5, 7, 9, 11 };
+	flat_set<int> b = { 3, 4, 5, 6, 11, 12 };
+	flat_set<int> u = set_union(a, b);
+	flat_set<int> i = set_intersection(a, b);
+	flat_set<int> d = set_difference(std::move(a), std::move(b));
+	EXPECT_EQ(std::vector<int>(u.begin(), u.end()), std::vector<int>({ 1, 3, 4, 5, 6, 7, 9, 11, 12 }));
+	EXPECT_EQ(std::vector<int>(i.begin(), i.end()), std::vector<int>({ 3, 5, 11 }));
+	EXPECT_EQ(std::vector<int>(d.begin(), d.end()), std::vector<int>({ 1, 7, 9 }));
+}
+
+TEST_F(flat_set_test, pmr_set_takes_its_array_from_the_resource) {
+	counting_resource resource;
+	{
+		pmr::flat_set<std::pmr::string> myset(&resource);
+		std::vector<std::string> words = { "a long string that will not fit inline", "short" };
+		myset.insert(words.begin(), words.end());
+		EXPECT_GT(resource.allocations, 0u);
+		EXPECT_EQ(myset.begin()->get_allocator().resource(), &resource);
+	}
+	EXPECT_EQ(resource.bytes_outstanding, 0u);
+}
+
+TEST_F(flat_set_test, writes_nothing_to_stdout) {
+	testing::internal::CaptureStdout();
+	{
+		flat_set<int> myset = { 5, 1, 3 };
+		myset.insert(2);
+		flat_set<int> copy(myset);
+		copy.erase(3);
+		copy.clear();
+	}
+	EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+}
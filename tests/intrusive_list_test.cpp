@@ -0,0 +1,201 @@
+#include "intrusive_list.hpp"
+#include <iterator>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include "detect_leaks.hpp"  // no valgrind on windows
+#endif
+
+#include "gtest/gtest.h"
+
+using namespace wheel;
+
+namespace {
+
+	// can be in a run queue and its owner's list at once
+	struct job {
+		explicit job(int i) : id(i) {}
+
+		bool operator==(const job& other) const { return id == other.id; }
+
+		int id;
+		intrusive_list_hook<job> queued;
+		intrusive_list_hook<job> owned;
+	};
+
+	using run_queue = intrusive_list<job, &job::queued>;
+	using owner_list = intrusive_list<job, &job::owned>;
+
+	template< typename List >
+	std::vector<int> ids(const List& l) {
+		std::vector<int> result;
+		for (const job& j : l) {
+			result.push_back(j.id);
+		}
+		return result;
+	}
+
+	// the ids walking back from the end
+	template< typename List >
+	std::vector<int> ids_backwards(List& l) {
+		std::vector<int> result;
+		if (l.empty()) {
+			return result;
+		}
+		for (auto it = l.iterator_to(l.back()); it != l.end(); --it) {
+			result.push_back(it->id);
+		}
+		return result;
+	}
+
+}
+
+class intrusive_list_test : public ::testing::Test {
+protected:
+	void SetUp() override {
+#ifdef _WIN32
+		start_detecting();
+#endif
+	}
+
+	// void TearDown() override {}
+};
+
+TEST_F(intrusive_list_test, push_links_the_objects_themselves) {
+	std::vector<job> jobs{ job(0), job(1), job(2) };
+	run_queue queue;
+	queue.push_back(jobs[1]);
+	queue.push_back(jobs[2]);
+	queue.push_front(jobs[0]);
+	EXPECT_EQ(queue.size(), 3u);
+	EXPECT_EQ(&queue.front(), &jobs[0]);
+	EXPECT_EQ(&queue.back(), &jobs[2]);
+	EXPECT_EQ(ids(queue), (std::vector<int>{ 0, 1, 2 }));
+	EXPECT_EQ(ids_backwards(queue), (std::vector<int>{ 2, 1, 0 }));
+
+	// changes through the list are changes to the object
+	queue.front().id = 10;
+	EXPECT_EQ(jobs[0].id, 10);
+}
+
+TEST_F(intrusive_list_test, one_object_in_two_lists) {
+	std::vector<job> jobs{ job(0), job(1), job(2), job(3) };
+	run_queue queue(jobs.begin(), jobs.end());
+	owner_list mine;
+	mine.push_back(jobs[3]);
+	mine.push_back(jobs[1]);
+
+	queue.erase(queue.iterator_to(jobs[1]));
+	EXPECT_EQ(ids(queue), (std::vector<int>{ 0, 2, 3 }));
+	EXPECT_EQ(ids(mine), (std::vector<int>{ 3, 1 }));
+
+	mine.pop_front();
+	EXPECT_EQ(ids(queue), (std::vector<int>{ 0, 2, 3 }));
+	EXPECT_EQ(ids(mine), (std::vector<int>{ 1 }));
+}
+
+TEST_F(intrusive_list_test, insert_and_erase_in_the_middle) {
+	std::vector<job> jobs{ job(0), job(1), job(2), job(3) };
+	run_queue queue;
+	queue.push_back(jobs[0]);
+	queue.push_back(jobs[3]);
+	auto it = queue.insert(queue.iterator_to(jobs[3]), jobs[1]);
+	EXPECT_EQ(&*it, &jobs[1]);
+	queue.insert(++it, jobs[2]);
+	EXPECT_EQ(ids(queue), (std::vector<int>{ 0, 1, 2, 3 }));
+	EXPECT_EQ(ids_backwards(queue), (std::vector<int>{ 3, 2, 1, 0 }));
+
+	it = queue.erase(queue.iterator_to(jobs[2]));
+	EXPECT_EQ(it->id, 3);
+	it = queue.erase(it);
+	EXPECT_EQ(it, queue.end());
+	it = queue.erase(queue.begin());
+	EXPECT_EQ(&*it, &jobs[1]);
+	EXPECT_EQ(&queue.back(), &jobs[1]);
+	EXPECT_EQ(queue.size(), 1u);
+
+	// unlinked objects have clean hooks and can go straight back in
+	EXPECT_EQ(jobs[2].queued.next, nullptr);
+	EXPECT_EQ(jobs[2].queued.prior, nullptr);
+	queue.push_front(jobs[2]);
+	EXPECT_EQ(ids(queue), (std::vector<int>{ 2, 1 }));
+}
+
+TEST_F(intrusive_list_test, pop_until_empty) {
+	std::vector<job> jobs{ job(0), job(1), job(2) };
+	run_queue queue(jobs.begin(), jobs.end());
+	queue.pop_back();
+	queue.pop_front();
+	EXPECT_EQ(ids(queue), (std::vector<int>{ 1 }));
+	queue.pop_back();
+	EXPECT_TRUE(queue.empty());
+	EXPECT_EQ(queue.begin(), queue.end());
+	queue.pop_front();  // nothing to do
+	EXPECT_EQ(queue.size(), 0u);
+}
+
+TEST_F(intrusive_list_test, splice_relinks_without_touching_objects) {
+	std::vector<job> jobs{ job(0), job(1), job(2), job(3), job(4) };
+	run_queue first;
+	first.push_back(jobs[0]);
+	first.push_back(jobs[4]);
+	run_queue second(jobs.begin() + 1, jobs.begin() + 4);
+
+	first.splice(first.iterator_to(jobs[4]), second);
+	EXPECT_TRUE(second.empty());
+	EXPECT_EQ(first.size(), 5u);
+	EXPECT_EQ(ids(first), (std::vector<int>{ 0, 1, 2, 3, 4 }));
+	EXPECT_EQ(ids_backwards(first), (std::vector<int>{ 4, 3, 2, 1, 0 }));
+
+	run_queue third;
+	third.splice(third.end(), first);
+	EXPECT_EQ(ids(third), (std::vector<int>{ 0, 1, 2, 3, 4 }));
+	EXPECT_EQ(&third.back(), &jobs[4]);
+}
+
+TEST_F(intrusive_list_test, reverse_and_remove) {
+	std::vector<job> jobs{ job(1), job(2), job(1), job(3) };
+	run_queue queue(jobs.begin(), jobs.end());
+	queue.reverse();
+	EXPECT_EQ(ids(queue), (std::vector<int>{ 3, 1, 2, 1 }));
+	EXPECT_EQ(ids_backwards(queue), (std::vector<int>{ 1, 2, 1, 3 }));
+
+	EXPECT_EQ(queue.remove(job(1)), 2u);
+	EXPECT_EQ(ids(queue), (std::vector<int>{ 3, 2 }));
+	EXPECT_EQ(&queue.back(), &jobs[1]);
+}
+
+TEST_F(intrusive_list_test, clear_and_destructor_unlink_every_object) {
+	std::vector<job> jobs{ job(0), job(1), job(2) };
+	{
+		run_queue queue(jobs.begin(), jobs.end());
+		queue.clear();
+		EXPECT_TRUE(queue.empty());
+		for (const job& j : jobs) {
+			EXPECT_EQ(j.queued.next, nullptr);
+			EXPECT_EQ(j.queued.prior, nullptr);
+		}
+		queue.push_back(jobs[0]);
+		queue.push_back(jobs[1]);
+	}
+	EXPECT_EQ(jobs[0].queued.next, nullptr);
+	EXPECT_EQ(jobs[1].queued.prior, nullptr);
+	run_queue again(jobs.begin(), jobs.end());
+	EXPECT_EQ(again.size(), 3u);
+}
+
+TEST_F(intrusive_list_test, move_hands_the_objects_over) {
+	std::vector<job> jobs{ job(0), job(1), job(2) };
+	run_queue queue(jobs.begin(), jobs.end());
+	run_queue moved(std::move(queue));
+	EXPECT_TRUE(queue.empty());
+	EXPECT_EQ(ids(moved), (std::vector<int>{ 0, 1, 2 }));
+
+	std::vector<job> others{ job(7) };
+	run_queue other(others.begin(), others.end());
+	other = std::move(moved);
+	EXPECT_EQ(ids(other), (std::vector<int>{ 0, 1, 2 }));
+	EXPECT_EQ(others[0].queued.next, nullptr);  // unlinked by the assignment
+	EXPECT_TRUE(moved.empty());
+}
@@ -1,5 +1,12 @@
 #include "list.hpp"
+#include "counting_resource.hpp"
+#include <algorithm>
+#include <functional>
 #include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
 
 //// debugging
 #include <iostream>
@@ -702,3 +709,379 @@ TEST_F(list_test, pop_back_non_trivial_object) {
 	persons.pop_back();
 	EXPECT_EQ(persons.size(), 0);
 }
+
+TEST_F(list_test, pmr_list_allocates_nodes_from_resource) {
+
+	counting_resource resource;
+	{
+		pmr::list<int> mylist(&resource);
+		mylist.push_back(1);
+		mylist.push_front(0);
+		mylist.emplace_back(2);
+		mylist.insert(mylist.end(), 3);
+		// all four nodes come from the first slab
+		EXPECT_EQ(resource.allocations, 1u);
+		EXPECT_EQ(mylist.get_allocator().resource(), &resource);
+	}
+	EXPECT_EQ(resource.bytes_outstanding, 0u);
+}
+
+TEST_F(list_test, pmr_list_on_monotonic_arena) {
+
+	counting_resource upstream;
+	std::pmr::monotonic_buffer_resource arena(&upstream);
+	{
+		pmr::list<std::pmr::string> mylist(&arena);
+		mylist.emplace_back("a string long enough to need a heap allocation");
+		mylist.push_back(mylist.front());
+		EXPECT_EQ(mylist.back().get_allocator().resource(), &arena);
+	}
+	// nothing handed back until the arena goes
+	EXPECT_EQ(upstream.deallocations, 0u);
+	arena.release();
+	EXPECT_EQ(upstream.bytes_outstanding, 0u);
+}
+
+TEST_F(list_test, pmr_assignment_between_resources_copies_into_own_nodes) {
+
+	counting_resource r1;
+	counting_resource r2;
+	{
+		pmr::list<int> list1({ 1, 2, 3 }, &r1);
+		pmr::list<int> list2(&r2);
+		list2 = list1;
+		EXPECT_EQ(list2.get_allocator().resource(), &r2);
+		EXPECT_EQ(r2.allocations, 1u);
+
+		pmr::list<int> list3(&r2);
+		list3 = std::move(list1);
+		EXPECT_EQ(list3.size(), 3u);
+		EXPECT_EQ(list3.back(), 3);
+		EXPECT_EQ(r2.allocations, 2u);
+	}
+	EXPECT_EQ(r1.bytes_outstanding, 0u);
+	EXPECT_EQ(r2.bytes_outstanding, 0u);
+}
+
+TEST_F(list_test, erased_nodes_are_reused_without_allocating) {
+
+	counting_resource resource;
+	pmr::list<int> mylist(&resource);
+	for (int i = 0; i < 10; ++i) {
+		mylist.push_back(i);
+	}
+	size_t allocations = resource.allocations;
+
+	for (int i = 0; i < 1000; ++i) {
+		mylist.pop_front();
+		mylist.push_back(i);
+		mylist.erase(mylist.begin());
+		mylist.insert(mylist.begin(), i);
+	}
+	EXPECT_EQ(resource.allocations, allocations);
+	EXPECT_EQ(resource.deallocations, 0u);
+	EXPECT_EQ(mylist.size(), 10u);
+}
+
+TEST_F(list_test, clear_releases_whole_slabs) {
+
+	counting_resource resource;
+	pmr::list<int> mylist(&resource);
+	for (int i = 0; i < 1000; ++i) {
+		mylist.push_back(i);
+	}
+	// far fewer slabs than nodes
+	EXPECT_LT(resource.allocations, 10u);
+
+	mylist.clear();
+	EXPECT_EQ(resource.deallocations, resource.allocations);
+	EXPECT_EQ(resource.bytes_outstanding, 0u);
+
+	mylist.push_back(1);
+	EXPECT_EQ(mylist.front(), 1);
+}
+
+TEST_F(list_test, clear_destroys_non_trivial_values) {
+
+	auto shared = std::make_shared<int>(1);
+	list<std::shared_ptr<int>> mylist;
+	for (int i = 0; i < 100; ++i) {
+		mylist.push_back(shared);
+	}
+	EXPECT_EQ(shared.use_count(), 101);
+	mylist.clear();
+	EXPECT_EQ(shared.use_count(), 1);
+}
+
+TEST_F(list_test, insert_middle_links_both_neighbours) {
+
+	list<int> mylist{ 1, 3 };
+	auto it = mylist.begin();
+	++it;
+	mylist.insert(it, 2);
+	EXPECT_EQ(mylist.size(), 3u);
+	EXPECT_TRUE(mylist == list<int>({ 1, 2, 3 }));
+
+	// 3's prior link must now point back at 2
+	auto last = mylist.begin();
+	++last;
+	++last;
+	--last;
+	EXPECT_EQ(*last, 2);
+}
+
+TEST_F(list_test, spliced_nodes_outlive_source_list) {
+
+	list<int> list1{ 1, 2 };
+	{
+		list<int> list2{ 3, 4 };
+		list1.splice(list1.end(), list2);
+	}
+	// list2's pool is gone but its nodes were handed over with the splice
+	EXPECT_EQ(list1.size(), 4u);
+	EXPECT_EQ(list1.back(), 4);
+	list1.pop_back();
+	list1.push_back(5);
+	EXPECT_TRUE(list1 == list<int>({ 1, 2, 3, 5 }));
+}
+
+TEST_F(list_test, splice_reuses_other_pools_spare_slots) {
+
+	counting_resource resource;
+	pmr::list<int> list1(&resource);
+	pmr::list<int> list2(&resource);
+	list1.push_back(0);
+	for (int i = 0; i < 10; ++i) {
+		list2.push_back(i);
+	}
+	for (int i = 0; i < 5; ++i) {
+		list2.pop_front();
+	}
+	size_t allocations = resource.allocations;
+	EXPECT_EQ(allocations, 2u);
+
+	// list1's slab has 31 slots left, list2's 5 erased and 22 never used
+	list1.splice(list1.end(), list2);
+	for (int i = 0; i < 31 + 5 + 22; ++i) {
+		list1.push_back(i);
+	}
+	EXPECT_EQ(resource.allocations, allocations);
+	list1.push_back(-1);
+	EXPECT_EQ(resource.allocations, allocations + 1);
+	EXPECT_EQ(list1.size(), 1u + 5u + 58u + 1u);
+	EXPECT_EQ(list1.back(), -1);
+}
+
+TEST_F(list_test, sort_matches_std_sort_for_every_size) {
+
+	std::mt19937 rng(3);
+	for (size_t count = 0; count < 70; ++count) {
+		std::vector<int> values(count);
+		for (int& v : values) {
+			v = static_cast<int>(rng() % 20);
+		}
+		list<int> mylist(values.begin(), values.end());
+		mylist.sort();
+		std::sort(values.begin(), values.end());
+		ASSERT_TRUE(std::equal(mylist.begin(), mylist.end(), values.begin(), values.end()));
+		ASSERT_EQ(mylist.size(), count);
+	}
+}
+
+TEST_F(list_test, sort_relinks_prior_and_tail) {
+
+	list<int> mylist{ 5, 3, 9, 1, 7 };
+	mylist.sort(std::greater<>());
+	EXPECT_EQ(mylist.front(), 9);
+	EXPECT_EQ(mylist.back(), 1);
+
+	std::vector<int> backwards;
+	auto it = mylist.begin();
+	for (size_t i = 1; i < mylist.size(); ++i) {
+		++it;
+	}
+	for (; it != mylist.end(); --it) {
+		backwards.push_back(*it);
+	}
+	EXPECT_EQ(backwards, (std::vector<int>{ 1, 3, 5, 7, 9 }));
+
+	mylist.push_back(0);
+	mylist.push_front(10);
+	EXPECT_TRUE(mylist == list<int>({ 10, 9, 7, 5, 3, 1, 0 }));
+}
+
+TEST_F(list_test, sort_is_stable_and_keeps_nodes) {
+
+	counting_resource resource;
+	pmr::list<std::pair<int, int>> mylist(&resource);
+	std::vector<std::pair<int, int>> values;
+	std::mt19937 rng(5);
+	for (int i = 0; i < 1000; ++i) {
+		values.emplace_back(static_cast<int>(rng() % 10), i);
+		mylist.push_back(values.back());
+	}
+	auto first = mylist.begin();
+	std::pair<int, int>* first_value = &*first;
+	size_t allocations = resource.allocations;
+
+	auto by_key = [](const auto& a, const auto& b) { return a.first < b.first; };
+	mylist.sort(by_key);
+	std::stable_sort(values.begin(), values.end(), by_key);
+	EXPECT_TRUE(std::equal(mylist.begin(), mylist.end(), values.begin(), values.end()));
+
+	// nothing allocated, and the iterator still points at the same value
+	EXPECT_EQ(resource.allocations, allocations);
+	EXPECT_EQ(&*first, first_value);
+	EXPECT_EQ(first->second, 0);
+}
+
+TEST_F(list_test, merge_relinks_other_nodes_in_order) {
+
+	list<std::pair<int, char>> list1{ { 1, 'a' }, { 3, 'a' }, { 5, 'a' } };
+	{
+		list<std::pair<int, char>> list2{ { 0, 'b' }, { 3, 'b' }, { 4, 'b' }, { 9, 'b' } };
+		list1.merge(list2, [](const auto& a, const auto& b) { return a.first < b.first; });
+		EXPECT_TRUE(list2.empty());
+		EXPECT_EQ(list2.begin(), list2.end());
+	}
+	// list2's pool is gone but its nodes were handed over with the merge
+	std::vector<std::pair<int, char>> expected{ { 0, 'b' }, { 1, 'a' }, { 3, 'a' }, { 3, 'b' },
+	                                            { 4, 'b' }, { 5, 'a' }, { 9, 'b' } };
+	EXPECT_TRUE(std::equal(list1.begin(), list1.end(), expected.begin(), expected.end()));
+	EXPECT_EQ(list1.size(), 7u);
+	EXPECT_EQ(list1.back().first, 9);
+	list1.pop_back();
+	EXPECT_EQ(list1.back().first, 5);
+
+	list<int> empty;
+	list<int> some{ 1, 2 };
+	empty.merge(some);
+	EXPECT_TRUE(empty == list<int>({ 1, 2 }));
+	empty.merge(empty);
+	EXPECT_EQ(empty.size(), 2u);
+}
+
+TEST_F(list_test, unique_erases_runs_of_equal_values) {
+
+	list<int> mylist{ 1, 1, 2, 3, 3, 3, 1, 4, 4 };
+	EXPECT_EQ(mylist.unique(), 4u);
+	EXPECT_TRUE(mylist == list<int>({ 1, 2, 3, 1, 4 }));
+	EXPECT_EQ(mylist.back(), 4);
+
+	// within one of the first of the run
+	list<int> close{ 1, 2, 3, 6, 7, 10 };
+	EXPECT_EQ(close.unique([](int a, int b) { return b - a <= 1; }), 2u);
+	EXPECT_TRUE(close == list<int>({ 1, 3, 6, 10 }));
+
+	list<int> empty;
+	EXPECT_EQ(empty.unique(), 0u);
+}
+
+TEST_F(list_test, prefetched_walk_sees_every_value_in_order) {
+
+	list<int> mylist;
+	for (int i = 0; i < 100; ++i) {
+		mylist.push_back(i);
+	}
+	for (auto& v : mylist.prefetched(4)) {
+		v *= 2;
+	}
+	std::vector<int> seen;
+	for (int v : mylist.prefetched()) {
+		seen.push_back(v);
+	}
+	ASSERT_EQ(seen.size(), 100u);
+	for (int i = 0; i < 100; ++i) {
+		EXPECT_EQ(seen[i], i * 2);
+	}
+
+	// further ahead than the list is long, and nothing at all
+	list<int> few{ 1, 2 };
+	EXPECT_EQ(std::distance(few.prefetched(16).begin(), few.prefetched(16).end()), 2);
+	list<int> none;
+	EXPECT_EQ(none.prefetched().begin(), none.prefetched().end());
+}
+
+TEST_F(list_test, compact_lays_nodes_out_in_list_order) {
+
+	counting_resource resource;
+	{
+		pmr::list<std::string> mylist(&resource);
+		std::vector<std::string> values;
+		std::mt19937 rng(9);
+		for (int i = 0; i < 500; ++i) {
+			values.push_back("value " + std::to_string(rng() % 1000));
+			mylist.push_back(values.back());
+		}
+		// scatter the nodes - their order in memory no longer matches the list
+		mylist.sort();
+		std::sort(values.begin(), values.end());
+
+		mylist.compact();
+		EXPECT_TRUE(std::equal(mylist.begin(), mylist.end(), values.begin(), values.end()));
+		EXPECT_EQ(mylist.size(), values.size());
+		EXPECT_EQ(mylist.back(), values.back());
+
+		// each node straight after the one before
+		const std::string* previous = nullptr;
+		size_t node_bytes = 0;
+		for (const std::string& v : mylist) {
+			if (previous) {
+				size_t step = reinterpret_cast<const char*>(&v) - reinterpret_cast<const char*>(previous);
+				if (node_bytes == 0) {
+					node_bytes = step;
+				}
+				ASSERT_EQ(step, node_bytes);
+			}
+			previous = &v;
+		}
+		EXPECT_GE(node_bytes, sizeof(std::string));
+
+		// the old slabs went back, the new nodes are in one
+		EXPECT_EQ(resource.allocations - resource.deallocations, 1u);
+
+		mylist.push_front("first");
+		mylist.pop_back();
+		EXPECT_EQ(mylist.size(), 500u);
+	}
+	EXPECT_EQ(resource.bytes_outstanding, 0u);
+}
+
+namespace {
+
+	// converts from the list's allocator, so a list built with braces from an
+	// allocator would take the initializer_list constructor and hold one of these
+	struct from_allocator {
+		from_allocator(int v) : value(v) {}
+		from_allocator(const std::pmr::polymorphic_allocator<from_allocator>&) : value(-1) {}
+		int value;
+	};
+
+}
+
+TEST_F(list_test, compact_values_constructible_from_the_allocator) {
+
+	counting_resource resource;
+	{
+		pmr::list<from_allocator> mylist(&resource);
+		mylist.push_back(from_allocator(2));
+		mylist.push_back(from_allocator(1));
+		mylist.compact();
+		EXPECT_EQ(mylist.size(), 2u);
+		EXPECT_EQ(mylist.front().value, 2);
+		EXPECT_EQ(mylist.back().value, 1);
+		EXPECT_EQ(mylist.get_allocator().resource(), &resource);
+	}
+	EXPECT_EQ(resource.bytes_outstanding, 0u);
+}
+
+TEST_F(list_test, compact_empty_list) {
+
+	list<int> mylist;
+	mylist.compact();
+	EXPECT_TRUE(mylist.empty());
+	mylist.push_back(1);
+	mylist.compact();
+	EXPECT_EQ(mylist.front(), 1);
+	EXPECT_EQ(mylist.back(), 1);
+}
@@ -0,0 +1,156 @@
+#include "ordered_map.hpp"
+#include "counting_resource.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+//// debugging
+#include <iostream>
+
+#ifdef _WIN32
+#include "detect_leaks.hpp"  // no valgrind on windows
+#endif
+
+#include "gtest/gtest.h"
+
+using namespace wheel;
+
+class map_test : public ::testing::Test {
+protected:
+	void SetUp() override {
+#ifdef _WIN32
+		start_detecting();
+#endif
+	}
+
+	// void TearDown() override {}
+};
+
+TEST_F(map_test, size_zero_with_default_initialised_map) {
+	ordered_map<int, std::string> mymap;
+	EXPECT_EQ(mymap.size(), 0u);
+	EXPECT_TRUE(mymap.empty());
+}
+
+TEST_F(map_test, inserted_value_can_be_retrieved) {
+	ordered_map<int, std::string> mymap;
+	auto result = mymap.insert({ 1, "one" });
+	EXPECT_TRUE(result.second);
+	EXPECT_EQ(result.first->first, 1);
+	EXPECT_EQ(result.first->second, "one");
+
+	auto it = mymap.find(1);
+	EXPECT_EQ(it->second, "one");
+	EXPECT_EQ(mymap.find(2), mymap.end());
+}
+
+TEST_F(map_test, insert_existing_key_keeps_old_value) {
+	ordered_map<int, std::string> mymap;
+	mymap.insert({ 1, "one" });
+	auto result = mymap.insert({ 1, "uno" });
+	EXPECT_FALSE(result.second);
+	EXPECT_EQ(result.first->second, "one");
+	EXPECT_EQ(mymap.size(), 1u);
+}
+
+TEST_F(map_test, subscript_inserts_default_then_assigns) {
+	ordered_map<std::string, int> mymap;
+	EXPECT_EQ(mymap["a"], 0);
+	mymap["a"] = 5;
+	mymap["b"] += 2;
+	EXPECT_EQ(mymap["a"], 5);
+	EXPECT_EQ(mymap.at("b"), 2);
+	EXPECT_EQ(mymap.size(), 2u);
+}
+
+TEST_F(map_test, at_throws_for_missing_key) {
+	ordered_map<int, int> mymap;
+	mymap[1] = 10;
+	EXPECT_EQ(mymap.at(1), 10);
+	EXPECT_THROW(mymap.at(2), std::out_of_range);
+}
+
+TEST_F(map_test, try_emplace_only_builds_value_for_new_key) {
+	ordered_map<int, std::string> mymap;
+	EXPECT_TRUE(mymap.try_emplace(1, 3u, 'x').second);
+	EXPECT_FALSE(mymap.try_emplace(1, 3u, 'y').second);
+	EXPECT_EQ(mymap.at(1), "xxx");
+}
+
+TEST_F(map_test, erase_removes_key) {
+	ordered_map<int, int> mymap;
+	for (int i = 0; i < 100; ++i) {
+		mymap[i] = i * i;
+	}
+	EXPECT_EQ(mymap.erase(50), 1u);
+	EXPECT_EQ(mymap.erase(50), 0u);
+	EXPECT_EQ(mymap.size(), 99u);
+	EXPECT_EQ(mymap.find(50), mymap.end());
+	EXPECT_EQ(mymap.at(51), 51 * 51);
+}
+
+TEST_F(map_test, transparent_lookup_with_string_view) {
+	ordered_map<std::string, int, std::less<>> mymap;
+	mymap["apple"] = 1;
+	mymap["banana"] = 2;
+
+	std::string_view key("banana");
+	EXPECT_EQ(mymap.find(key)->second, 2);
+	EXPECT_EQ(mymap.at(key), 2);
+	EXPECT_EQ(mymap.find(std::string_view("cherry")), mymap.end());
+	EXPECT_EQ(mymap.erase(std::string_view("apple")), 1u);
+	EXPECT_EQ(mymap.size(), 1u);
+}
+
+TEST_F(map_test, pmr_map_keeps_keys_and_values_on_arena) {
+	counting_resource upstream;
+	std::pmr::monotonic_buffer_resource arena(&upstream);
+	{
+		pmr::ordered_map<std::pmr::string, std::pmr::string, std::less<>> mymap(&arena);
+		mymap.try_emplace("a key long enough to allocate its own buffer", "and a value long enough too");
+		auto it = mymap.find(std::string_view("a key long enough to allocate its own buffer"));
+		ASSERT_NE(it, mymap.end());
+		EXPECT_EQ(it->first.get_allocator().resource(), &arena);
+		EXPECT_EQ(it->second.get_allocator().resource(), &arena);
+	}
+	arena.release();
+	EXPECT_EQ(upstream.bytes_outstanding, 0u);
+}
+
+TEST_F(map_test, iteration_is_in_key_order) {
+	ordered_map<int, std::string> mymap;
+	for (int k : { 3, 1, 4, 5, 9, 2, 6 }) {
+		mymap[k] = std::to_string(k);
+	}
+
+	std::vector<int> keys;
+	for (const auto& [key, value] : mymap) {
+		EXPECT_EQ(value, std::to_string(key));
+		keys.push_back(key);
+	}
+	EXPECT_EQ(keys, std::vector<int>({ 1, 2, 3, 4, 5, 6, 9 }));
+
+	std::vector<int> backwards;
+	for (auto it = mymap.rbegin(); it != mymap.rend(); ++it) {
+		backwards.push_back(it->first);
+	}
+	EXPECT_EQ(backwards, std::vector<int>({ 9, 6, 5, 4, 3, 2, 1 }));
+}
+
+TEST_F(map_test, values_can_be_changed_through_iterators) {
+	ordered_map<std::string, int> mymap;
+	mymap["a"] = 1;
+	mymap["b"] = 2;
+	mymap["c"] = 3;
+	for (auto& entry : mymap) {
+		entry.second *= 10;
+	}
+	const auto& cmap = mymap;
+	int total = 0;
+	for (auto it = cmap.begin(); it != cmap.end(); ++it) {
+		total += it->second;
+	}
+	EXPECT_EQ(total, 60);
+	EXPECT_EQ(cmap.at("b"), 20);
+	EXPECT_EQ((--cmap.end())->first, "c");
+}
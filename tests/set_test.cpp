@@ -1,5 +1,14 @@
 #include "ordered_set.hpp"
+#include "counting_resource.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
 #include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
 
 //// debugging
 #include <iostream>
@@ -25,38 +34,38 @@ protected:
 
 TEST_F(set_test, size_zero_with_default_initialised_set) {
 
-	ordered_set mylist;
+	ordered_set<int> mylist;
 	EXPECT_EQ(mylist.size(), 0);
 }
 
 TEST_F(set_test, size_incremented_by_one_after_insert) {
-	ordered_set mylist;
+	ordered_set<int> mylist;
 	mylist.insert(1);
 	EXPECT_EQ(mylist.size(), 1);
 }
 
 TEST_F(set_test, inserted_value_can_be_retrieved) {
-	ordered_set mylist;
+	ordered_set<int> mylist;
 	mylist.insert(1);
 	auto it = mylist.find(1);
 	EXPECT_EQ(*it, 1);
 }
 
 TEST_F(set_test, inserted_value_iterator_returns_correctly) {
-	ordered_set mylist;
+	ordered_set<int> mylist;
 	auto result = mylist.insert(1);
 	EXPECT_EQ(*result.first, 1);
 	EXPECT_EQ(result.second, true);
 }
 
 TEST_F(set_test, find_fails_when_set_is_empty) {
-	ordered_set mylist;
+	ordered_set<int> mylist;
 	auto it = mylist.find(2);
 	EXPECT_EQ(it, mylist.end());
 }
 
 TEST_F(set_test, find_fails_when_value_not_in_set) {
-	ordered_set mylist;
+	ordered_set<int> mylist;
 	mylist.insert(1);
 	auto it = mylist.find(2);
 	EXPECT_EQ(it, mylist.end());
@@ -64,7 +73,7 @@ TEST_F(set_test, find_fails_when_value_not_in_set) {
 
 TEST_F(set_test, clear_causes_size_zero) {
 
-	ordered_set mylist;
+	ordered_set<int> mylist;
 	mylist.insert(1);
 	EXPECT_EQ(mylist.size(), 1);
 	mylist.clear();
@@ -73,7 +82,7 @@ TEST_F(set_test, clear_causes_size_zero) {
 
 TEST_F(set_test, clear_and_start_again_succeeds) {
 
-	ordered_set mylist;
+	ordered_set<int> mylist;
 	mylist.insert(1);
 
 	mylist.clear();
@@ -82,3 +91,702 @@ TEST_F(set_test, clear_and_start_again_succeeds) {
     mylist.insert(3);
     EXPECT_EQ(mylist.size(), 1);
 }
+
+TEST_F(set_test, pmr_set_allocates_nodes_from_resource) {
+
+	counting_resource resource;
+	{
+		pmr::ordered_set<int> myset(&resource);
+		myset.insert(2);
+		myset.insert(1);
+		myset.insert(3);
+		myset.insert(3);
+		// all three nodes come from the first chunk
+		EXPECT_EQ(resource.allocations, 1u);
+		EXPECT_EQ(myset.get_allocator().resource(), &resource);
+		EXPECT_EQ(*myset.find(1), 1);
+	}
+	EXPECT_EQ(resource.bytes_outstanding, 0u);
+}
+
+TEST_F(set_test, clear_releases_whole_chunks) {
+
+	counting_resource resource;
+	pmr::ordered_set<int> myset(&resource);
+	for (int i = 0; i < 1000; ++i) {
+		myset.insert((i * 7919) % 1000);
+	}
+	EXPECT_EQ(myset.size(), 1000u);
+	// far fewer chunks than nodes
+	EXPECT_LT(resource.allocations, 10u);
+
+	myset.clear();
+	EXPECT_EQ(resource.deallocations, resource.allocations);
+	EXPECT_EQ(resource.bytes_outstanding, 0u);
+
+	myset.insert(5);
+	EXPECT_EQ(*myset.find(5), 5);
+}
+
+TEST_F(set_test, sorted_input_does_not_exhaust_stack) {
+
+	// sorted input used to degenerate into a list as deep as the set is big
+	const int count = 20000;
+	ordered_set<int> myset;
+	for (int i = 0; i < count; ++i) {
+		EXPECT_TRUE(myset.insert(i).second);
+	}
+	for (int i = count; i > 0; --i) {
+		EXPECT_FALSE(myset.insert(i - 1).second);
+	}
+	EXPECT_EQ(myset.size(), static_cast<size_t>(count));
+	EXPECT_EQ(*myset.find(count - 1), count - 1);
+	EXPECT_EQ(myset.find(count), myset.end());
+}
+
+TEST_F(set_test, insert_duplicate_returns_existing_element) {
+	ordered_set<int> myset;
+	auto first = myset.insert(4);
+	auto second = myset.insert(4);
+	EXPECT_FALSE(second.second);
+	EXPECT_EQ(second.first, first.first);
+	EXPECT_EQ(myset.size(), 1u);
+}
+
+TEST_F(set_test, erase_removes_only_that_value) {
+	ordered_set<int> myset;
+	for (int i = 0; i < 10; ++i) {
+		myset.insert(i);
+	}
+	EXPECT_EQ(myset.erase(4), 1u);
+	EXPECT_EQ(myset.erase(4), 0u);
+	EXPECT_EQ(myset.size(), 9u);
+	EXPECT_EQ(myset.find(4), myset.end());
+	for (int i = 0; i < 10; ++i) {
+		if (i != 4) {
+			EXPECT_EQ(*myset.find(i), i);
+		}
+	}
+}
+
+TEST_F(set_test, erase_everything_in_mixed_order) {
+	ordered_set<int> myset;
+	const int count = 1000;
+	for (int i = 0; i < count; ++i) {
+		myset.insert((i * 7919) % count);
+	}
+	for (int i = 0; i < count; i += 2) {
+		EXPECT_EQ(myset.erase(i), 1u);
+	}
+	for (int i = count - 1; i > 0; i -= 2) {
+		EXPECT_EQ(myset.erase(i), 1u);
+	}
+	EXPECT_EQ(myset.size(), 0u);
+	EXPECT_EQ(myset.find(1), myset.end());
+
+	myset.insert(1);
+	EXPECT_EQ(*myset.find(1), 1);
+}
+
+TEST_F(set_test, erased_nodes_are_reused_without_allocating) {
+	counting_resource resource;
+	pmr::ordered_set<int> myset(&resource);
+	for (int i = 0; i < 10; ++i) {
+		myset.insert(i);
+	}
+	size_t allocations = resource.allocations;
+	for (int i = 10; i < 1000; ++i) {
+		myset.erase(i - 10);
+		myset.insert(i);
+	}
+	EXPECT_EQ(resource.allocations, allocations);
+	EXPECT_EQ(myset.size(), 10u);
+}
+
+TEST_F(set_test, set_of_64_bit_ids) {
+	ordered_set<std::uint64_t> myset;
+	const std::uint64_t big = 1ull << 40;
+	EXPECT_TRUE(myset.insert(big).second);
+	EXPECT_TRUE(myset.insert(big + 1).second);
+	EXPECT_FALSE(myset.insert(big).second);
+	EXPECT_EQ(*myset.find(big + 1), big + 1);
+	EXPECT_EQ(myset.find(1), myset.end());
+}
+
+TEST_F(set_test, set_of_strings_destroys_keys) {
+	counting_resource resource;
+	{
+		pmr::ordered_set<std::pmr::string> myset(&resource);
+		for (int i = 0; i < 100; ++i) {
+			myset.insert(std::pmr::string("a key long enough to allocate its own buffer ") + std::to_string(i).c_str());
+		}
+		EXPECT_EQ(myset.size(), 100u);
+		EXPECT_EQ(myset.erase("a key long enough to allocate its own buffer 7"), 1u);
+		myset.clear();
+		EXPECT_EQ(resource.bytes_outstanding, 0u);
+	}
+}
+
+TEST_F(set_test, custom_comparator_orders_keys) {
+	// equivalence comes from the comparator, so keys equal ignoring case collide
+	struct case_insensitive {
+		bool operator()(const std::string& a, const std::string& b) const {
+			return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(),
+				[](char x, char y) { return std::tolower(x) < std::tolower(y); });
+		}
+	};
+	ordered_set<std::string, case_insensitive> myset;
+	EXPECT_TRUE(myset.insert("Hello").second);
+	EXPECT_FALSE(myset.insert("HELLO").second);
+	EXPECT_EQ(*myset.find("hello"), "Hello");
+}
+
+TEST_F(set_test, stateful_comparator_is_used) {
+	using compare_fn = bool(*)(int, int);
+	compare_fn greater = [](int a, int b) { return a > b; };
+	ordered_set<int, compare_fn> myset(greater);
+	myset.insert(1);
+	myset.insert(2);
+	EXPECT_EQ(*myset.find(2), 2);
+	EXPECT_EQ(myset.key_comp()(2, 1), true);
+}
+
+TEST_F(set_test, empty_comparator_takes_no_space) {
+	// a function pointer needs storing, std::less does not
+	EXPECT_LT(sizeof(ordered_set<int>), sizeof(ordered_set<int, bool(*)(int, int)>));
+}
+
+TEST_F(set_test, transparent_find_takes_string_view) {
+	ordered_set<std::string, std::less<>> myset;
+	myset.insert("apple");
+	myset.insert("banana");
+	// std::string cannot be implicitly made from a string_view, so this only
+	// compiles because find compares the string_view with the keys directly
+	std::string_view key("banana");
+	EXPECT_EQ(*myset.find(key), "banana");
+	EXPECT_EQ(myset.find(std::string_view("cherry")), myset.end());
+	EXPECT_EQ(myset.erase(std::string_view("apple")), 1u);
+	EXPECT_EQ(myset.size(), 1u);
+}
+
+// small nodes so a few hundred keys give a tree several levels deep
+template< typename Key, typename Compare = std::less<Key> >
+using small_btree_set = ordered_set<Key, Compare, std::allocator<Key>, btree_backend<64>>;
+
+TEST_F(set_test, btree_backend_insert_find_erase) {
+	small_btree_set<int> myset;
+	std::vector<int> keys(2000);
+	std::iota(keys.begin(), keys.end(), 0);
+	std::shuffle(keys.begin(), keys.end(), std::mt19937(7));
+
+	for (int k : keys) {
+		EXPECT_TRUE(myset.insert(k).second);
+	}
+	EXPECT_FALSE(myset.insert(1000).second);
+	EXPECT_EQ(myset.size(), 2000u);
+	for (int k = 0; k < 2000; ++k) {
+		ASSERT_NE(myset.find(k), myset.end());
+		EXPECT_EQ(*myset.find(k), k);
+	}
+	EXPECT_EQ(myset.find(2000), myset.end());
+
+	// erase the odd keys, in a different order to the inserts
+	std::shuffle(keys.begin(), keys.end(), std::mt19937(8));
+	for (int k : keys) {
+		if (k % 2) {
+			EXPECT_EQ(myset.erase(k), 1u);
+		}
+	}
+	EXPECT_EQ(myset.erase(1), 0u);
+	EXPECT_EQ(myset.size(), 1000u);
+	for (int k = 0; k < 2000; ++k) {
+		EXPECT_EQ(myset.find(k) != myset.end(), k % 2 == 0);
+	}
+
+	for (int k = 0; k < 2000; k += 2) {
+		EXPECT_EQ(myset.erase(k), 1u);
+	}
+	EXPECT_EQ(myset.size(), 0u);
+	EXPECT_EQ(myset.find(0), myset.end());
+	EXPECT_TRUE(myset.insert(5).second);
+}
+
+TEST_F(set_test, btree_backend_iterates_in_order) {
+	small_btree_set<int> myset;
+	for (int k = 500; k > 0; --k) {
+		myset.insert(k * 3);
+	}
+	// the iterator from find walks up and down the levels to the next key
+	int expected = 3;
+	for (auto it = myset.find(3); it != myset.end(); ++it) {
+		EXPECT_EQ(*it, expected);
+		expected += 3;
+	}
+	EXPECT_EQ(expected, 1503);
+}
+
+TEST_F(set_test, btree_backend_strings_and_transparent_find) {
+	counting_resource resource;
+	{
+		pmr::ordered_set<std::pmr::string, std::less<>, btree_backend<128>> myset(&resource);
+		for (int i = 0; i < 300; ++i) {
+			myset.insert(std::pmr::string("a key long enough to allocate its own buffer ") + std::to_string(i).c_str());
+		}
+		EXPECT_EQ(myset.size(), 300u);
+		std::string_view key("a key long enough to allocate its own buffer 42");
+		EXPECT_EQ(*myset.find(key), key);
+		for (int i = 0; i < 300; i += 3) {
+			std::string erased = "a key long enough to allocate its own buffer " + std::to_string(i);
+			EXPECT_EQ(myset.erase(std::string_view(erased)), 1u);
+		}
+		EXPECT_EQ(myset.size(), 200u);
+		EXPECT_EQ(myset.find(key), myset.end());
+	}
+	EXPECT_EQ(resource.bytes_outstanding, 0u);
+}
+
+TEST_F(set_test, btree_backend_clear_releases_everything) {
+	counting_resource resource;
+	pmr::ordered_set<int, std::less<int>, btree_backend<>> myset(&resource);
+	for (int i = 0; i < 100000; ++i) {
+		myset.insert(i);
+	}
+	EXPECT_EQ(myset.size(), 100000u);
+	EXPECT_GT(resource.bytes_outstanding, 0u);
+	myset.clear();
+	EXPECT_EQ(myset.size(), 0u);
+	EXPECT_EQ(resource.bytes_outstanding, 0u);
+	myset.insert(1);
+	EXPECT_EQ(*myset.find(1), 1);
+}
+
+TEST_F(set_test, range_for_visits_keys_in_order) {
+	ordered_set<int> myset;
+	std::vector<int> keys(1000);
+	std::iota(keys.begin(), keys.end(), 0);
+	std::shuffle(keys.begin(), keys.end(), std::mt19937(3));
+	for (int k : keys) {
+		myset.insert(k);
+	}
+
+	int expected = 0;
+	for (int k : myset) {
+		EXPECT_EQ(k, expected++);
+	}
+	EXPECT_EQ(expected, 1000);
+	EXPECT_EQ(std::accumulate(myset.begin(), myset.end(), 0), 999 * 1000 / 2);
+	EXPECT_EQ(std::distance(myset.begin(), myset.end()), 1000);
+}
+
+TEST_F(set_test, empty_set_begin_equals_end) {
+	const ordered_set<int> myset;
+	EXPECT_EQ(myset.begin(), myset.end());
+	EXPECT_EQ(myset.rbegin(), myset.rend());
+}
+
+TEST_F(set_test, decrement_from_end_reaches_largest) {
+	ordered_set<int> myset;
+	for (int k : { 5, 1, 9, 3, 7 }) {
+		myset.insert(k);
+	}
+	auto it = myset.end();
+	EXPECT_EQ(*--it, 9);
+	EXPECT_EQ(*--it, 7);
+	it++;
+	EXPECT_EQ(*it, 9);
+	EXPECT_EQ(*std::prev(myset.find(3)), 1);
+}
+
+TEST_F(set_test, reverse_iterators_visit_keys_backwards) {
+	ordered_set<int> myset;
+	for (int k = 0; k < 100; ++k) {
+		myset.insert((k * 37) % 100);
+	}
+	std::vector<int> backwards(myset.rbegin(), myset.rend());
+	std::vector<int> expected(100);
+	std::iota(expected.rbegin(), expected.rend(), 0);
+	EXPECT_EQ(backwards, expected);
+	EXPECT_EQ(*myset.crbegin(), 99);
+}
+
+TEST_F(set_test, ordered_merge_runs_on_the_trees) {
+	ordered_set<int> evens;
+	ordered_set<int> threes;
+	for (int k = 0; k < 30; ++k) {
+		evens.insert(k * 2);
+		threes.insert(k * 3);
+	}
+	std::vector<int> both;
+	std::set_intersection(evens.begin(), evens.end(), threes.begin(), threes.end(), std::back_inserter(both));
+	EXPECT_EQ(both, std::vector<int>({ 0, 6, 12, 18, 24, 30, 36, 42, 48, 54 }));
+
+	std::vector<int> merged;
+	std::merge(evens.cbegin(), evens.cend(), threes.cbegin(), threes.cend(), std::back_inserter(merged));
+	EXPECT_EQ(merged.size(), 60u);
+	EXPECT_TRUE(std::is_sorted(merged.begin(), merged.end()));
+}
+
+TEST_F(set_test, iteration_survives_erase_of_other_keys) {
+	ordered_set<int> myset;
+	for (int k = 0; k < 200; ++k) {
+		myset.insert(k);
+	}
+	for (int k = 0; k < 200; k += 2) {
+		myset.erase(k);
+	}
+	int expected = 1;
+	for (int k : myset) {
+		EXPECT_EQ(k, expected);
+		expected += 2;
+	}
+	EXPECT_EQ(expected, 201);
+}
+
+TEST_F(set_test, btree_backend_iterates_both_ways) {
+	small_btree_set<int> myset;
+	std::vector<int> keys(3000);
+	std::iota(keys.begin(), keys.end(), 0);
+	std::shuffle(keys.begin(), keys.end(), std::mt19937(4));
+	for (int k : keys) {
+		myset.insert(k);
+	}
+	for (int k = 0; k < 3000; k += 3) {
+		myset.erase(k);
+	}
+
+	std::vector<int> expected;
+	for (int k = 0; k < 3000; ++k) {
+		if (k % 3) {
+			expected.push_back(k);
+		}
+	}
+	EXPECT_EQ(std::vector<int>(myset.begin(), myset.end()), expected);
+	std::reverse(expected.begin(), expected.end());
+	EXPECT_EQ(std::vector<int>(myset.rbegin(), myset.rend()), expected);
+	EXPECT_EQ(*--myset.end(), 2999);
+	EXPECT_EQ(*std::prev(myset.find(1000)), 998);
+}
+
+// 0, 10, 20 ... 990
+template< typename Set >
+static void fill_tens(Set& myset) {
+	for (int k = 99; k >= 0; --k) {
+		myset.insert(k * 10);
+	}
+}
+
+template< typename Set >
+static void check_range_queries(Set& myset) {
+	EXPECT_EQ(*myset.lower_bound(20), 20);
+	EXPECT_EQ(*myset.lower_bound(21), 30);
+	EXPECT_EQ(*myset.upper_bound(20), 30);
+	EXPECT_EQ(*myset.lower_bound(-5), 0);
+	EXPECT_EQ(myset.lower_bound(991), myset.end());
+	EXPECT_EQ(myset.upper_bound(990), myset.end());
+
+	auto hit = myset.equal_range(500);
+	EXPECT_EQ(std::distance(hit.first, hit.second), 1);
+	EXPECT_EQ(*hit.first, 500);
+	auto miss = myset.equal_range(505);
+	EXPECT_EQ(miss.first, miss.second);
+	EXPECT_EQ(*miss.first, 510);
+
+	// all keys in [a, b) - only the matching ones are visited
+	std::vector<int> in_range(myset.lower_bound(95), myset.lower_bound(140));
+	EXPECT_EQ(in_range, std::vector<int>({ 100, 110, 120, 130 }));
+	EXPECT_EQ(myset.count_range(95, 140), 4u);
+	EXPECT_EQ(myset.count_range(100, 140), 4u);
+	EXPECT_EQ(myset.count_range(100, 141), 5u);
+	EXPECT_EQ(myset.count_range(140, 95), 0u);
+	EXPECT_EQ(myset.count_range(-100, 5000), 100u);
+
+	EXPECT_EQ(myset.rank(0), 0u);
+	EXPECT_EQ(myset.rank(10), 1u);
+	EXPECT_EQ(myset.rank(15), 2u);
+	EXPECT_EQ(myset.rank(10000), 100u);
+	for (size_t i = 0; i < 100; ++i) {
+		EXPECT_EQ(*myset.select(i), static_cast<int>(i * 10));
+	}
+	EXPECT_EQ(myset.select(100), myset.end());
+}
+
+TEST_F(set_test, range_queries_and_order_statistics) {
+	ordered_set<int> myset;
+	fill_tens(myset);
+	check_range_queries(myset);
+}
+
+TEST_F(set_test, btree_backend_range_queries_and_order_statistics) {
+	small_btree_set<int> myset;
+	fill_tens(myset);
+	check_range_queries(myset);
+}
+
+TEST_F(set_test, order_statistics_follow_erase) {
+	ordered_set<int> myset;
+	small_btree_set<int> bset;
+	for (int k = 0; k < 1000; ++k) {
+		myset.insert(k);
+		bset.insert(k);
+	}
+	for (int k = 0; k < 1000; k += 2) {
+		myset.erase(k);
+		bset.erase(k);
+	}
+	// the odd numbers are left
+	EXPECT_EQ(myset.rank(501), 250u);
+	EXPECT_EQ(bset.rank(501), 250u);
+	EXPECT_EQ(*myset.select(250), 501);
+	EXPECT_EQ(*bset.select(250), 501);
+	EXPECT_EQ(myset.count_range(100, 200), 50u);
+	EXPECT_EQ(bset.count_range(100, 200), 50u);
+}
+
+TEST_F(set_test, empty_set_range_queries) {
+	const ordered_set<int> myset;
+	EXPECT_EQ(myset.lower_bound(1), myset.end());
+	EXPECT_EQ(myset.upper_bound(1), myset.end());
+	EXPECT_EQ(myset.rank(1), 0u);
+	EXPECT_EQ(myset.select(0), myset.end());
+	EXPECT_EQ(myset.count_range(0, 10), 0u);
+}
+
+TEST_F(set_test, transparent_range_queries) {
+	ordered_set<std::string, std::less<>> myset;
+	for (const char* word : { "apple", "banana", "cherry", "damson" }) {
+		myset.insert(word);
+	}
+	EXPECT_EQ(*myset.lower_bound(std::string_view("b")), "banana");
+	EXPECT_EQ(myset.rank(std::string_view("c")), 2u);
+	EXPECT_EQ(myset.count_range(std::string_view("b"), std::string_view("d")), 2u);
+	EXPECT_EQ(myset.count_range(std::string_view("banana"), std::string_view("damson")), 2u);
+	EXPECT_EQ(myset.count_range(std::string_view("d"), std::string_view("b")), 0u);
+}
+
+TEST_F(set_test, range_constructor_from_sorted_input) {
+	std::vector<int> sorted(100000);
+	std::iota(sorted.begin(), sorted.end(), 0);
+	ordered_set<int> myset(sorted.begin(), sorted.end());
+	EXPECT_EQ(myset.size(), 100000u);
+	EXPECT_TRUE(std::equal(myset.begin(), myset.end(), sorted.begin(), sorted.end()));
+	EXPECT_EQ(*myset.select(12345), 12345);
+	EXPECT_EQ(myset.rank(50000), 50000u);
+
+	// the built tree is a normal tree afterwards
+	EXPECT_FALSE(myset.insert(7).second);
+	EXPECT_TRUE(myset.insert(-1).second);
+	EXPECT_EQ(myset.erase(500), 1u);
+	EXPECT_EQ(*myset.select(501), 501);
+	EXPECT_EQ(myset.size(), 100000u);
+}
+
+TEST_F(set_test, bulk_build_takes_its_nodes_in_one_block) {
+	std::vector<int> sorted(100000);
+	std::iota(sorted.begin(), sorted.end(), 0);
+	counting_resource resource;
+	pmr::ordered_set<int> myset(&resource);
+	myset.insert(sorted.begin(), sorted.end());
+	EXPECT_EQ(myset.size(), 100000u);
+	EXPECT_EQ(resource.allocations, 1u);
+}
+
+TEST_F(set_test, range_insert_sorts_and_deduplicates_unsorted_input) {
+	std::vector<int> keys = { 5, 3, 9, 3, 1, 5, 7, 9, 9 };
+	ordered_set<int> myset(keys.begin(), keys.end());
+	EXPECT_EQ(std::vector<int>(myset.begin(), myset.end()), std::vector<int>({ 1, 3, 5, 7, 9 }));
+	EXPECT_EQ(myset.size(), 5u);
+
+	// duplicates in otherwise sorted input are not strictly increasing either
+	std::vector<int> repeats = { 1, 2, 2, 3 };
+	ordered_set<int> other(repeats.begin(), repeats.end());
+	EXPECT_EQ(other.size(), 3u);
+}
+
+TEST_F(set_test, range_insert_from_single_pass_input) {
+	std::istringstream input("4 8 15 16 23 42 8");
+	ordered_set<int> myset{ std::istream_iterator<int>(input), std::istream_iterator<int>() };
+	EXPECT_EQ(std::vector<int>(myset.begin(), myset.end()), std::vector<int>({ 4, 8, 15, 16, 23, 42 }));
+}
+
+TEST_F(set_test, range_insert_into_non_empty_set) {
+	ordered_set<int> myset = { 10, 20, 30 };
+	std::vector<int> more = { 5, 20, 25 };
+	myset.insert(more.begin(), more.end());
+	EXPECT_EQ(std::vector<int>(myset.begin(), myset.end()), std::vector<int>({ 5, 10, 20, 25, 30 }));
+}
+
+TEST_F(set_test, bulk_build_of_strings_with_comparator) {
+	std::vector<std::string> words = { "pear", "apple", "fig", "kiwi" };
+	ordered_set<std::string, std::greater<std::string>> myset(words.begin(), words.end());
+	EXPECT_EQ(std::vector<std::string>(myset.begin(), myset.end()),
+		std::vector<std::string>({ "pear", "kiwi", "fig", "apple" }));
+	// the staging copy is moved from, the caller's range is not
+	EXPECT_EQ(words[1], "apple");
+}
+
+TEST_F(set_test, btree_backend_bulk_build) {
+	for (int count : { 1, 2, 7, 8, 100, 1000, 20000 }) {
+		std::vector<int> sorted(count);
+		std::iota(sorted.begin(), sorted.end(), 0);
+		small_btree_set<int> myset(sorted.begin(), sorted.end());
+		ASSERT_EQ(myset.size(), static_cast<size_t>(count));
+		EXPECT_TRUE(std::equal(myset.begin(), myset.end(), sorted.begin(), sorted.end()));
+		EXPECT_EQ(*myset.select(count / 2), count / 2);
+		EXPECT_EQ(myset.rank(count / 3), static_cast<size_t>(count / 3));
+
+		// and it takes inserts and erases after
+		for (int k = 0; k < count; k += 2) {
+			EXPECT_EQ(myset.erase(k), 1u);
+		}
+		EXPECT_TRUE(myset.insert(count).second);
+		EXPECT_EQ(myset.size(), static_cast<size_t>(count / 2 + 1));
+	}
+}
+
+template< typename Set >
+static Set random_set(size_t count, int range, unsigned seed) {
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> keys(0, range);
+	Set myset;
+	while (myset.size() < count) {
+		myset.insert(keys(rng));
+	}
+	return myset;
+}
+
+template< typename Set >
+static void check_set_algebra(const Set& a, const Set& b) {
+	std::vector<int> first(a.begin(), a.end());
+	std::vector<int> second(b.begin(), b.end());
+	std::vector<int> expected;
+
+	Set u = set_union(a, b);
+	std::set_union(first.begin(), first.end(), second.begin(), second.end(), std::back_inserter(expected));
+	EXPECT_EQ(std::vector<int>(u.begin(), u.end()), expected);
+	ASSERT_EQ(u.size(), expected.size());
+
+	expected.clear();
+	Set i = set_intersection(a, b);
+	std::set_intersection(first.begin(), first.end(), second.begin(), second.end(), std::back_inserter(expected));
+	EXPECT_EQ(std::vector<int>(i.begin(), i.end()), expected);
+	ASSERT_EQ(i.size(), expected.size());
+
+	expected.clear();
+	Set d = set_difference(a, b);
+	std::set_difference(first.begin(), first.end(), second.begin(), second.end(), std::back_inserter(expected));
+	EXPECT_EQ(std::vector<int>(d.begin(), d.end()), expected);
+	ASSERT_EQ(d.size(), expected.size());
+
+	// subtree sizes are right, so order statistics still work
+	for (size_t k = 0; k < expected.size(); k += 1 + expected.size() / 50) {
+		EXPECT_EQ(*d.select(k), expected[k]);
+		EXPECT_EQ(d.rank(expected[k]), k);
+	}
+}
+
+TEST_F(set_test, set_algebra_matches_std_algorithms) {
+	struct sizes { size_t a, b; int range; };
+	for (sizes s : { sizes{ 0, 0, 10 }, sizes{ 0, 100, 1000 }, sizes{ 100, 0, 1000 }, sizes{ 1, 1, 2 },
+	                 sizes{ 1000, 1000, 3000 }, sizes{ 100000, 50, 1000000 }, sizes{ 30, 100000, 200000 },
+	                 sizes{ 100000, 100000, 150000 } }) {
+		ordered_set<int> a = random_set<ordered_set<int>>(s.a, s.range, 1);
+		ordered_set<int> b = random_set<ordered_set<int>>(s.b, s.range, 2);
+		check_set_algebra(a, b);
+	}
+}
+
+TEST_F(set_test, btree_backend_set_algebra) {
+	auto a = random_set<small_btree_set<int>>(5000, 20000, 3);
+	auto b = random_set<small_btree_set<int>>(3000, 20000, 4);
+	check_set_algebra(a, b);
+}
+
+TEST_F(set_test, set_algebra_disjoint_and_nested_ranges) {
+	std::vector<int> low(1000), high(1000);
+	std::iota(low.begin(), low.end(), 0);
+	std::iota(high.begin(), high.end(), 5000);
+	ordered_set<int> a(low.begin(), low.end());
+	ordered_set<int> b(high.begin(), high.end());
+	check_set_algebra(a, b);
+	check_set_algebra(b, a);
+
+	ordered_set<int> inner(low.begin() + 400, low.begin() + 410);
+	check_set_algebra(a, inner);
+	check_set_algebra(inner, a);
+}
+
+TEST_F(set_test, set_algebra_consumes_moved_arguments) {
+	ordered_set<int> a = { 1, 2, 3, 4 };
+	ordered_set<int> b = { 3, 4, 5 };
+	ordered_set<int> kept = set_union(a, b);
+	EXPECT_EQ(a.size(), 4u);
+	EXPECT_EQ(b.size(), 3u);
+
+	ordered_set<int> result = set_difference(std::move(a), std::move(b));
+	EXPECT_EQ(std::vector<int>(result.begin(), result.end()), std::vector<int>({ 1, 2 }));
+	EXPECT_EQ(kept.size(), 5u);
+
+	// the result is an ordinary set, dropped nodes are reused
+	EXPECT_TRUE(result.insert(3).second);
+	EXPECT_TRUE(result.insert(10).second);
+	EXPECT_EQ(std::vector<int>(result.begin(), result.end()), std::vector<int>({ 1, 2, 3, 10 }));
+}
+
+TEST_F(set_test, set_algebra_of_strings_keeps_first_and_frees_the_rest) {
+	// case insensitive, so "Fig" and "fig" are the same key
+	auto less_nocase = [](const std::string& a, const std::string& b) {
+		return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(),
+			[](char x, char y) { return std::tolower(x) < std::tolower(y); });
+	};
+	using nocase_set = ordered_set<std::string, decltype(less_nocase)>;
+	nocase_set a({ "apple", "Fig", "pear" }, less_nocase);
+	nocase_set b({ "fig", "kiwi", "PEAR", "plum" }, less_nocase);
+
+	nocase_set u = set_union(a, b);
+	EXPECT_EQ(std::vector<std::string>(u.begin(), u.end()),
+		std::vector<std::string>({ "apple", "Fig", "kiwi", "pear", "plum" }));
+	nocase_set i = set_intersection(b, a);
+	EXPECT_EQ(std::vector<std::string>(i.begin(), i.end()), std::vector<std::string>({ "fig", "PEAR" }));
+	nocase_set d = set_difference(b, a);
+	EXPECT_EQ(std::vector<std::string>(d.begin(), d.end()), std::vector<std::string>({ "kiwi", "plum" }));
+}
+
+TEST_F(set_test, set_algebra_across_memory_resources) {
+	counting_resource first_resource, second_resource;
+	{
+		pmr::ordered_set<std::pmr::string> a(&first_resource);
+		pmr::ordered_set<std::pmr::string> b(&second_resource);
+		for (int k = 0; k < 200; ++k) {
+			// long enough not to fit in the string itself
+			std::string padding(40, '-');
+			a.insert(std::pmr::string(padding + std::to_string(k)));
+			b.insert(std::pmr::string(padding + std::to_string(k + 100)));
+		}
+		pmr::ordered_set<std::pmr::string> i = set_intersection(std::move(a), std::move(b));
+		EXPECT_EQ(i.size(), 100u);
+		EXPECT_EQ(i.get_allocator().resource(), &first_resource);
+		EXPECT_EQ(second_resource.bytes_outstanding, 0u);
+	}
+	EXPECT_EQ(first_resource.bytes_outstanding, 0u);
+	EXPECT_EQ(second_resource.bytes_outstanding, 0u);
+}
+
+TEST_F(set_test, copy_and_move) {
+	ordered_set<int> original = { 3, 1, 2 };
+	ordered_set<int> copy(original);
+	EXPECT_TRUE(copy.insert(4).second);
+	EXPECT_EQ(original.size(), 3u);
+
+	ordered_set<int> moved(std::move(copy));
+	EXPECT_EQ(std::vector<int>(moved.begin(), moved.end()), std::vector<int>({ 1, 2, 3, 4 }));
+
+	copy = original;
+	EXPECT_EQ(std::vector<int>(copy.begin(), copy.end()), std::vector<int>({ 1, 2, 3 }));
+	original = std::move(moved);
+	EXPECT_EQ(original.size(), 4u);
+
+	small_btree_set<int> b = { 5, 6 };
+	small_btree_set<int> b_copy(b);
+	b = std::move(b_copy);
+	EXPECT_EQ(std::vector<int>(b.begin(), b.end()), std::vector<int>({ 5, 6 }));
+}
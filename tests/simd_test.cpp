@@ -0,0 +1,183 @@
+#include "simd.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#ifdef _WIN32
+#include "detect_leaks.hpp"  // no valgrind on windows
+#endif
+
+#include "gtest/gtest.h"
+
+using namespace wheel;
+
+class simd_test : public ::testing::Test {
+protected:
+	void SetUp() override {
+#ifdef _WIN32
+		start_detecting();
+#endif
+	}
+
+	void TearDown() override {
+		simd::use_level(simd::detected_level());
+	}
+};
+
+namespace {
+
+	// every level this cpu can run, so each kernel is checked, not just the best
+	std::vector<simd::level> levels() {
+		std::vector<simd::level> all{ simd::level::scalar };
+		if (simd::detected_level() >= simd::level::sse4) {
+			all.push_back(simd::level::sse4);
+		}
+		if (simd::detected_level() >= simd::level::avx2) {
+			all.push_back(simd::level::avx2);
+		}
+		return all;
+	}
+
+	// Small whole numbers, so many repeats and exact floating point sums.
+	// Every length up to a few blocks of four registers, at every start
+	// offset in a register, against the standard algorithms.
+	template< typename T >
+	void check_kernels() {
+		std::mt19937 rng(7);
+		std::uniform_int_distribution<int> small(-20, 20);
+		std::vector<T> data(300);
+		for (T& x : data) {
+			x = static_cast<T>(small(rng));
+		}
+		for (simd::level level : levels()) {
+			ASSERT_EQ(simd::use_level(level), level);
+			for (size_t offset = 0; offset < 8; ++offset) {
+				for (size_t length = 0; offset + length <= data.size(); length += 1 + length / 16) {
+					const T* first = data.data() + offset;
+					const T* last = first + length;
+					for (T value : { T(0), T(5), T(19), T(100) }) {
+						EXPECT_EQ(simd::find(first, last, value), std::find(first, last, value)) << length;
+						EXPECT_EQ(simd::count(first, last, value), static_cast<size_t>(std::count(first, last, value))) << length;
+					}
+					EXPECT_EQ(simd::sum(first, last), std::accumulate(first, last, simd::sum_type<T>())) << length;
+					if (length > 0) {
+						EXPECT_EQ(simd::min(first, last), *std::min_element(first, last)) << length;
+						EXPECT_EQ(simd::max(first, last), *std::max_element(first, last)) << length;
+					}
+
+					std::vector<T> copy(first, last);
+					EXPECT_TRUE(simd::equal(first, last, copy.data())) << length;
+					if (length > 0) {
+						// a difference anywhere is seen
+						size_t at = rng() % length;
+						copy[at] = static_cast<T>(copy[at] + 1);
+						EXPECT_FALSE(simd::equal(first, last, copy.data())) << length << " " << at;
+					}
+				}
+			}
+		}
+	}
+
+}
+
+TEST_F(simd_test, int_kernels_match_the_standard_algorithms) {
+	check_kernels<int>();
+}
+
+TEST_F(simd_test, unsigned_kernels_match_the_standard_algorithms) {
+	check_kernels<unsigned>();
+}
+
+TEST_F(simd_test, int64_kernels_match_the_standard_algorithms) {
+	check_kernels<std::int64_t>();
+}
+
+TEST_F(simd_test, uint64_kernels_match_the_standard_algorithms) {
+	check_kernels<std::uint64_t>();
+}
+
+TEST_F(simd_test, float_kernels_match_the_standard_algorithms) {
+	check_kernels<float>();
+}
+
+TEST_F(simd_test, double_kernels_match_the_standard_algorithms) {
+	check_kernels<double>();
+}
+
+TEST_F(simd_test, other_types_use_the_standard_algorithms) {
+	check_kernels<short>();
+	check_kernels<char>();
+}
+
+TEST_F(simd_test, integer_sums_are_64_bit) {
+	const int big = std::numeric_limits<int>::max();
+	const unsigned huge = std::numeric_limits<unsigned>::max();
+	vector<int> ints(size_t(100), big);
+	vector<unsigned> unsigneds(size_t(100), huge);
+	vector<int> negatives(size_t(100), -big);
+	for (simd::level level : levels()) {
+		simd::use_level(level);
+		EXPECT_EQ(simd::sum(ints), 100LL * big);
+		EXPECT_EQ(simd::sum(unsigneds), 100ULL * huge);
+		EXPECT_EQ(simd::sum(negatives), -100LL * big);
+	}
+}
+
+TEST_F(simd_test, extremes_of_the_range_of_the_type) {
+	for (simd::level level : levels()) {
+		simd::use_level(level);
+		vector<std::uint64_t> v(size_t(40), 1);
+		v[3] = std::numeric_limits<std::uint64_t>::max();
+		v[37] = 0;
+		EXPECT_EQ(simd::max(v), std::numeric_limits<std::uint64_t>::max());
+		EXPECT_EQ(simd::min(v), 0u);
+
+		vector<float> f(size_t(40), 0.5f);
+		f[20] = -std::numeric_limits<float>::infinity();
+		f[39] = std::numeric_limits<float>::max();
+		EXPECT_EQ(simd::min(f), -std::numeric_limits<float>::infinity());
+		EXPECT_EQ(simd::max(f), std::numeric_limits<float>::max());
+	}
+}
+
+TEST_F(simd_test, floating_point_equality_is_by_value) {
+	// -0 equals 0, NaN equals nothing, as for ==
+	const double nan = std::numeric_limits<double>::quiet_NaN();
+	vector<double> zeros(size_t(50), 0.0);
+	vector<double> negative_zeros(size_t(50), -0.0);
+	vector<double> nans(size_t(50), nan);
+	for (simd::level level : levels()) {
+		simd::use_level(level);
+		EXPECT_TRUE(simd::equal(zeros, negative_zeros));
+		EXPECT_FALSE(simd::equal(nans, nans));
+		EXPECT_EQ(simd::find(nans, nan), nans.end());
+		EXPECT_EQ(simd::count(negative_zeros, 0.0), 50u);
+	}
+}
+
+TEST_F(simd_test, vector_overloads) {
+	vector<int> v{ 4, 8, 15, 16, 23, 42 };
+	vector<int> same{ 4, 8, 15, 16, 23, 42 };
+	vector<int> shorter{ 4, 8, 15 };
+	EXPECT_EQ(simd::find(v, 16), v.begin() + 3);
+	EXPECT_EQ(simd::find(v, 17), v.end());
+	EXPECT_EQ(simd::count(v, 42), 1u);
+	EXPECT_EQ(simd::min(v), 4);
+	EXPECT_EQ(simd::max(v), 42);
+	EXPECT_EQ(simd::sum(v), 108);
+	EXPECT_TRUE(simd::equal(v, same));
+	EXPECT_FALSE(simd::equal(v, shorter));
+
+	vector<long> longs{ 1, 2, 3 };
+	EXPECT_EQ(simd::find(longs, 2), longs.begin() + 1);   // int value, long elements
+}
+
+TEST_F(simd_test, use_level_is_capped_at_the_detected_level) {
+	EXPECT_EQ(simd::active_level(), simd::detected_level());
+	EXPECT_EQ(simd::use_level(simd::level::avx2), simd::detected_level());
+	EXPECT_EQ(simd::use_level(simd::level::scalar), simd::level::scalar);
+	EXPECT_EQ(simd::active_level(), simd::level::scalar);
+}
@@ -0,0 +1,121 @@
+#include "static_index.hpp"
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include "detect_leaks.hpp"  // no valgrind on windows
+#endif
+
+#include "gtest/gtest.h"
+
+using namespace wheel;
+
+class static_index_test : public ::testing::Test {
+protected:
+	void SetUp() override {
+#ifdef _WIN32
+		start_detecting();
+#endif
+	}
+
+	// void TearDown() override {}
+};
+
+TEST_F(static_index_test, empty_index_finds_nothing) {
+	static_index<int> index(vector<int>{});
+	EXPECT_TRUE(index.empty());
+	EXPECT_FALSE(index.contains(0));
+	EXPECT_EQ(index.lower_bound(0), nullptr);
+}
+
+TEST_F(static_index_test, lower_bound_agrees_with_sorted_search_for_every_size) {
+	// every size up to a few full levels, so every shape of last level
+	for (int count = 1; count <= 70; ++count) {
+		std::vector<int> sorted(count);
+		for (int k = 0; k < count; ++k) {
+			sorted[k] = 2 * k + 1;
+		}
+		std::vector<int> shuffled(sorted);
+		std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(count));
+		static_index<int> index(vector<int>(shuffled.begin(), shuffled.end()));
+		ASSERT_EQ(index.size(), static_cast<size_t>(count));
+
+		for (int key = -1; key <= 2 * count + 1; ++key) {
+			auto expected = std::lower_bound(sorted.begin(), sorted.end(), key);
+			const int* bound = index.lower_bound(key);
+			if (expected == sorted.end()) {
+				EXPECT_EQ(bound, nullptr) << count << " " << key;
+			}
+			else {
+				ASSERT_NE(bound, nullptr) << count << " " << key;
+				EXPECT_EQ(*bound, *expected);
+			}
+			EXPECT_EQ(index.contains(key), key > 0 && key % 2 == 1 && key < 2 * count) << count << " " << key;
+		}
+	}
+}
+
+TEST_F(static_index_test, find_many_matches_contains) {
+	std::mt19937 rng(3);
+	std::uniform_int_distribution<int> keys(0, 100000);
+	vector<int> input;
+	for (int k = 0; k < 20000; ++k) {
+		input.push_back(keys(rng));
+	}
+	std::vector<int> queries(1001);   // not a whole number of groups
+	for (int& q : queries) {
+		q = keys(rng);
+	}
+	static_index<int> index(std::move(input));
+
+	std::vector<const int*> results(queries.size());
+	auto end = index.find_many(queries.begin(), queries.end(), results.begin());
+	EXPECT_EQ(end, results.end());
+	for (size_t i = 0; i < queries.size(); ++i) {
+		EXPECT_EQ(results[i] != nullptr, index.contains(queries[i]));
+		if (results[i]) {
+			EXPECT_EQ(*results[i], queries[i]);
+		}
+	}
+}
+
+TEST_F(static_index_test, duplicates_and_comparator) {
+	static_index<int, std::greater<int>> index(vector<int>{ 5, 1, 5, 9, 3, 9 });
+	EXPECT_EQ(index.size(), 6u);
+	EXPECT_EQ(*index.lower_bound(6), 5);   // descending order, so the next smaller
+	EXPECT_EQ(*index.lower_bound(9), 9);
+	EXPECT_EQ(index.lower_bound(0), nullptr);
+	EXPECT_TRUE(index.contains(3));
+	EXPECT_FALSE(index.contains(4));
+}
+
+TEST_F(static_index_test, transparent_lookup_of_strings) {
+	static_index<std::string, std::less<>> index(vector<std::string>{ "pear", "apple", "fig" });
+	EXPECT_TRUE(index.contains(std::string_view("fig")));
+	EXPECT_FALSE(index.contains("kiwi"));
+	EXPECT_EQ(*index.lower_bound("b"), "fig");
+
+	static_index<std::string, std::less<>> moved(std::move(index));
+	EXPECT_TRUE(moved.contains("pear"));
+	EXPECT_EQ(index.size(), 0u);
+	EXPECT_FALSE(index.contains("pear"));
+}
+
+TEST_F(static_index_test, writes_nothing_to_stdout) {
+	testing::internal::CaptureStdout();
+	{
+		vector<int> keys{ 5, 1, 3 };
+		keys.push_back(7);
+		static_index<int> index(std::move(keys));
+		EXPECT_TRUE(index.contains(7));
+		EXPECT_EQ(*index.lower_bound(2), 3);
+		static_index<int> moved(std::move(index));
+		EXPECT_TRUE(moved.contains(1));
+	}
+	EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+}
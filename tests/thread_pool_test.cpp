@@ -0,0 +1,175 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include "detect_leaks.hpp"  // no valgrind on windows
+#endif
+
+#include "gtest/gtest.h"
+
+using namespace wheel;
+
+class thread_pool_test : public ::testing::Test {
+protected:
+	void SetUp() override {
+#ifdef _WIN32
+		start_detecting();
+#endif
+	}
+
+	// void TearDown() override {}
+};
+
+TEST_F(thread_pool_test, parallel_for_visits_every_index_once) {
+	thread_pool pool(3);
+	EXPECT_EQ(pool.size(), 3u);
+	std::vector<std::atomic<int>> visits(10007);
+	pool.parallel_for(0, visits.size(), [&](size_t begin, size_t end) {
+		EXPECT_LE(end - begin, 100u);
+		for (size_t i = begin; i != end; ++i) {
+			++visits[i];
+		}
+	}, 100);
+	for (auto& v : visits) {
+		ASSERT_EQ(v.load(), 1);
+	}
+}
+
+TEST_F(thread_pool_test, parallel_for_with_default_grain_covers_uneven_work) {
+	thread_pool pool(4);
+	std::vector<std::atomic<int>> visits(5000);
+	pool.parallel_for(0, visits.size(), [&](size_t begin, size_t end) {
+		for (size_t i = begin; i != end; ++i) {
+			// the last few indexes are far more work than the rest
+			if (i > 4900) {
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+			}
+			++visits[i];
+		}
+	});
+	for (auto& v : visits) {
+		ASSERT_EQ(v.load(), 1);
+	}
+}
+
+TEST_F(thread_pool_test, parallel_for_empty_and_offset_ranges) {
+	thread_pool pool(2);
+	pool.parallel_for(5, 5, [](size_t, size_t) { FAIL(); });
+	std::atomic<size_t> total(0);
+	pool.parallel_for(1000, 3000, [&](size_t begin, size_t end) {
+		EXPECT_GE(begin, 1000u);
+		EXPECT_LE(end, 3000u);
+		total += end - begin;
+	}, 7);
+	EXPECT_EQ(total.load(), 2000u);
+}
+
+TEST_F(thread_pool_test, parallel_for_nests) {
+	thread_pool pool(2);
+	std::atomic<int> total(0);
+	pool.parallel_for(0, 8, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i != end; ++i) {
+			pool.parallel_for(0, 100, [&](size_t b, size_t e) {
+				total += static_cast<int>(e - b);
+			}, 10);
+		}
+	}, 1);
+	EXPECT_EQ(total.load(), 800);
+}
+
+TEST_F(thread_pool_test, parallel_for_rethrows) {
+	thread_pool pool(4);
+	std::atomic<int> ran(0);
+	EXPECT_THROW(pool.parallel_for(0, 64, [&](size_t begin, size_t) {
+		++ran;
+		if (begin == 17) {
+			throw std::runtime_error("piece 17");
+		}
+	}, 1), std::runtime_error);
+	EXPECT_GE(ran.load(), 18);
+	EXPECT_LE(ran.load(), 64);
+}
+
+TEST_F(thread_pool_test, submit_returns_result_through_future) {
+	thread_pool pool(2);
+	std::future<int> sum = pool.submit([](int a, int b) { return a + b; }, 20, 22);
+	std::future<std::string> text = pool.submit([] { return std::string("wheel"); });
+	EXPECT_EQ(sum.get(), 42);
+	EXPECT_EQ(text.get(), "wheel");
+}
+
+TEST_F(thread_pool_test, submit_takes_move_only_arguments) {
+	thread_pool pool(1);
+	auto value = std::make_unique<int>(7);
+	auto result = pool.submit([](std::unique_ptr<int> p) { return *p * 2; }, std::move(value));
+	EXPECT_EQ(result.get(), 14);
+}
+
+TEST_F(thread_pool_test, submit_delivers_exception_through_future) {
+	thread_pool pool(2);
+	auto failed = pool.submit([] { throw std::logic_error("no"); });
+	EXPECT_THROW(failed.get(), std::logic_error);
+}
+
+TEST_F(thread_pool_test, many_submits_from_outside_and_inside_the_pool) {
+	thread_pool pool(4);
+	std::atomic<int> count(0);
+	std::vector<std::future<void>> outer;
+	for (int i = 0; i < 200; ++i) {
+		outer.push_back(pool.submit([&pool, &count] {
+			++count;
+			// queued on this worker's own deque, where others can steal it
+			pool.submit([&count] { ++count; });
+		}));
+	}
+	for (auto& f : outer) {
+		f.get();
+	}
+	// the inner tasks have no future to wait on - the destructor runs them
+	while (count.load() < 400) {
+		std::this_thread::yield();
+	}
+	EXPECT_EQ(count.load(), 400);
+}
+
+TEST_F(thread_pool_test, destructor_runs_queued_tasks) {
+	std::atomic<int> count(0);
+	{
+		thread_pool pool(2);
+		for (int i = 0; i < 1000; ++i) {
+			pool.submit([&count] { ++count; });
+		}
+	}
+	EXPECT_EQ(count.load(), 1000);
+}
+
+TEST_F(thread_pool_test, deque_grows_past_its_first_ring) {
+	// one worker pushes far more tasks onto its own deque than the first ring holds
+	thread_pool pool(3);
+	std::atomic<int> count(0);
+	auto outer = pool.submit([&pool, &count] {
+		for (int i = 0; i < 5000; ++i) {
+			pool.submit([&count] { ++count; });
+		}
+	});
+	outer.get();
+	while (count.load() < 5000) {
+		std::this_thread::yield();
+	}
+	EXPECT_EQ(count.load(), 5000);
+}
+
+TEST_F(thread_pool_test, shared_pool_is_one_pool) {
+	EXPECT_EQ(&thread_pool::shared(), &thread_pool::shared());
+	EXPECT_GE(thread_pool::shared().size(), 1u);
+	EXPECT_EQ(thread_pool::shared().submit([] { return 5; }).get(), 5);
+}
@@ -0,0 +1,334 @@
+#include "unrolled_list.hpp"
+#include "counting_resource.hpp"
+#include <array>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include "detect_leaks.hpp"  // no valgrind on windows
+#endif
+
+#include "gtest/gtest.h"
+
+using namespace wheel;
+
+// small chunks, so a few values are enough to split and merge them
+template< typename T >
+using small_list = unrolled_list<T, 4>;
+
+template< typename List >
+std::vector<typename List::iterator::value_type> values_of(List& l) {
+	return { l.begin(), l.end() };
+}
+
+// every chunk holds something, and only the first and last may be under half full
+template< typename List >
+bool chunks_are_balanced(List& l) {
+	size_t total = 0;
+	for (auto c = l.begin().chunk_; c; c = c->next) {
+		if (c->count == 0 || c->count > List::chunk_size) {
+			return false;
+		}
+		if (c->count < List::chunk_size / 2 && c->prior && c->next) {
+			return false;
+		}
+		total += c->count;
+	}
+	return total == l.size();
+}
+
+class unrolled_list_test : public ::testing::Test {
+protected:
+	void SetUp() override {
+#ifdef _WIN32
+		start_detecting();
+#endif
+	}
+
+	// void TearDown() override {}
+};
+
+TEST_F(unrolled_list_test, default_chunk_holds_about_256_bytes) {
+	EXPECT_EQ(unrolled_list<int>::chunk_size, 64u);
+	EXPECT_EQ(unrolled_list<char>::chunk_size, 256u);
+	EXPECT_EQ((unrolled_list<std::array<char, 100>>::chunk_size), 8u);
+}
+
+TEST_F(unrolled_list_test, push_back_and_push_front_keep_order) {
+	small_list<int> mylist;
+	for (int i = 5; i < 10; ++i) {
+		mylist.push_back(i);
+	}
+	for (int i = 4; i >= 0; --i) {
+		mylist.push_front(i);
+	}
+	EXPECT_EQ(mylist.size(), 10u);
+	EXPECT_EQ(mylist.front(), 0);
+	EXPECT_EQ(mylist.back(), 9);
+	std::vector<int> expected(10);
+	std::iota(expected.begin(), expected.end(), 0);
+	EXPECT_EQ(values_of(mylist), expected);
+	EXPECT_TRUE(chunks_are_balanced(mylist));
+}
+
+TEST_F(unrolled_list_test, iterates_backwards_from_end) {
+	small_list<int> mylist{ 1, 2, 3, 4, 5, 6, 7 };
+	std::vector<int> backwards;
+	for (auto it = mylist.end(); it != mylist.begin(); ) {
+		--it;
+		backwards.push_back(*it);
+	}
+	EXPECT_EQ(backwards, (std::vector<int>{ 7, 6, 5, 4, 3, 2, 1 }));
+
+	const auto& constant = mylist;
+	auto last = constant.end();
+	--last;
+	EXPECT_EQ(*last, 7);
+}
+
+TEST_F(unrolled_list_test, insert_into_full_chunk_splits_it) {
+	small_list<int> mylist{ 0, 1, 2, 3 };
+	auto it = std::next(mylist.begin(), 3);
+	it = mylist.insert(it, 99);
+	EXPECT_EQ(*it, 99);
+	EXPECT_EQ(*++it, 3);
+	EXPECT_EQ(values_of(mylist), (std::vector<int>{ 0, 1, 2, 99, 3 }));
+	EXPECT_TRUE(chunks_are_balanced(mylist));
+
+	it = mylist.insert(mylist.begin(), -1);
+	EXPECT_EQ(*it, -1);
+	it = mylist.insert(mylist.end(), 100);
+	EXPECT_EQ(*it, 100);
+	EXPECT_EQ(values_of(mylist), (std::vector<int>{ -1, 0, 1, 2, 99, 3, 100 }));
+}
+
+TEST_F(unrolled_list_test, insert_no_existing_values) {
+	small_list<std::string> mylist;
+	auto it = mylist.insert(mylist.end(), "only");
+	EXPECT_EQ(*it, "only");
+	EXPECT_EQ(mylist.size(), 1u);
+	EXPECT_EQ(mylist.front(), mylist.back());
+}
+
+TEST_F(unrolled_list_test, erase_returns_the_following_value_and_merges_chunks) {
+	small_list<int> mylist;
+	for (int i = 0; i < 12; ++i) {
+		mylist.push_back(i);
+	}
+	auto it = std::next(mylist.begin(), 4);
+	it = mylist.erase(it);
+	EXPECT_EQ(*it, 5);
+	it = mylist.erase(it);
+	EXPECT_EQ(*it, 6);
+	it = mylist.erase(it);
+	EXPECT_EQ(*it, 7);
+	EXPECT_EQ(values_of(mylist), (std::vector<int>{ 0, 1, 2, 3, 7, 8, 9, 10, 11 }));
+	EXPECT_TRUE(chunks_are_balanced(mylist));
+
+	it = mylist.erase(std::prev(mylist.end()));
+	EXPECT_EQ(it, mylist.end());
+	while (!mylist.empty()) {
+		mylist.erase(mylist.begin());
+	}
+	EXPECT_EQ(mylist.begin(), mylist.end());
+}
+
+TEST_F(unrolled_list_test, pop_back_and_pop_front) {
+	small_list<std::string> mylist{ "a", "b", "c", "d", "e", "f" };
+	mylist.pop_back();
+	mylist.pop_front();
+	EXPECT_EQ(values_of(mylist), (std::vector<std::string>{ "b", "c", "d", "e" }));
+	while (!mylist.empty()) {
+		mylist.pop_back();
+	}
+	EXPECT_EQ(mylist.size(), 0u);
+	mylist.pop_back();  // nothing to do
+	mylist.push_front("z");
+	EXPECT_EQ(mylist.back(), "z");
+}
+
+TEST_F(unrolled_list_test, matches_std_list_under_random_edits) {
+	std::mt19937 rng(11);
+	small_list<std::string> mine;
+	std::list<std::string> expected;
+	for (int round = 0; round < 20000; ++round) {
+		std::string value = std::to_string(round);
+		size_t where = expected.empty() ? 0 : rng() % (expected.size() + 1);
+		switch (rng() % 6) {
+		case 0:
+			mine.push_back(value);
+			expected.push_back(value);
+			break;
+		case 1:
+			mine.push_front(value);
+			expected.push_front(value);
+			break;
+		case 2:
+		case 3: {
+			auto it = mine.insert(std::next(mine.begin(), where), value);
+			expected.insert(std::next(expected.begin(), where), value);
+			ASSERT_EQ(*it, value);
+			break;
+		}
+		default:
+			if (!expected.empty()) {
+				where = rng() % expected.size();
+				auto it = mine.erase(std::next(mine.begin(), where));
+				auto next = expected.erase(std::next(expected.begin(), where));
+				ASSERT_EQ(it == mine.end(), next == expected.end());
+				if (next != expected.end()) {
+					ASSERT_EQ(*it, *next);
+				}
+			}
+		}
+		ASSERT_EQ(mine.size(), expected.size());
+		if (round % 500 == 0) {
+			ASSERT_TRUE(std::equal(mine.begin(), mine.end(), expected.begin(), expected.end()));
+			ASSERT_TRUE(chunks_are_balanced(mine));
+		}
+	}
+	EXPECT_TRUE(std::equal(mine.begin(), mine.end(), expected.begin(), expected.end()));
+}
+
+TEST_F(unrolled_list_test, insert_value_from_the_same_chunk) {
+	small_list<std::string> mylist{ "a", "b", "c" };
+	mylist.insert(mylist.begin(), mylist.back());
+	EXPECT_EQ(values_of(mylist), (std::vector<std::string>{ "c", "a", "b", "c" }));
+	// the chunk is full, so is split before the value goes in
+	mylist.insert(std::next(mylist.begin()), mylist.back());
+	EXPECT_EQ(values_of(mylist), (std::vector<std::string>{ "c", "c", "a", "b", "c" }));
+}
+
+TEST_F(unrolled_list_test, remove_compacts_what_is_left) {
+	small_list<int> mylist;
+	for (int i = 0; i < 20; ++i) {
+		mylist.push_back(i % 3);
+	}
+	EXPECT_EQ(mylist.remove(0), 7u);
+	EXPECT_EQ(mylist.size(), 13u);
+	for (int v : mylist) {
+		EXPECT_NE(v, 0);
+	}
+	EXPECT_TRUE(chunks_are_balanced(mylist));
+	EXPECT_EQ(mylist.remove(5), 0u);
+	mylist.remove(1);
+	mylist.remove(2);
+	EXPECT_TRUE(mylist.empty());
+	EXPECT_EQ(mylist.begin(), mylist.end());
+}
+
+TEST_F(unrolled_list_test, splice_into_the_middle_of_a_chunk) {
+	small_list<int> list1{ 1, 2, 3, 4 };
+	{
+		small_list<int> list2{ 10, 11, 12, 13, 14 };
+		list1.splice(std::next(list1.begin(), 2), list2);
+		EXPECT_TRUE(list2.empty());
+	}
+	// list2's pool is gone but its chunks were handed over with the splice
+	EXPECT_EQ(values_of(list1), (std::vector<int>{ 1, 2, 10, 11, 12, 13, 14, 3, 4 }));
+	EXPECT_EQ(list1.size(), 9u);
+
+	small_list<int> list3{ 0 };
+	list1.splice(list1.begin(), list3);
+	small_list<int> list4{ 99 };
+	list1.splice(list1.end(), list4);
+	EXPECT_EQ(list1.front(), 0);
+	EXPECT_EQ(list1.back(), 99);
+	list1.pop_back();
+	list1.push_back(5);
+	EXPECT_EQ(list1.size(), 11u);
+}
+
+TEST_F(unrolled_list_test, reverse_reverses_chunks_and_values) {
+	small_list<int> mylist{ 1, 2, 3, 4, 5, 6, 7 };
+	mylist.reverse();
+	EXPECT_EQ(values_of(mylist), (std::vector<int>{ 7, 6, 5, 4, 3, 2, 1 }));
+	mylist.push_back(0);
+	EXPECT_EQ(mylist.back(), 0);
+	small_list<int> empty;
+	empty.reverse();
+	EXPECT_TRUE(empty.empty());
+}
+
+TEST_F(unrolled_list_test, copy_move_and_compare) {
+	small_list<std::string> original{ "a", "b", "c", "d", "e" };
+	small_list<std::string> copy(original);
+	EXPECT_TRUE(copy == original);
+	copy.push_back("f");
+	EXPECT_TRUE(copy != original);
+
+	small_list<std::string> assigned;
+	assigned = original;
+	EXPECT_TRUE(assigned == original);
+
+	small_list<std::string> moved(std::move(copy));
+	EXPECT_EQ(moved.size(), 6u);
+	EXPECT_TRUE(copy.empty());
+
+	assigned = std::move(moved);
+	EXPECT_EQ(assigned.back(), "f");
+
+	swap(assigned, original);
+	EXPECT_EQ(original.size(), 6u);
+	EXPECT_EQ(assigned.size(), 5u);
+}
+
+TEST_F(unrolled_list_test, emplace_builds_in_place) {
+	small_list<std::pair<int, std::string>> mylist;
+	mylist.emplace_back(2, "two");
+	mylist.emplace_front(0, "zero");
+	auto it = mylist.emplace(std::next(mylist.begin()), 1, "one");
+	EXPECT_EQ(it->second, "one");
+	EXPECT_EQ(mylist.back().first, 2);
+}
+
+TEST_F(unrolled_list_test, holds_move_only_values) {
+	small_list<std::unique_ptr<int>> mylist;
+	for (int i = 0; i < 10; ++i) {
+		mylist.push_back(std::make_unique<int>(i));
+	}
+	mylist.insert(std::next(mylist.begin(), 2), std::make_unique<int>(42));
+	mylist.erase(mylist.begin());
+	EXPECT_EQ(*mylist.front(), 1);
+	EXPECT_EQ(**std::next(mylist.begin()), 42);
+}
+
+TEST_F(unrolled_list_test, clear_destroys_non_trivial_values) {
+	auto shared = std::make_shared<int>(1);
+	small_list<std::shared_ptr<int>> mylist;
+	for (int i = 0; i < 100; ++i) {
+		mylist.push_back(shared);
+	}
+	for (int i = 0; i < 30; ++i) {
+		mylist.erase(std::next(mylist.begin(), i));
+	}
+	EXPECT_EQ(shared.use_count(), 71);
+	mylist.clear();
+	EXPECT_EQ(shared.use_count(), 1);
+}
+
+TEST_F(unrolled_list_test, pmr_chunks_come_from_resource_in_slabs) {
+	counting_resource resource;
+	{
+		pmr::unrolled_list<int> mylist(&resource);
+		for (int i = 0; i < 10000; ++i) {
+			mylist.push_back(i);
+		}
+		// 157 chunks of 64, from a few slabs
+		EXPECT_LT(resource.allocations, 10u);
+		EXPECT_EQ(mylist.get_allocator().resource(), &resource);
+
+		size_t allocations = resource.allocations;
+		for (int i = 0; i < 1000; ++i) {
+			mylist.pop_back();
+			mylist.push_back(i);
+		}
+		EXPECT_EQ(resource.allocations, allocations);
+	}
+	EXPECT_EQ(resource.bytes_outstanding, 0u);
+}
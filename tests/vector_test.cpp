@@ -1,5 +1,7 @@
 #include "vector.hpp"
+#include "counting_resource.hpp"
 #include <numeric>
+#include <string>
 
 //// debugging
 #include <iostream>
@@ -227,6 +229,291 @@ TEST_F(vector_test, assignment_elements_added_correctly) {
 	}
 }
 
+// counts special member calls so tests can see what growth does to elements
+struct tracked {
+	static int default_constructed;
+	static int copied;
+	static int moved;
+	static int alive;
+
+	static void reset() { default_constructed = copied = moved = alive = 0; }
+
+	tracked() : value(0) { ++default_constructed; ++alive; }
+	tracked(int v) : value(v) { ++alive; }
+	tracked(const tracked& other) : value(other.value) { ++copied; ++alive; }
+	tracked(tracked&& other) noexcept : value(other.value) { ++moved; ++alive; }
+	tracked& operator=(const tracked& other) { value = other.value; ++copied; return *this; }
+	tracked& operator=(tracked&& other) noexcept { value = other.value; ++moved; return *this; }
+	~tracked() { --alive; }
+
+	int value;
+};
+
+int tracked::default_constructed = 0;
+int tracked::copied = 0;
+int tracked::moved = 0;
+int tracked::alive = 0;
+
+// same as tracked, but moving may throw so growth has to copy
+struct throwing_move : tracked {
+	throwing_move(int v) : tracked(v) {}
+	throwing_move(const throwing_move& other) = default;
+	throwing_move(throwing_move&& other) noexcept(false) : tracked(std::move(other)) {}
+};
+
+TEST_F(vector_test, growth_does_not_default_construct_spare_capacity) {
+
+	tracked::reset();
+	{
+		vector<tracked> v;
+		for (int i = 0; i < 100; ++i) {
+			v.emplace_back(i);
+		}
+		EXPECT_EQ(tracked::default_constructed, 0);
+		EXPECT_EQ(tracked::alive, 100);
+		for (int i = 0; i < 100; ++i) {
+			EXPECT_EQ(v[i].value, i);
+		}
+	}
+	EXPECT_EQ(tracked::alive, 0);
+}
+
+TEST_F(vector_test, growth_moves_when_move_is_noexcept) {
+
+	tracked::reset();
+	vector<tracked> v;
+	for (int i = 0; i < 9; ++i) {
+		v.emplace_back(i);
+	}
+	// 8 elements relocated when the 9th forced a resize, plus the 9th
+	// itself which is built aside and then placed in the new array
+	EXPECT_EQ(tracked::copied, 0);
+	EXPECT_EQ(tracked::moved, 9);
+}
+
+TEST_F(vector_test, growth_copies_when_move_may_throw) {
+
+	tracked::reset();
+	vector<throwing_move> v;
+	for (int i = 0; i < 9; ++i) {
+		v.emplace_back(i);
+	}
+	EXPECT_EQ(tracked::copied, 9);
+	EXPECT_EQ(tracked::moved, 0);
+}
+
+TEST_F(vector_test, pop_back_and_erase_destroy_elements) {
+
+	tracked::reset();
+	vector<tracked> v{ 1, 2, 3, 4 };
+	EXPECT_EQ(tracked::alive, 4);
+
+	v.pop_back();
+	EXPECT_EQ(tracked::alive, 3);
+
+	tracked* next = v.erase(v.begin());
+	EXPECT_EQ(tracked::alive, 2);
+	EXPECT_EQ(next->value, 2);
+	EXPECT_EQ(v.size(), 2u);
+}
+
+TEST_F(vector_test, push_back_own_element_survives_growth) {
+
+	vector<std::string> v;
+	for (int i = 0; i < 8; ++i) {
+		v.push_back(std::to_string(i));
+	}
+	EXPECT_EQ(v.size(), v.capacity());
+
+	v.push_back(v[0]);
+	EXPECT_EQ(v.back(), "0");
+}
+
+// owns a heap int like a unique_ptr, so not trivially copyable, but safe to memcpy
+struct handle {
+	handle(int v) : p(new int(v)) {}
+	handle(handle&& other) noexcept : p(other.p) { other.p = nullptr; ++tracked::moved; }
+	handle& operator=(handle&& other) noexcept { std::swap(p, other.p); ++tracked::moved; return *this; }
+	~handle() { delete p; }
+	int* p;
+};
+
+namespace wheel {
+	template<> struct is_trivially_relocatable<handle> : std::true_type {};
+}
+
+TEST_F(vector_test, relocatable_elements_are_not_moved_on_growth) {
+
+	vector<handle> v;
+	for (int i = 0; i < 8; ++i) {
+		v.emplace_back(i);
+	}
+	EXPECT_EQ(v.size(), v.capacity());
+
+	// the only move is the new element into place, the 8 existing ones are memcpy'd
+	tracked::reset();
+	v.emplace_back(8);
+	EXPECT_EQ(tracked::moved, 1);
+	for (int i = 0; i < 9; ++i) {
+		EXPECT_EQ(*v[i].p, i);
+	}
+}
+
+TEST_F(vector_test, erase_relocatable_element_shifts_tail) {
+
+	vector<handle> v;
+	for (int i = 0; i < 5; ++i) {
+		v.emplace_back(i);
+	}
+	handle* next = v.erase(v.begin() + 1);
+	EXPECT_EQ(*next->p, 2);
+	EXPECT_EQ(v.size(), 4u);
+	EXPECT_EQ(*v[0].p, 0);
+	EXPECT_EQ(*v[3].p, 4);
+}
+
+TEST_F(vector_test, insert_places_element_before_pos) {
+
+	vector<int> v{ 1, 2, 4, 5 };
+	int* inserted = v.insert(v.begin() + 2, 3);
+	EXPECT_EQ(*inserted, 3);
+	EXPECT_EQ(v.size(), 5u);
+	for (int i = 0; i < 5; ++i) {
+		EXPECT_EQ(v[i], i + 1);
+	}
+
+	v.insert(v.begin(), 0);
+	EXPECT_EQ(v.front(), 0);
+	v.insert(v.end(), 6);
+	EXPECT_EQ(v.back(), 6);
+	EXPECT_EQ(v.size(), 7u);
+}
+
+TEST_F(vector_test, insert_non_relocatable_element_shifts_tail) {
+
+	vector<std::string> v{ "a", "c" };
+	v.insert(v.begin() + 1, "b");
+	v.insert(v.begin(), v[2]);
+	ASSERT_EQ(v.size(), 4u);
+	EXPECT_EQ(v[0], "c");
+	EXPECT_EQ(v[1], "a");
+	EXPECT_EQ(v[2], "b");
+	EXPECT_EQ(v[3], "c");
+}
+
+TEST_F(vector_test, insert_relocatable_element_shifts_tail) {
+
+	vector<handle> v;
+	for (int i = 0; i < 8; ++i) {
+		v.emplace_back(i);
+	}
+	v.emplace(v.begin() + 4, 42);
+	ASSERT_EQ(v.size(), 9u);
+	EXPECT_EQ(*v[3].p, 3);
+	EXPECT_EQ(*v[4].p, 42);
+	EXPECT_EQ(*v[5].p, 4);
+	EXPECT_EQ(*v[8].p, 7);
+}
+
+TEST_F(vector_test, inplace_growth_keeps_values_across_resizes) {
+
+	// 4M ints is 16MB, so the buffer passes from realloc to the huge (mremap) path
+	vector<int, std::allocator<int>, inplace_growth> v;
+	const int count = 4 * 1024 * 1024;
+	for (int i = 0; i < count; ++i) {
+		v.push_back(i);
+	}
+	ASSERT_EQ(v.size(), static_cast<size_t>(count));
+	EXPECT_GE(v.capacity() * sizeof(int), inplace_growth::huge_threshold);
+	for (int i = 0; i < count; ++i) {
+		ASSERT_EQ(v[i], i);
+	}
+}
+
+TEST_F(vector_test, inplace_growth_falls_back_for_non_relocatable_types) {
+
+	vector<std::string, std::allocator<std::string>, inplace_growth> v;
+	for (int i = 0; i < 100; ++i) {
+		v.push_back(std::to_string(i));
+	}
+	for (int i = 0; i < 100; ++i) {
+		EXPECT_EQ(v[i], std::to_string(i));
+	}
+}
+
+TEST_F(vector_test, failed_growth_throws_bad_alloc_and_keeps_contents) {
+
+	vector<int, std::allocator<int>, inplace_growth> v{ 1, 2, 3 };
+	EXPECT_THROW(v.reserve(v.max_size()), std::bad_alloc);
+	EXPECT_THROW(v.reserve(v.max_size() + 1), std::bad_alloc);
+	ASSERT_EQ(v.size(), 3u);
+	EXPECT_EQ(v[2], 3);
+
+	vector<int> v2{ 1, 2, 3 };
+	EXPECT_THROW(v2.reserve(v2.max_size() + 1), std::bad_alloc);
+	EXPECT_EQ(v2.size(), 3u);
+}
+
+TEST_F(vector_test, pmr_vector_allocates_from_resource) {
+
+	counting_resource resource;
+	{
+		pmr::vector<int> v(&resource);
+		for (int i = 0; i < 100; ++i) {
+			v.push_back(i);
+		}
+		EXPECT_GT(resource.allocations, 0u);
+		EXPECT_EQ(v.get_allocator().resource(), &resource);
+		EXPECT_EQ(v[99], 99);
+	}
+	EXPECT_EQ(resource.bytes_outstanding, 0u);
+}
+
+TEST_F(vector_test, pmr_vector_passes_arena_to_elements) {
+
+	counting_resource upstream;
+	std::pmr::monotonic_buffer_resource arena(&upstream);
+
+	pmr::vector<std::pmr::string> v(&arena);
+	v.emplace_back("a string long enough to need a heap allocation");
+	v.push_back(v.front());
+	EXPECT_EQ(v[1].get_allocator().resource(), &arena);
+	EXPECT_EQ(v[1], v[0]);
+}
+
+TEST_F(vector_test, pmr_move_assign_between_resources_moves_elements) {
+
+	counting_resource r1;
+	counting_resource r2;
+	{
+		pmr::vector<int> v1({ 1, 2, 3 }, &r1);
+		pmr::vector<int> v2(&r2);
+		v2 = std::move(v1);
+		ASSERT_EQ(v2.size(), 3u);
+		EXPECT_EQ(v2[2], 3);
+		EXPECT_EQ(v2.get_allocator().resource(), &r2);
+
+		pmr::vector<int> v3(v2, &r1);
+		EXPECT_EQ(v3.size(), 3u);
+		v1 = v3;
+		EXPECT_EQ(v1.size(), 3u);
+	}
+	EXPECT_EQ(r1.bytes_outstanding, 0u);
+	EXPECT_EQ(r2.bytes_outstanding, 0u);
+}
+
+TEST_F(vector_test, writes_nothing_to_stdout) {
+
+	testing::internal::CaptureStdout();
+	{
+		vector<int> v;
+		v.push_back(1);
+		vector<int> copy(v);
+		copy.clear();
+	}
+	EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+}
+
 // to test move constructor
 static vector<int> fill(const std::vector<int>& input, int*& ptr) {
 	vector<int> list1;